@@ -0,0 +1,178 @@
+#---------------------------------------------------------
+# Copyright (c) 2014, Sanjay Madhav
+# All rights reserved.
+#
+# This file is distributed under the BSD license.
+# See LICENSE.TXT for details.
+#---------------------------------------------------------
+# Generates synthetic USC programs for benchmarking uscc.
+# Every generated program passes semantic analysis, and
+# its loops all terminate.
+#
+# Usage: python genusc.py [options] > program.usc
+import argparse
+import random
+import sys
+
+# The parameters a program is generated from, with their defaults
+DEFAULTS = {
+	"functions": 10,
+	"statements": 20,
+	"depth": 3,
+	"expr_depth": 3,
+	"vars": 4,
+	"strings": 10,
+	"seed": 1,
+}
+
+class Generator(object):
+
+	def __init__(self, params):
+		self.params = dict(DEFAULTS)
+		self.params.update(params)
+		self.rand = random.Random(self.params["seed"])
+		self.lines = []
+		self.indent = 0
+		self.numLoops = 0
+
+	def emit(self, text):
+		self.lines.append("\t" * self.indent + text)
+
+	def expr(self, scope, depth):
+		# Arithmetic only; relational/logical ops are only used in conditions.
+		# Division is always by a nonzero constant, so constant folding is safe.
+		choice = self.rand.randint(0, 9)
+		if depth <= 0 or choice < 2:
+			if choice % 2 == 0 or not scope:
+				return str(self.rand.randint(0, 99))
+			return self.rand.choice(scope)
+		if choice < 4 and self.funcNum > 0:
+			callee = self.rand.randint(0, self.funcNum - 1)
+			return "f%d(%s, %s)" % (callee, self.expr(scope, depth - 1),
+				self.expr(scope, depth - 1))
+		op = self.rand.choice(["+", "-", "*", "+", "-"])
+		lhs = self.expr(scope, depth - 1)
+		if choice == 9:
+			return "(%s %s %d)" % (lhs, self.rand.choice(["/", "%"]), self.rand.randint(1, 9))
+		return "(%s %s %s)" % (lhs, op, self.expr(scope, depth - 1))
+
+	def cond(self, scope, depth):
+		rel = self.rand.choice(["<", ">", "==", "!="])
+		text = "%s %s %s" % (self.expr(scope, depth), rel, self.expr(scope, depth))
+		if self.rand.randint(0, 3) == 0:
+			text = "(%s) %s (%s < %d)" % (text, self.rand.choice(["&&", "||"]),
+				self.rand.choice(scope), self.rand.randint(0, 99))
+		return text
+
+	# Emits the declarations for a new scope, returning the variables it adds
+	def decls(self, scope, count):
+		added = []
+		for i in range(count):
+			name = "v%d_%d" % (self.indent, i)
+			self.emit("int %s = %s;" % (name, self.expr(scope + added, self.params["expr_depth"])))
+			added.append(name)
+		return added
+
+	# Emits a block of statements, using up to budget[0] statements
+	def block(self, scope, depth, budget):
+		self.emit("{")
+		self.indent += 1
+		scope = scope + self.decls(scope, self.params["vars"])
+		count = 0
+		while budget[0] > 0 and (count == 0 or self.rand.randint(0, 5) != 0):
+			self.stmt(scope, depth, budget)
+			count += 1
+		self.indent -= 1
+		self.emit("}")
+
+	def stmt(self, scope, depth, budget):
+		budget[0] -= 1
+		exprDepth = self.params["expr_depth"]
+		choice = self.rand.randint(0, 9)
+		target = self.rand.choice(scope)
+		if depth > 0 and choice < 2:
+			self.emit("if (%s)" % self.cond(scope, exprDepth))
+			self.block(scope, depth - 1, budget)
+			if self.rand.randint(0, 1):
+				self.emit("else")
+				self.block(scope, depth - 1, budget)
+		elif depth > 0 and choice < 4:
+			# The counter is only changed by the loop itself
+			counter = "i%d" % self.numLoops
+			self.numLoops += 1
+			self.loopCounters.append(counter)
+			self.emit("%s = 0;" % counter)
+			self.emit("while (%s < %d)" % (counter, self.rand.randint(1, 10)))
+			self.emit("{")
+			self.indent += 1
+			self.stmt(scope, depth - 1, budget)
+			self.emit("++%s;" % counter)
+			self.indent -= 1
+			self.emit("}")
+		elif choice < 5:
+			self.emit("++%s;" % target)
+		else:
+			self.emit("%s = %s;" % (target, self.expr(scope, exprDepth)))
+
+	def function(self, num, numStrings):
+		self.funcNum = num
+		self.loopCounters = []
+		self.emit("int f%d(int a, int b)" % num)
+		self.emit("{")
+		self.indent += 1
+
+		# The body is generated first, so its loop counters are known
+		outer = self.lines
+		self.lines = []
+		scope = ["a", "b"] + self.decls(["a", "b"], self.params["vars"])
+		for i in range(numStrings):
+			self.emit("char s%d[] = \"%s\";" % (i, self.stringLiteral()))
+		budget = [self.params["statements"]]
+		while budget[0] > 0:
+			self.stmt(scope, self.params["depth"], budget)
+		self.emit("return %s;" % self.expr(scope, self.params["expr_depth"]))
+		body = self.lines
+		self.lines = outer
+
+		# USC only allows declarations at the start of a block
+		for counter in self.loopCounters:
+			self.emit("int %s;" % counter)
+		self.lines += body
+		self.indent -= 1
+		self.emit("}")
+		self.emit("")
+
+	def stringLiteral(self):
+		letters = "abcdefghijklmnopqrstuvwxyz "
+		return "".join(self.rand.choice(letters) for i in range(self.rand.randint(4, 32)))
+
+	def program(self):
+		self.emit("// Generated by genusc.py with %s" %
+			" ".join("%s=%s" % (k, self.params[k]) for k in sorted(self.params)))
+		self.emit("")
+		numFuncs = max(1, self.params["functions"])
+		for i in range(numFuncs):
+			# Spread the string literals across the functions
+			numStrings = self.params["strings"] // numFuncs
+			if i < self.params["strings"] % numFuncs:
+				numStrings += 1
+			self.function(i, numStrings)
+		self.emit("int main()")
+		self.emit("{")
+		self.emit("\tprintf(\"%%d\\n\", f%d(1, 2));" % (numFuncs - 1))
+		self.emit("\treturn 0;")
+		self.emit("}")
+		return "\n".join(self.lines) + "\n"
+
+def generate(**params):
+	return Generator(params).program()
+
+def main():
+	parser = argparse.ArgumentParser(description="Generates a synthetic USC program.")
+	for name in sorted(DEFAULTS):
+		parser.add_argument("--" + name.replace("_", "-"), type=int, default=DEFAULTS[name])
+	args = parser.parse_args()
+	sys.stdout.write(generate(**vars(args)))
+
+if __name__ == '__main__':
+	main()
@@ -0,0 +1,125 @@
+#---------------------------------------------------------
+# Copyright (c) 2014, Sanjay Madhav
+# All rights reserved.
+#
+# This file is distributed under the BSD license.
+# See LICENSE.TXT for details.
+#---------------------------------------------------------
+# Stress tests uscc on deeply nested programs: parentheses,
+# blocks, ifs, whiles and && chains, up to 100k levels deep.
+# Reports the parse and IR emission times at each depth.
+#
+# In the scopes programs, every block declares a variable and
+# reads one from the function's scope, so the parse time shows
+# whether looking up a name depends on how deep it's used.
+#
+# Every program has to compile, and a program nested one level
+# past the parser's limit has to fail with a clean error
+# (not a crash).
+#
+# Usage: python nesting.py [--uscc ../bin/uscc] [--output results.json]
+import argparse
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+DEPTHS = [1000, 10000, 100000]
+
+# Has to match Parser::MaxNestingDepth
+MAX_DEPTH = 200000
+
+# Returns the statement that nests kind depth levels deep
+def nested(kind, depth):
+	if kind == "parens":
+		return "x = " + "(" * depth + "x" + ")" * depth + ";"
+	if kind == "blocks":
+		return "{" * depth + "x = 2;" + "}" * depth
+	if kind == "ifs":
+		return "if (x) " * depth + "x = 2;"
+	if kind == "whiles":
+		return "while (x) " * depth + "x = 0;"
+	if kind == "scopes":
+		return "{ int y; y = x; " * depth + "}" * depth
+	return "x = " + " && ".join(["x"] * depth) + ";"
+
+KINDS = ["parens", "blocks", "scopes", "ifs", "whiles", "ands"]
+
+def generate(kind, depth):
+	return "int main()\n{\n\tint x = 1;\n\t" + nested(kind, depth) + "\n\treturn x;\n}\n"
+
+def writeSource(workDir, kind, depth):
+	fileName = os.path.join(workDir, "%s%d.usc" % (kind, depth))
+	source = open(fileName, "w")
+	source.write(generate(kind, depth))
+	source.close()
+	return fileName
+
+# Compiles fileName to bitcode, and returns the phase times
+def measure(uscc, fileName):
+	bcFile = fileName.replace(".usc", ".bc")
+	proc = subprocess.Popen([uscc, "-ftime-report", "--report-format", "json",
+		"-o", bcFile, fileName], stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+	out, err = proc.communicate()
+	if proc.returncode != 0:
+		raise RuntimeError(uscc + " failed on " + fileName + ":\n" + err[:1000])
+	report = json.loads(err)
+	return dict((p["name"], p["wall"]) for p in report["phases"])
+
+# A program past the limit should report it, not crash
+def checkLimit(uscc, fileName):
+	proc = subprocess.Popen([uscc, fileName], stdout=subprocess.PIPE,
+		stderr=subprocess.PIPE)
+	out, err = proc.communicate()
+	if proc.returncode != 1 or "Nesting is too deep" not in err:
+		raise RuntimeError(uscc + " didn't reject " + fileName +
+			" (exit code %d)" % proc.returncode)
+
+def main():
+	parser = argparse.ArgumentParser(description="Stress tests uscc on deeply nested programs.")
+	parser.add_argument("--uscc", default="../bin/uscc", help="Path to uscc")
+	parser.add_argument("--output", help="Write the results here instead of stdout")
+	args = parser.parse_args()
+
+	if not os.path.isfile(args.uscc):
+		sys.stderr.write("Can't find " + args.uscc + "\n")
+		return 1
+
+	workDir = tempfile.mkdtemp()
+	results = {}
+	try:
+		for kind in KINDS:
+			results[kind] = {}
+			for depth in DEPTHS:
+				sys.stderr.write("Measuring %s at depth %d...\n" % (kind, depth))
+				phases = measure(args.uscc, writeSource(workDir, kind, depth))
+				results[kind][str(depth)] = {
+					"parse_seconds": phases.get("Parsing and semantic analysis", 0),
+					"emit_seconds": phases.get("IR emission", 0),
+					"total_seconds": sum(phases.values()),
+				}
+			checkLimit(args.uscc, writeSource(workDir, kind, MAX_DEPTH + 1))
+	except RuntimeError as e:
+		sys.stderr.write(str(e) + "\n")
+		return 1
+	finally:
+		shutil.rmtree(workDir)
+
+	for kind in KINDS:
+		deepest = results[kind][str(DEPTHS[-1])]
+		sys.stderr.write("%s at %d: parse %.3fs, emit %.3fs\n" %
+			(kind, DEPTHS[-1], deepest["parse_seconds"], deepest["emit_seconds"]))
+
+	text = json.dumps({"depths": DEPTHS, "kinds": results}, indent=2, sort_keys=True) + "\n"
+	if args.output:
+		out = open(args.output, "w")
+		out.write(text)
+		out.close()
+	else:
+		sys.stdout.write(text)
+	return 0
+
+if __name__ == '__main__':
+	sys.exit(main())
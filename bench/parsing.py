@@ -0,0 +1,122 @@
+#---------------------------------------------------------
+# Copyright (c) 2014, Sanjay Madhav
+# All rights reserved.
+#
+# This file is distributed under the BSD license.
+# See LICENSE.TXT for details.
+#---------------------------------------------------------
+# Measures how parsing scales with --parse-threads on
+# programs with thousands of functions, generated by
+# genusc.py. Reports the parse time and the speedup over
+# a single thread for each thread count.
+#
+# The printed AST has to be the same for every thread count.
+#
+# Usage: python parsing.py [--uscc ../bin/uscc] [--output results.json]
+import argparse
+import json
+import multiprocessing
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+import genusc
+
+FUNCTIONS = [1000, 4000]
+
+def median(values):
+	values = sorted(values)
+	mid = len(values) // 2
+	if len(values) % 2:
+		return values[mid]
+	return (values[mid - 1] + values[mid]) / 2.0
+
+# 1, 2, 4, ... up to the number of hardware threads
+def threadCounts():
+	counts = [1]
+	cores = multiprocessing.cpu_count()
+	while counts[-1] * 2 <= cores:
+		counts.append(counts[-1] * 2)
+	if counts[-1] != cores:
+		counts.append(cores)
+	return counts
+
+def writeSource(workDir, functions):
+	fileName = os.path.join(workDir, "functions%d.usc" % functions)
+	source = open(fileName, "w")
+	source.write(genusc.generate(functions=functions, statements=50))
+	source.close()
+	return fileName
+
+# Parses fileName, and returns the parse time and the printed AST
+def measure(uscc, fileName, threads):
+	proc = subprocess.Popen([uscc, "-a", "-ftime-report", "--report-format", "json",
+		"--parse-threads", str(threads), fileName], stdout=subprocess.PIPE,
+		stderr=subprocess.PIPE)
+	out, err = proc.communicate()
+	if proc.returncode != 0:
+		raise RuntimeError(uscc + " failed on " + fileName + ":\n" + err[:1000])
+	report = json.loads(err)
+	phases = dict((p["name"], p["wall"]) for p in report["phases"])
+	return phases.get("Parsing and semantic analysis", 0), out
+
+def main():
+	parser = argparse.ArgumentParser(description="Measures how parsing scales with threads.")
+	parser.add_argument("--uscc", default="../bin/uscc", help="Path to uscc")
+	parser.add_argument("--repeat", type=int, default=5, help="Parses per thread count")
+	parser.add_argument("--output", help="Write the results here instead of stdout")
+	args = parser.parse_args()
+
+	if not os.path.isfile(args.uscc):
+		sys.stderr.write("Can't find " + args.uscc + "\n")
+		return 1
+
+	counts = threadCounts()
+	workDir = tempfile.mkdtemp()
+	results = {}
+	try:
+		for functions in FUNCTIONS:
+			fileName = writeSource(workDir, functions)
+			results[str(functions)] = {}
+			serialAST = None
+			for threads in counts:
+				sys.stderr.write("Parsing %d functions on %d thread(s)...\n" % (functions, threads))
+				times = []
+				for i in range(args.repeat):
+					seconds, ast = measure(args.uscc, fileName, threads)
+					times.append(seconds)
+					if serialAST is None:
+						serialAST = ast
+					elif ast != serialAST:
+						raise RuntimeError("The AST for %d functions on %d threads is different"
+							% (functions, threads))
+				results[str(functions)][str(threads)] = {"parse_seconds": median(times)}
+	except RuntimeError as e:
+		sys.stderr.write(str(e) + "\n")
+		return 1
+	finally:
+		shutil.rmtree(workDir)
+
+	for functions in FUNCTIONS:
+		byThreads = results[str(functions)]
+		serial = byThreads["1"]["parse_seconds"]
+		for threads in counts:
+			result = byThreads[str(threads)]
+			if result["parse_seconds"] > 0:
+				result["speedup"] = serial / result["parse_seconds"]
+			sys.stderr.write("%d functions on %d thread(s): parse %.3fs (%.2fx)\n" %
+				(functions, threads, result["parse_seconds"], result.get("speedup", 0)))
+
+	text = json.dumps({"threads": counts, "functions": results}, indent=2, sort_keys=True) + "\n"
+	if args.output:
+		out = open(args.output, "w")
+		out.write(text)
+		out.close()
+	else:
+		sys.stdout.write(text)
+	return 0
+
+if __name__ == '__main__':
+	sys.exit(main())
@@ -0,0 +1,157 @@
+#---------------------------------------------------------
+# Copyright (c) 2014, Sanjay Madhav
+# All rights reserved.
+#
+# This file is distributed under the BSD license.
+# See LICENSE.TXT for details.
+#---------------------------------------------------------
+# Measures how fast the code uscc generates runs, with and
+# without -O, on the kernels in kernels/, and writes the
+# results as JSON.
+#
+# Each kernel is compiled to an object file with uscc -c,
+# linked with clang, and run --repeat times. The median run
+# time is reported, along with the number of LLVM instructions
+# in the module and (if perf is installed) the number of
+# instructions executed.
+#
+# The run fails if a kernel prints something different with -O,
+# if -O makes a kernel slower, or if a kernel got slower with -O
+# than in the --baseline results.
+#
+# Usage: python runtime.py [--output results.json] [--baseline old.json]
+import argparse
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+uscc = "../bin/uscc"
+clang = "../../bin/clang"
+
+KERNELS = ["sort", "sieve", "matmul", "strscan", "fib"]
+
+def median(values):
+	values = sorted(values)
+	mid = len(values) // 2
+	if len(values) % 2:
+		return values[mid]
+	return (values[mid - 1] + values[mid]) / 2.0
+
+def haveTool(name):
+	try:
+		subprocess.check_output([name, "--version"], stderr=subprocess.STDOUT)
+		return True
+	except (OSError, subprocess.CalledProcessError):
+		return False
+
+# Returns the number of instructions executed by exe, or None if perf can't count them
+def countInstructions(exe):
+	try:
+		output = subprocess.check_output(["perf", "stat", "-x", ",", "-e", "instructions", exe],
+			stderr=subprocess.STDOUT)
+	except (OSError, subprocess.CalledProcessError):
+		return None
+	for line in output.splitlines():
+		fields = line.split(",")
+		if len(fields) > 2 and fields[2].startswith("instructions") and fields[0].isdigit():
+			return int(fields[0])
+	return None
+
+def measure(kernel, optimize, repeat, workDir, linker, usePerf):
+	flags = ["-O"] if optimize else []
+	base = os.path.join(workDir, kernel + (".O" if optimize else ""))
+	source = os.path.join("kernels", kernel + ".usc")
+
+	# The last phase of the memory report has the size of the final module
+	report = subprocess.check_output([uscc] + flags + ["--mem-report", "--report-format", "json",
+		"-o", base + ".bc", source], stderr=subprocess.STDOUT)
+	irInstrs = json.loads(report)["phases"][-1]["llvm_instructions"]
+
+	subprocess.check_output([uscc] + flags + ["-c", "-o", base + ".o", source],
+		stderr=subprocess.STDOUT)
+	subprocess.check_output([linker, base + ".o", "-o", base], stderr=subprocess.STDOUT)
+
+	times = []
+	output = None
+	for i in range(repeat):
+		start = time.time()
+		output = subprocess.check_output([base], stderr=subprocess.STDOUT)
+		times.append(time.time() - start)
+
+	result = {"seconds": median(times), "ir_instructions": irInstrs, "output": output}
+	if usePerf:
+		executed = countInstructions(base)
+		if executed is not None:
+			result["executed_instructions"] = executed
+	return result
+
+def main():
+	parser = argparse.ArgumentParser(description="Measures the run time of code generated by uscc.")
+	parser.add_argument("--repeat", type=int, default=5, help="Runs per kernel")
+	parser.add_argument("--kernel", action="append", help="Only run this kernel")
+	parser.add_argument("--output", help="Write the results here instead of stdout")
+	parser.add_argument("--baseline", help="Results from an earlier run to compare against")
+	parser.add_argument("--threshold", type=float, default=0.10,
+		help="Slowdown allowed before a regression is reported (default 0.10)")
+	args = parser.parse_args()
+
+	if not os.path.isfile(uscc):
+		sys.stderr.write("Can't run without uscc\n")
+		return 1
+	linker = clang if os.path.isfile(clang) else "cc"
+	usePerf = haveTool("perf")
+
+	failures = []
+	results = {}
+	workDir = tempfile.mkdtemp()
+	try:
+		for kernel in KERNELS:
+			if args.kernel and kernel not in args.kernel:
+				continue
+			sys.stderr.write("Measuring " + kernel + "...\n")
+			plain = measure(kernel, False, args.repeat, workDir, linker, usePerf)
+			optimized = measure(kernel, True, args.repeat, workDir, linker, usePerf)
+			if plain["output"] != optimized["output"]:
+				failures.append("%s: prints something different with -O" % kernel)
+			if optimized["seconds"] > plain["seconds"] * (1.0 + args.threshold):
+				failures.append("%s: -O is slower (%.3fs -> %.3fs)" %
+					(kernel, plain["seconds"], optimized["seconds"]))
+			for result in [plain, optimized]:
+				del result["output"]
+			results[kernel] = {"unoptimized": plain, "optimized": optimized,
+				"speedup": plain["seconds"] / max(optimized["seconds"], 1e-9)}
+	except subprocess.CalledProcessError as e:
+		sys.stderr.write(e.output)
+		return 1
+	finally:
+		shutil.rmtree(workDir)
+
+	text = json.dumps({"kernels": results}, indent=2, sort_keys=True) + "\n"
+	if args.output:
+		out = open(args.output, "w")
+		out.write(text)
+		out.close()
+	else:
+		sys.stdout.write(text)
+
+	if args.baseline:
+		baseline = json.load(open(args.baseline))["kernels"]
+		for kernel, result in results.items():
+			if kernel not in baseline:
+				continue
+			old = baseline[kernel]["optimized"]["seconds"]
+			curr = result["optimized"]["seconds"]
+			if curr > old * (1.0 + args.threshold):
+				failures.append("%s: -O code is %.1f%% slower than the baseline (%.3fs -> %.3fs)" %
+					(kernel, (curr / old - 1.0) * 100, old, curr))
+
+	for msg in failures:
+		sys.stderr.write(msg + "\n")
+	return 1 if failures else 0
+
+if __name__ == '__main__':
+	sys.exit(main())
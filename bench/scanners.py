@@ -0,0 +1,128 @@
+#---------------------------------------------------------
+# Copyright (c) 2014, Sanjay Madhav
+# All rights reserved.
+#
+# This file is distributed under the BSD license.
+# See LICENSE.TXT for details.
+#---------------------------------------------------------
+# Compares the scanning throughput of uscc built with the
+# flex scanner against uscc built with the hand-written one,
+# on programs generated by genusc.py.
+#
+# Both builds also have to print the same AST and count the
+# same tokens, or the run fails.
+#
+# "make bench-scanners" in the root directory builds both and
+# runs this.
+#
+# Usage: python scanners.py [--flex uscc-flex] [--fast uscc-fast] [--output results.json]
+import argparse
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+import genusc
+
+# Scanning is only a small part of a compile, so the
+# files are larger than the throughput.py ones
+CONFIGS = [
+	("many_functions", {"functions": 2000, "statements": 20}),
+	("many_strings", {"functions": 200, "statements": 20, "strings": 40000}),
+	("large_file", {"functions": 400, "statements": 100, "strings": 4000}),
+]
+
+def median(values):
+	values = sorted(values)
+	mid = len(values) // 2
+	if len(values) % 2:
+		return values[mid]
+	return (values[mid - 1] + values[mid]) / 2.0
+
+# Returns the median scanning time, the token count and the printed AST
+def measure(uscc, fileName, repeat):
+	times = []
+	tokens = None
+	ast = None
+	for i in range(repeat):
+		# Lexing on one thread, so the scanners themselves are compared
+		proc = subprocess.Popen([uscc, "-a", "-ftime-report", "--report-format", "json",
+			"--lex-threads", "1", fileName], stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+		out, err = proc.communicate()
+		if proc.returncode != 0:
+			raise RuntimeError(uscc + " failed on " + fileName + ":\n" + err)
+		report = json.loads(err)
+		times += [p["wall"] for p in report["phases"] if p["name"] == "Scanning"]
+		tokens = report["tokens"]
+		ast = out
+	return median(times), tokens, ast
+
+def throughput(seconds, size, tokens):
+	result = {"seconds": seconds}
+	if seconds > 0:
+		result["mb_per_sec"] = size / seconds / (1024 * 1024)
+		result["tokens_per_sec"] = tokens / seconds
+	return result
+
+def main():
+	parser = argparse.ArgumentParser(description="Compares the uscc scanners.")
+	parser.add_argument("--flex", default="uscc-flex", help="uscc built with SCANNER=flex")
+	parser.add_argument("--fast", default="uscc-fast", help="uscc built with SCANNER=fast")
+	parser.add_argument("--repeat", type=int, default=5, help="Compiles per configuration")
+	parser.add_argument("--output", help="Write the results here instead of stdout")
+	args = parser.parse_args()
+
+	for uscc in [args.flex, args.fast]:
+		if not os.path.isfile(uscc):
+			sys.stderr.write("Can't find " + uscc + "\n")
+			return 1
+
+	workDir = tempfile.mkdtemp()
+	results = {}
+	try:
+		for name, params in CONFIGS:
+			sys.stderr.write("Measuring " + name + "...\n")
+			fileName = os.path.join(workDir, name + ".usc")
+			source = open(fileName, "w")
+			source.write(genusc.generate(**params))
+			source.close()
+			size = os.path.getsize(fileName)
+
+			flexTime, flexTokens, flexAST = measure(args.flex, fileName, args.repeat)
+			fastTime, fastTokens, fastAST = measure(args.fast, fileName, args.repeat)
+			if flexTokens != fastTokens or flexAST != fastAST:
+				sys.stderr.write("The scanners disagree on " + name + "\n")
+				return 1
+
+			result = {"params": dict(genusc.DEFAULTS, **params), "bytes": size,
+				"tokens": flexTokens}
+			result["flex"] = throughput(flexTime, size, flexTokens)
+			result["fast"] = throughput(fastTime, size, fastTokens)
+			if fastTime > 0:
+				result["speedup"] = flexTime / fastTime
+			results[name] = result
+	except RuntimeError as e:
+		sys.stderr.write(str(e))
+		return 1
+	finally:
+		shutil.rmtree(workDir)
+
+	for name, result in sorted(results.items()):
+		if "speedup" in result:
+			sys.stderr.write("%s: flex %.1f MB/s, fast %.1f MB/s (%.2fx)\n" %
+				(name, result["flex"].get("mb_per_sec", 0), result["fast"].get("mb_per_sec", 0),
+				result["speedup"]))
+
+	text = json.dumps({"configs": results}, indent=2, sort_keys=True) + "\n"
+	if args.output:
+		out = open(args.output, "w")
+		out.write(text)
+		out.close()
+	else:
+		sys.stdout.write(text)
+	return 0
+
+if __name__ == '__main__':
+	sys.exit(main())
@@ -0,0 +1,156 @@
+#---------------------------------------------------------
+# Copyright (c) 2014, Sanjay Madhav
+# All rights reserved.
+#
+# This file is distributed under the BSD license.
+# See LICENSE.TXT for details.
+#---------------------------------------------------------
+# Measures the throughput of each uscc phase and opt pass
+# on programs generated by genusc.py, and writes the results
+# as JSON.
+#
+# To track regressions, save the results from one commit and
+# pass them to --baseline on the next. Any phase or pass whose
+# throughput dropped by more than --threshold fails the run.
+#
+# Large files are lexed in parallel; run with --lex-threads 1
+# and without to see how scanning scales.
+#
+# Usage: python throughput.py [--output results.json] [--baseline old.json]
+import argparse
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+import genusc
+
+uscc = "../bin/uscc"
+
+# Each configuration scales one dimension of the program
+CONFIGS = [
+	("small", {}),
+	("many_functions", {"functions": 200, "statements": 20}),
+	("long_functions", {"functions": 10, "statements": 1000}),
+	("deep_nesting", {"functions": 20, "statements": 100, "depth": 12}),
+	("deep_expressions", {"functions": 20, "statements": 50, "expr_depth": 8}),
+	("many_variables", {"functions": 20, "statements": 50, "vars": 40}),
+	("many_strings", {"functions": 20, "statements": 20, "strings": 4000}),
+	("large_file", {"functions": 400, "statements": 100, "strings": 4000}),
+]
+
+# The phases with per-line/per-token throughput
+PHASES = ["Scanning", "Parsing and semantic analysis", "IR emission", "Optimization"]
+
+def median(values):
+	values = sorted(values)
+	mid = len(values) // 2
+	if len(values) % 2:
+		return values[mid]
+	return (values[mid - 1] + values[mid]) / 2.0
+
+def throughput(seconds, lines, tokens):
+	result = {"seconds": seconds}
+	if seconds > 0:
+		result["lines_per_sec"] = lines / seconds
+		result["tokens_per_sec"] = tokens / seconds
+	return result
+
+def measure(name, params, repeat, lexThreads, workDir):
+	fileName = os.path.join(workDir, name + ".usc")
+	source = open(fileName, "w")
+	source.write(genusc.generate(**params))
+	source.close()
+
+	reports = []
+	for i in range(repeat):
+		output = subprocess.check_output([uscc, "-O", "-ftime-report", "--report-format", "json",
+			"--lex-threads", str(lexThreads), "-o", os.path.join(workDir, name + ".bc"), fileName],
+			stderr=subprocess.STDOUT)
+		reports.append(json.loads(output))
+
+	lines = reports[0]["lines"]
+	tokens = reports[0]["tokens"]
+	result = {"params": dict(genusc.DEFAULTS, **params), "lines": lines, "tokens": tokens}
+
+	# The median of each phase/pass is taken separately,
+	# so one noisy run doesn't skew the others
+	result["phases"] = {}
+	for phase in PHASES:
+		times = [p["wall"] for r in reports for p in r["phases"] if p["name"] == phase]
+		if times:
+			result["phases"][phase] = throughput(median(times), lines, tokens)
+	result["passes"] = {}
+	for passName in [p["name"] for p in reports[0]["passes"]]:
+		times = [p["wall"] for r in reports for p in r["passes"] if p["name"] == passName]
+		result["passes"][passName] = throughput(median(times), lines, tokens)
+	return result
+
+# Returns a message for every phase/pass that got slower than the baseline
+def compare(results, baseline, threshold):
+	regressions = []
+	for name, result in results.items():
+		if name not in baseline:
+			continue
+		for kind in ["phases", "passes"]:
+			for item, curr in result[kind].items():
+				old = baseline[name][kind].get(item)
+				if not old or "lines_per_sec" not in old or "lines_per_sec" not in curr:
+					continue
+				ratio = curr["lines_per_sec"] / old["lines_per_sec"]
+				if ratio < 1.0 - threshold:
+					regressions.append("%s: %s is %.1f%% slower (%.0f -> %.0f lines/sec)" %
+						(name, item, (1.0 - ratio) * 100, old["lines_per_sec"], curr["lines_per_sec"]))
+	return regressions
+
+def main():
+	parser = argparse.ArgumentParser(description="Measures uscc compile throughput.")
+	parser.add_argument("--repeat", type=int, default=5, help="Compiles per configuration")
+	parser.add_argument("--config", action="append", help="Only run this configuration")
+	parser.add_argument("--lex-threads", type=int, default=0,
+		help="Threads used to lex large files (default 0, one per hardware thread)")
+	parser.add_argument("--output", help="Write the results here instead of stdout")
+	parser.add_argument("--baseline", help="Results from an earlier run to compare against")
+	parser.add_argument("--threshold", type=float, default=0.10,
+		help="Slowdown allowed before a regression is reported (default 0.10)")
+	args = parser.parse_args()
+
+	if not os.path.isfile(uscc):
+		sys.stderr.write("Can't run without uscc\n")
+		return 1
+
+	workDir = tempfile.mkdtemp()
+	try:
+		results = {}
+		for name, params in CONFIGS:
+			if args.config and name not in args.config:
+				continue
+			sys.stderr.write("Measuring " + name + "...\n")
+			results[name] = measure(name, params, args.repeat, args.lex_threads, workDir)
+	except subprocess.CalledProcessError as e:
+		sys.stderr.write(e.output)
+		return 1
+	finally:
+		shutil.rmtree(workDir)
+
+	text = json.dumps({"configs": results}, indent=2, sort_keys=True) + "\n"
+	if args.output:
+		out = open(args.output, "w")
+		out.write(text)
+		out.close()
+	else:
+		sys.stdout.write(text)
+
+	if args.baseline:
+		baseline = json.load(open(args.baseline))["configs"]
+		regressions = compare(results, baseline, args.threshold)
+		for msg in regressions:
+			sys.stderr.write(msg + "\n")
+		if regressions:
+			return 1
+	return 0
+
+if __name__ == '__main__':
+	sys.exit(main())
@@ -31,6 +31,7 @@ namespace opt
 	
 bool ConstantBranch::runOnFunction(Function& F)
 {
+	PassTimer timer(mReport, "ConstantBranch", F);
 	bool changed = false;
     std::set<BranchInst*> removeSet;
     Function::iterator blockIter = F.begin();
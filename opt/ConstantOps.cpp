@@ -31,6 +31,7 @@ namespace opt
 
 /* Constant propagation: Return true if changed in any way */
 bool ConstantOps::runOnFunction(Function& F) {
+	PassTimer timer(mReport, "ConstantOps", F);
 	bool changed = false;
 	
 	// Make a set that contains the instructions we'll remove
@@ -31,6 +31,7 @@ namespace opt
 	
 bool DeadBlocks::runOnFunction(Function& F)
 {
+	PassTimer timer(mReport, "DeadBlocks", F);
     BasicBlock* entry = F.begin();
 	bool changed = false;
     std::set<BasicBlock*> visitedSet;
@@ -0,0 +1,63 @@
+//
+//  JSON.h
+//  uscc
+//
+//  Declares the helper shared by the reports that can be
+//  written as JSON (-ftime-report, --mem-report and the
+//  --batch summary)
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+#pragma once
+#include <string>
+#include <ostream>
+#include <iomanip>
+
+namespace uscc
+{
+namespace opt
+{
+
+// Writes str as a JSON string literal
+inline void writeJSONString(std::ostream& output, const std::string& str)
+{
+	output << '"';
+	for (char c : str)
+	{
+		switch (c)
+		{
+			case '"':
+				output << "\\\"";
+				break;
+			case '\\':
+				output << "\\\\";
+				break;
+			case '\n':
+				output << "\\n";
+				break;
+			case '\t':
+				output << "\\t";
+				break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20)
+				{
+					output << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+						<< static_cast<int>(c) << std::dec << std::setfill(' ');
+				}
+				else
+				{
+					output << c;
+				}
+				break;
+		}
+	}
+	output << '"';
+}
+
+} // opt
+} // uscc
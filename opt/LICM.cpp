@@ -30,6 +30,8 @@ namespace opt
 	
 bool LICM::runOnLoop(llvm::Loop *L, llvm::LPPassManager &LPM)
 {
+    PassTimer timer(mReport, "LICM", *L->getHeader()->getParent());
+    
     // initialize member variables //
     mChanged = false;
     mCurrLoop = L;
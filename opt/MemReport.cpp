@@ -0,0 +1,200 @@
+//
+//  MemReport.cpp
+//  uscc
+//
+//  Implements the class used to collect memory usage and
+//  object counts after each compilation phase
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+#include "MemReport.h"
+#include "JSON.h"
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wconversion"
+#include <llvm/IR/Module.h>
+#pragma clang diagnostic pop
+#include <iomanip>
+
+#if defined(__APPLE__)
+#include <malloc/malloc.h>
+#elif defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace uscc
+{
+namespace opt
+{
+
+namespace
+{
+
+const char* counterNames[MemReport::NumCounters] =
+{
+	"AST nodes",
+	"Identifiers",
+	"Scope tables",
+	"SSA SubMaps",
+	"SSA SubPHIs",
+};
+
+const char* counterKeys[MemReport::NumCounters] =
+{
+	"ast_nodes",
+	"identifiers",
+	"scope_tables",
+	"ssa_submaps",
+	"ssa_subphis",
+};
+
+// Bytes currently allocated from the heap by the whole process
+size_t heapLiveBytes() noexcept
+{
+#if defined(__APPLE__)
+	malloc_statistics_t stats;
+	malloc_zone_statistics(nullptr, &stats);
+	return stats.size_in_use;
+#elif defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+	struct mallinfo2 info = mallinfo2();
+	return info.uordblks + info.hblkhd;
+#elif defined(__GLIBC__)
+	struct mallinfo info = mallinfo();
+	return static_cast<unsigned>(info.uordblks) + static_cast<unsigned>(info.hblkhd);
+#else
+	return 0;
+#endif
+}
+
+// Peak resident set size of the process, in bytes
+size_t peakRSSBytes() noexcept
+{
+#ifdef _WIN32
+	return 0;
+#else
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+	{
+		return 0;
+	}
+#ifdef __APPLE__
+	// Reported in bytes on OS X...
+	return static_cast<size_t>(usage.ru_maxrss);
+#else
+	// ...but in kilobytes everywhere else
+	return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+} // anonymous
+
+thread_local MemReport* MemReport::sActive = nullptr;
+
+MemReport::MemReport(const std::string& fileName)
+: mFileName(fileName)
+{
+	for (size_t& count : mCounts)
+	{
+		count = 0;
+	}
+}
+
+MemReport::~MemReport()
+{
+	if (sActive == this)
+	{
+		sActive = nullptr;
+	}
+}
+
+// Makes this the report that count() adds to on the calling thread
+void MemReport::activate() noexcept
+{
+	sActive = this;
+}
+
+// Records the memory usage and object counts at the end of a phase.
+void MemReport::addPhase(const char* phase, const llvm::Module* module)
+{
+	Snapshot snap;
+	snap.mPhase = phase;
+	snap.mLiveBytes = heapLiveBytes();
+	snap.mPeakBytes = peakRSSBytes();
+	for (int i = 0; i < NumCounters; i++)
+	{
+		snap.mCounts[i] = mCounts[i];
+	}
+
+	snap.mLLVMBlocks = 0;
+	snap.mLLVMInstrs = 0;
+	if (module)
+	{
+		for (auto& func : *module)
+		{
+			for (auto& block : func)
+			{
+				snap.mLLVMBlocks++;
+				snap.mLLVMInstrs += block.size();
+			}
+		}
+	}
+
+	mSnapshots.push_back(snap);
+}
+
+void MemReport::printTable(std::ostream& output) const
+{
+	const char* separator =
+		"===-------------------------------------------------------===\n";
+	output << separator;
+	output << "  Memory report for " << mFileName << "\n";
+	output << separator;
+
+	for (auto& snap : mSnapshots)
+	{
+		output << "After " << snap.mPhase << ":\n";
+		output << "  " << std::setw(12) << snap.mLiveBytes / 1024 << " KB  Live heap\n";
+		output << "  " << std::setw(12) << snap.mPeakBytes / 1024 << " KB  Peak RSS\n";
+		for (int i = 0; i < NumCounters; i++)
+		{
+			output << "  " << std::setw(15) << snap.mCounts[i] << "  " << counterNames[i] << "\n";
+		}
+		output << "  " << std::setw(15) << snap.mLLVMBlocks << "  LLVM basic blocks\n";
+		output << "  " << std::setw(15) << snap.mLLVMInstrs << "  LLVM instructions\n";
+	}
+}
+
+void MemReport::printJSON(std::ostream& output) const
+{
+	// File names are the only strings that could need escaping
+	output << "{\"file\": ";
+	writeJSONString(output, mFileName);
+	output << ", \"phases\": [";
+
+	for (size_t i = 0; i < mSnapshots.size(); i++)
+	{
+		const Snapshot& snap = mSnapshots[i];
+		output << (i ? ", " : "") << "{\"name\": \"" << snap.mPhase << "\"";
+		output << ", \"live_bytes\": " << snap.mLiveBytes;
+		output << ", \"peak_rss_bytes\": " << snap.mPeakBytes;
+		for (int j = 0; j < NumCounters; j++)
+		{
+			output << ", \"" << counterKeys[j] << "\": " << snap.mCounts[j];
+		}
+		output << ", \"llvm_blocks\": " << snap.mLLVMBlocks;
+		output << ", \"llvm_instructions\": " << snap.mLLVMInstrs << "}";
+	}
+	output << "]}\n";
+}
+
+} // opt
+} // uscc
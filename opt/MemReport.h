@@ -0,0 +1,100 @@
+//
+//  MemReport.h
+//  uscc
+//
+//  Declares the class used to collect memory usage and
+//  object counts after each compilation phase
+//  (used by --mem-report)
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+#pragma once
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstddef>
+
+namespace llvm
+{
+	class Module;
+}
+
+namespace uscc
+{
+namespace opt
+{
+
+class MemReport
+{
+public:
+	// Categories of objects we count as they're created
+	enum Counter
+	{
+		ASTNodes,
+		Identifiers,
+		ScopeTables,
+		SSASubMaps,
+		SSASubPHIs,
+		NumCounters
+	};
+
+	MemReport(const std::string& fileName);
+	~MemReport();
+
+	// Makes this the report that count() adds to on the calling thread
+	// (until it's destroyed)
+	void activate() noexcept;
+
+	// Counts the creation of an object, if a report is active on this thread
+	static void count(Counter counter) noexcept
+	{
+		if (sActive)
+		{
+			sActive->mCounts[counter]++;
+		}
+	}
+
+	// Returns true if a report is active on this thread
+	static bool isActive() noexcept
+	{
+		return sActive != nullptr;
+	}
+
+	// Records the memory usage and object counts at the end of a phase.
+	// If module is non-null, its blocks and instructions are counted, too.
+	void addPhase(const char* phase, const llvm::Module* module);
+
+	void printTable(std::ostream& output) const;
+	void printJSON(std::ostream& output) const;
+private:
+	// Disallow copy/assignment
+	MemReport(const MemReport& copy) = delete;
+	MemReport& operator=(const MemReport& rhs) = delete;
+
+	// State of the compilation at the end of a phase
+	struct Snapshot
+	{
+		std::string mPhase;
+		// Bytes currently allocated from the heap (0 if unavailable)
+		size_t mLiveBytes;
+		// Peak resident set size of the process (0 if unavailable)
+		size_t mPeakBytes;
+		size_t mCounts[NumCounters];
+		size_t mLLVMBlocks;
+		size_t mLLVMInstrs;
+	};
+
+	static thread_local MemReport* sActive;
+
+	std::string mFileName;
+	size_t mCounts[NumCounters];
+	std::vector<Snapshot> mSnapshots;
+};
+
+} // opt
+} // uscc
@@ -17,6 +17,7 @@
 #include <llvm/IR/Dominators.h>
 #include <llvm/Analysis/LoopInfo.h>
 #include <llvm/PassRegistry.h>
+#include <mutex>
 
 using namespace llvm;
 
@@ -25,15 +26,24 @@ namespace uscc
 namespace opt
 {
 
-void registerOptPasses(legacy::PassManager& pm)
+void initializeOptPasses()
 {
-	PassRegistry& pr = *PassRegistry::getPassRegistry();
-	initializeLoopInfoPass(pr);
-	initializeDominatorTreeWrapperPassPass(pr);
-	pm.add(new ConstantOps());
-	pm.add(new ConstantBranch());
-	pm.add(new DeadBlocks());
-	pm.add(new LICM());
+	static std::once_flag initFlag;
+	std::call_once(initFlag, []()
+	{
+		PassRegistry& pr = *PassRegistry::getPassRegistry();
+		initializeLoopInfoPass(pr);
+		initializeDominatorTreeWrapperPassPass(pr);
+	});
+}
+
+void registerOptPasses(legacy::PassManager& pm, TimeReport* report)
+{
+	initializeOptPasses();
+	pm.add(new ConstantOps(report));
+	pm.add(new ConstantBranch(report));
+	pm.add(new DeadBlocks(report));
+	pm.add(new LICM(report));
 	pm.add(new DominatorTreeWrapperPass());
 	pm.add(new LoopInfo());
 }
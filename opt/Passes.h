@@ -27,6 +27,7 @@
 #include <llvm/IR/LegacyPassManager.h>
 #include <llvm/IR/Dominators.h>
 #pragma clang diagnostic pop
+#include "TimeReport.h"
 
 using llvm::FunctionPass;
 using llvm::LoopPass;
@@ -37,47 +38,76 @@ namespace uscc
 namespace opt
 {
 
-// Helper function for registering the opt passes
-void registerOptPasses(llvm::legacy::PassManager& pm);
+// Registers the analyses our passes depend on with the pass registry.
+// This only does work the first time it's called, so long-running
+// hosts (such as uscc --serve) can call it once up front.
+void initializeOptPasses();
+
+// Helper function for registering the opt passes.
+// If report is non-null, the time spent by each pass on
+// each function is added to it.
+void registerOptPasses(llvm::legacy::PassManager& pm,
+					   TimeReport* report = nullptr);
 
 // Declares the Constant Propagation Pass
 struct ConstantOps : public FunctionPass
 {
 	static char ID;
-	ConstantOps() : FunctionPass(ID) {}
+	ConstantOps(TimeReport* report = nullptr)
+	: FunctionPass(ID)
+	, mReport(report)
+	{}
 	
 	virtual bool runOnFunction(llvm::Function& F) override;
 	
 	virtual void getAnalysisUsage(llvm::AnalysisUsage& Info) const override;
+	
+	// Report to add timings to (if any)
+	TimeReport* mReport;
 };
 
 // Declares the Constant Branch Folding Pass
 struct ConstantBranch : public FunctionPass
 {
 	static char ID;
-	ConstantBranch() : FunctionPass(ID) {}
+	ConstantBranch(TimeReport* report = nullptr)
+	: FunctionPass(ID)
+	, mReport(report)
+	{}
 	
 	virtual bool runOnFunction(llvm::Function& F) override;
 	
 	virtual void getAnalysisUsage(llvm::AnalysisUsage& Info) const override;
+	
+	// Report to add timings to (if any)
+	TimeReport* mReport;
 };
 
 // Declares the Dead Block Removal Pass
 struct DeadBlocks : public FunctionPass
 {
 	static char ID;
-	DeadBlocks() : FunctionPass(ID) {}
+	DeadBlocks(TimeReport* report = nullptr)
+	: FunctionPass(ID)
+	, mReport(report)
+	{}
 	
 	virtual bool runOnFunction(llvm::Function& F) override;
 	
 	virtual void getAnalysisUsage(llvm::AnalysisUsage& Info) const override;
+	
+	// Report to add timings to (if any)
+	TimeReport* mReport;
 };
 	
 // Loop invariant code motion
 struct LICM : public LoopPass
 {
 	static char ID;
-	LICM() : LoopPass(ID) {}
+	LICM(TimeReport* report = nullptr)
+	: LoopPass(ID)
+	, mReport(report)
+	{}
 	
 	virtual bool runOnLoop(llvm::Loop* L, llvm::LPPassManager& LPM) override;
 	
@@ -100,6 +130,9 @@ struct LICM : public LoopPass
 
 	// Denotes whether or not loop has been modified
 	bool mChanged;
+	
+	// Report to add timings to (if any)
+	TimeReport* mReport;
 };
 	
 } // opt
@@ -14,6 +14,7 @@
 
 #include "SSABuilder.h"
 #include "../parse/Symbols.h"
+#include "MemReport.h"
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wconversion"
@@ -84,6 +85,7 @@ void SSABuilder::writeVariable(Identifier* var, BasicBlock* block, Value* value)
         else
         {
             SubMap* subDef =  new SubMap;   // create new submap
+            MemReport::count(MemReport::SSASubMaps);
             subDef->insert(varPair);
             mVarDefs[block] = subDef;
         }
@@ -91,6 +93,7 @@ void SSABuilder::writeVariable(Identifier* var, BasicBlock* block, Value* value)
     else
     {
         SubMap* subDef =  new SubMap;   // create new submap
+        MemReport::count(MemReport::SSASubMaps);
         subDef->insert(varPair);
         mVarDefs[block] = subDef;
     }
@@ -121,7 +124,9 @@ Value* SSABuilder::readVariable(Identifier* var, BasicBlock* block)
 void SSABuilder::addBlock(BasicBlock* block, bool isSealed /* = false */)
 {
     SubMap* map = new SubMap;
+    MemReport::count(MemReport::SSASubMaps);
     SubPHI* phis = new SubPHI;
+    MemReport::count(MemReport::SSASubPHIs);
     
     mVarDefs[block] = map;
     mIncompletePhis[block] = phis;
@@ -155,11 +160,11 @@ Value* SSABuilder::readVariableRecursive(Identifier* var, BasicBlock* block)
     {
         if(block->empty())
         {
-            phi = PHINode::Create(var->llvmType(),0,"",block);
+            phi = PHINode::Create(var->llvmType(block->getContext()),0,"",block);
         }
         else
         {
-            phi = PHINode::Create(var->llvmType(),0,"",&block->front());
+            phi = PHINode::Create(var->llvmType(block->getContext()),0,"",&block->front());
         }
 
         std::pair<parse::Identifier*, llvm::PHINode*> phiPair(var,phi);
@@ -171,11 +176,13 @@ Value* SSABuilder::readVariableRecursive(Identifier* var, BasicBlock* block)
             if(phiMap == nullptr)
             {
                 phiMap = new SubPHI;
+                MemReport::count(MemReport::SSASubPHIs);
             }
         }
         else    // create new subPHI
         {
             phiMap = new SubPHI;
+            MemReport::count(MemReport::SSASubPHIs);
         }
         
         phiMap->insert(phiPair);
@@ -193,11 +200,11 @@ Value* SSABuilder::readVariableRecursive(Identifier* var, BasicBlock* block)
     {
         if(block->empty())
         {
-            phi = PHINode::Create(var->llvmType(),0,"",block);
+            phi = PHINode::Create(var->llvmType(block->getContext()),0,"",block);
         }
         else
         {
-            phi = PHINode::Create(var->llvmType(),0,"",&block->front());
+            phi = PHINode::Create(var->llvmType(block->getContext()),0,"",&block->front());
         }
         writeVariable(var, block, phi);
         retVal = phi;
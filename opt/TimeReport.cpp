@@ -0,0 +1,252 @@
+//
+//  TimeReport.cpp
+//  uscc
+//
+//  Implements the classes used to collect the wall/CPU time
+//  spent in each compilation phase and opt pass
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+#include "TimeReport.h"
+#include "JSON.h"
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wconversion"
+#include <llvm/IR/Function.h>
+#pragma clang diagnostic pop
+#include <iomanip>
+#include <ctime>
+
+namespace uscc
+{
+namespace opt
+{
+
+namespace
+{
+
+// CPU time used by the calling thread, in seconds
+double threadCPUSeconds() noexcept
+{
+#ifdef _WIN32
+	return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#else
+	timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) * 1e-9;
+#endif
+}
+
+void writeJSONRecord(std::ostream& output, const std::string& name,
+					 const TimeRecord& time)
+{
+	output << "{\"name\": ";
+	writeJSONString(output, name);
+	output << ", \"wall\": " << time.mWall << ", \"cpu\": " << time.mCPU << "}";
+}
+
+void writeTableRow(std::ostream& output, const std::string& name,
+				   const TimeRecord& time)
+{
+	output << "  " << std::setw(10) << time.mWall
+		<< "  " << std::setw(10) << time.mCPU
+		<< "  " << name << "\n";
+}
+
+} // anonymous
+
+Stopwatch::Stopwatch() noexcept
+{
+	restart();
+}
+
+Stopwatch::Stopwatch(bool start) noexcept
+: mCPUStart(0.0)
+{
+	if (start)
+	{
+		restart();
+	}
+}
+
+void Stopwatch::restart() noexcept
+{
+	mWallStart = std::chrono::steady_clock::now();
+	mCPUStart = threadCPUSeconds();
+}
+
+TimeRecord Stopwatch::elapsed() const noexcept
+{
+	TimeRecord retVal;
+	std::chrono::duration<double> wall = std::chrono::steady_clock::now() - mWallStart;
+	retVal.mWall = wall.count();
+	retVal.mCPU = threadCPUSeconds() - mCPUStart;
+	return retVal;
+}
+
+TimeReport::TimeReport(const std::string& fileName)
+: mFileName(fileName)
+, mLines(0)
+, mTokens(0)
+{
+
+}
+
+void TimeReport::addPhase(const char* phase, const TimeRecord& time)
+{
+	addRecord(mPhases, phase, time);
+}
+
+void TimeReport::addPass(const char* pass, const std::string& function,
+						 const TimeRecord& time)
+{
+	addRecord(mPasses, pass, time);
+
+	auto iter = mFunctions.find(function);
+	if (iter == mFunctions.end())
+	{
+		mFunctionOrder.push_back(function);
+		iter = mFunctions.emplace(function, RecordList()).first;
+	}
+	addRecord(iter->second, pass, time);
+}
+
+void TimeReport::printTable(std::ostream& output) const
+{
+	std::ios::fmtflags oldFlags = output.flags();
+	std::streamsize oldPrecision = output.precision();
+	output << std::fixed << std::setprecision(6);
+
+	const char* separator =
+		"===-------------------------------------------------------===\n";
+	output << separator;
+	output << "  Time report for " << mFileName << "\n";
+	output << separator;
+	output << "  " << mLines << " lines, " << mTokens << " tokens\n\n";
+
+	TimeRecord total;
+	output << "    Wall (s)     CPU (s)  Phase\n";
+	for (auto& phase : mPhases)
+	{
+		writeTableRow(output, phase.first, phase.second);
+		total.add(phase.second);
+	}
+	writeTableRow(output, "Total", total);
+
+	if (!mPasses.empty())
+	{
+		output << "\n    Wall (s)     CPU (s)  Pass\n";
+		for (auto& pass : mPasses)
+		{
+			writeTableRow(output, pass.first, pass.second);
+		}
+
+		output << "\n    Wall (s)     CPU (s)  Function (all passes)\n";
+		for (auto& name : mFunctionOrder)
+		{
+			TimeRecord funcTotal;
+			for (auto& pass : mFunctions.at(name))
+			{
+				funcTotal.add(pass.second);
+			}
+			writeTableRow(output, name, funcTotal);
+		}
+	}
+
+	output.flags(oldFlags);
+	output.precision(oldPrecision);
+}
+
+void TimeReport::printJSON(std::ostream& output) const
+{
+	std::ios::fmtflags oldFlags = output.flags();
+	std::streamsize oldPrecision = output.precision();
+	output << std::fixed << std::setprecision(9);
+
+	output << "{\"file\": ";
+	writeJSONString(output, mFileName);
+	output << ", \"lines\": " << mLines << ", \"tokens\": " << mTokens;
+
+	output << ", \"phases\": [";
+	for (size_t i = 0; i < mPhases.size(); i++)
+	{
+		output << (i ? ", " : "");
+		writeJSONRecord(output, mPhases[i].first, mPhases[i].second);
+	}
+
+	output << "], \"passes\": [";
+	for (size_t i = 0; i < mPasses.size(); i++)
+	{
+		output << (i ? ", " : "");
+		writeJSONRecord(output, mPasses[i].first, mPasses[i].second);
+	}
+
+	output << "], \"functions\": [";
+	for (size_t i = 0; i < mFunctionOrder.size(); i++)
+	{
+		const RecordList& passes = mFunctions.at(mFunctionOrder[i]);
+		TimeRecord funcTotal;
+		for (auto& pass : passes)
+		{
+			funcTotal.add(pass.second);
+		}
+
+		output << (i ? ", " : "") << "{\"name\": ";
+		writeJSONString(output, mFunctionOrder[i]);
+		output << ", \"wall\": " << funcTotal.mWall << ", \"cpu\": " << funcTotal.mCPU;
+		output << ", \"passes\": [";
+		for (size_t j = 0; j < passes.size(); j++)
+		{
+			output << (j ? ", " : "");
+			writeJSONRecord(output, passes[j].first, passes[j].second);
+		}
+		output << "]}";
+	}
+	output << "]}\n";
+
+	output.flags(oldFlags);
+	output.precision(oldPrecision);
+}
+
+// Adds to the named record in the list (adding the record if needed)
+void TimeReport::addRecord(RecordList& list, const std::string& name,
+						   const TimeRecord& time)
+{
+	// These lists are short (a handful of phases or passes),
+	// so a linear search is fine
+	for (auto& record : list)
+	{
+		if (record.first == name)
+		{
+			record.second.add(time);
+			return;
+		}
+	}
+
+	list.emplace_back(name, time);
+}
+
+PhaseTimer::~PhaseTimer()
+{
+	if (mReport)
+	{
+		TimeRecord time = mTimer.elapsed();
+		time.mCPU += mWorkerCPU;
+		mReport->addPhase(mPhase, time);
+	}
+}
+
+PassTimer::~PassTimer()
+{
+	if (mReport)
+	{
+		mReport->addPass(mPass, mFunction.getName().str(), mTimer.elapsed());
+	}
+}
+
+} // opt
+} // uscc
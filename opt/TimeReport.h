@@ -0,0 +1,163 @@
+//
+//  TimeReport.h
+//  uscc
+//
+//  Declares the classes used to collect the wall/CPU time
+//  spent in each compilation phase and opt pass
+//  (used by -ftime-report)
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <ostream>
+#include <chrono>
+
+namespace llvm
+{
+	class Function;
+}
+
+namespace uscc
+{
+namespace opt
+{
+
+// Wall and CPU time, in seconds
+struct TimeRecord
+{
+	TimeRecord()
+	: mWall(0.0)
+	, mCPU(0.0)
+	{ }
+
+	void add(const TimeRecord& other)
+	{
+		mWall += other.mWall;
+		mCPU += other.mCPU;
+	}
+
+	double mWall;
+	double mCPU;
+};
+
+// Measures the time since it was constructed (or last restarted).
+// CPU time is measured for the calling thread only, so timings
+// stay meaningful when several files are compiled at once.
+class Stopwatch
+{
+public:
+	Stopwatch() noexcept;
+
+	// Only starts if start is true (otherwise call restart
+	// before reading it), so unused timers don't read the clocks
+	explicit Stopwatch(bool start) noexcept;
+
+	void restart() noexcept;
+
+	TimeRecord elapsed() const noexcept;
+private:
+	std::chrono::steady_clock::time_point mWallStart;
+	double mCPUStart;
+};
+
+// Collects the timings for a single compilation
+class TimeReport
+{
+public:
+	TimeReport(const std::string& fileName);
+
+	// Adds time to a phase. Phases are reported in the order
+	// they're first added, and adding to an existing phase accumulates.
+	void addPhase(const char* phase, const TimeRecord& time);
+
+	// Adds time spent by an opt pass on a particular function
+	void addPass(const char* pass, const std::string& function,
+				 const TimeRecord& time);
+
+	// Sets the size of the input, so phase times can be
+	// turned into throughput (tokens don't include whitespace
+	// or comments)
+	void setInputSize(size_t lines, size_t tokens) noexcept
+	{
+		mLines = lines;
+		mTokens = tokens;
+	}
+
+	void printTable(std::ostream& output) const;
+	void printJSON(std::ostream& output) const;
+private:
+	typedef std::vector<std::pair<std::string, TimeRecord>> RecordList;
+
+	// Adds to the named record in the list (adding the record if needed)
+	static void addRecord(RecordList& list, const std::string& name,
+						  const TimeRecord& time);
+
+	std::string mFileName;
+	size_t mLines;
+	size_t mTokens;
+	RecordList mPhases;
+	RecordList mPasses;
+	// Function name -> time spent by each pass
+	std::map<std::string, RecordList> mFunctions;
+	// Functions in the order they were first seen
+	std::vector<std::string> mFunctionOrder;
+};
+
+// Adds the time between construction and destruction
+// to the requested phase. Does nothing if report is null.
+class PhaseTimer
+{
+public:
+	PhaseTimer(TimeReport* report, const char* phase) noexcept
+	: mReport(report)
+	, mPhase(phase)
+	, mWorkerCPU(0.0)
+	, mTimer(report != nullptr)
+	{ }
+
+	~PhaseTimer();
+
+	// Adds CPU time that other threads spent on this phase
+	// (the Stopwatch only sees the calling thread's)
+	void addWorkerCPU(double seconds) noexcept
+	{
+		mWorkerCPU += seconds;
+	}
+private:
+	TimeReport* mReport;
+	const char* mPhase;
+	double mWorkerCPU;
+	Stopwatch mTimer;
+};
+
+// Adds the time between construction and destruction to the
+// requested pass/function. Does nothing if report is null.
+class PassTimer
+{
+public:
+	PassTimer(TimeReport* report, const char* pass,
+			  const llvm::Function& function) noexcept
+	: mReport(report)
+	, mPass(pass)
+	, mFunction(function)
+	, mTimer(report != nullptr)
+	{ }
+
+	~PassTimer();
+private:
+	TimeReport* mReport;
+	const char* mPass;
+	const llvm::Function& mFunction;
+	Stopwatch mTimer;
+};
+
+} // opt
+} // uscc
@@ -0,0 +1,28 @@
+//
+//  ASTArena.cpp
+//  uscc
+//
+//  Implements the arena AST nodes are allocated from.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#include "ASTArena.h"
+
+using namespace uscc::parse;
+
+// Runs the destructors of any nodes that need them,
+// then frees all the memory at once
+ASTArena::~ASTArena()
+{
+	// Newest first, like they'd be destroyed on the stack
+	for (auto iter = mDestructors.rbegin(); iter != mDestructors.rend(); ++iter)
+	{
+		iter->mDestroy(iter->mNode);
+	}
+}
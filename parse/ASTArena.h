@@ -0,0 +1,95 @@
+//
+//  ASTArena.h
+//  uscc
+//
+//  Declares the arena that the AST nodes for a single
+//  parse are allocated from.
+//
+//  Nodes are bump-allocated, and referenced by plain
+//  pointers. They all live until the arena is destroyed,
+//  which frees them in one step.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wconversion"
+#include <llvm/Support/Allocator.h>
+#pragma clang diagnostic pop
+
+namespace uscc
+{
+namespace parse
+{
+
+class ASTArena
+{
+public:
+	ASTArena() noexcept { }
+	
+	// Runs the destructors of any nodes that need them,
+	// then frees all the memory at once
+	~ASTArena();
+	
+	// Allocates and constructs a T
+	template <typename T, typename... Args>
+	T* make(Args&&... args)
+	{
+		void* mem = mAllocator.Allocate(sizeof(T), alignof(T));
+		T* node = new (mem) T(std::forward<Args>(args)...);
+		
+		// Most nodes only hold pointers, so there's nothing to destroy
+		if (!std::is_trivially_destructible<T>::value)
+		{
+			mDestructors.push_back(Destructor(node, &destroy<T>));
+		}
+		return node;
+	}
+	
+	// Returns the bytes allocated for nodes so far
+	size_t getBytes() const noexcept
+	{
+		return mAllocator.getTotalMemory();
+	}
+	
+private:
+	// Disallow copy/assignment
+	ASTArena(const ASTArena& copy) = delete;
+	ASTArena& operator=(const ASTArena& rhs) = delete;
+	
+	template <typename T>
+	static void destroy(void* node) noexcept
+	{
+		static_cast<T*>(node)->~T();
+	}
+	
+	struct Destructor
+	{
+		Destructor(void* node, void (*destroy)(void*))
+		: mNode(node)
+		, mDestroy(destroy)
+		{ }
+		
+		void* mNode;
+		void (*mDestroy)(void*);
+	};
+	
+	llvm::BumpPtrAllocator mAllocator;
+	std::vector<Destructor> mDestructors;
+};
+
+} // parse
+} // uscc
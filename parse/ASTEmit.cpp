@@ -1,8 +1,9 @@
 //
-//  ASTNodes.cpp
+//  ASTEmit.cpp
 //  uscc
 //
-//  Implements the emitIR function for every AST node.
+//  Implements emitting LLVM IR for every kind of node
+//  in the FlatAST.
 //
 //---------------------------------------------------------
 //  Copyright (c) 2014, Sanjay Madhav
@@ -13,7 +14,9 @@
 //---------------------------------------------------------
 
 #include "ASTNodes.h"
+#include "ASTVisitor.h"
 #include "Emitter.h"
+#include "Session.h"
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wconversion"
@@ -34,12 +37,50 @@
 using namespace uscc::parse;
 using namespace llvm;
 
-#define AST_EMIT(a) llvm::Value* a::emitIR(CodeContext& ctx) noexcept
+namespace uscc
+{
+namespace parse
+{
+namespace
+{
+
+// (In uscc::parse, so Type is ours and not llvm::Type)
+class IREmitter : public ASTVisitor<IREmitter, llvm::Value*, CodeContext&>
+{
+public:
+	IREmitter(const FlatAST& ast) noexcept
+	: ASTVisitor(ast)
+	{ }
+	
+	#define AST_KIND(a) llvm::Value* visit##a(FlatAST::NodeId node, CodeContext& ctx);
+	#include "ASTKinds.def"
+	#undef AST_KIND
+	
+private:
+	// Emits the child at index
+	llvm::Value* emitChild(FlatAST::NodeId node, size_t index, CodeContext& ctx)
+	{
+		return visit(mAST.getChild(node, index), ctx);
+	}
+};
+
+} // anonymous
+} // parse
+} // uscc
+
+// Emits the IR for the whole program
+void uscc::parse::emitAST(const FlatAST& ast, CodeContext& ctx)
+{
+	IREmitter emitter(ast);
+	emitter.visit(ast.getRoot(), ctx);
+}
+
+#define AST_EMIT(a) llvm::Value* IREmitter::visit##a(FlatAST::NodeId node, CodeContext& ctx)
 
 // Program/Functions
-AST_EMIT(ASTProgram)
+AST_EMIT(Program)
 {
-	ctx.mModule = new Module("main", ctx.mGlobal);
+	ctx.mModule = ctx.mSession.createModule("main");
 	
 	// Write the global string table
 	ctx.mStrings.emitIR(ctx);
@@ -62,26 +103,31 @@ AST_EMIT(ASTProgram)
 	}
 	
 	// Emit code for all the functions
-	for (auto f : mFuncs)
+	for (const FlatAST::NodeId* f = mAST.childBegin(node); f != mAST.childEnd(node); ++f)
 	{
-		f->emitIR(ctx);
+		visit(*f, ctx);
 	}
 	// A program actually doesn't have a value to return, since everything
 	// is stored in Module
 	return nullptr;
 }
 
-AST_EMIT(ASTFunction)
+AST_EMIT(Function)
 {
+	ASTFunction& func = mAST.getFunction(node);
+	Type returnType = mAST.getType(node);
+	// The arguments come before the body
+	size_t numArgs = mAST.getNumChildren(node) - 1;
+	
 	FunctionType* funcType = nullptr;
 	
 	// First get the return type (there's only three choices)
 	llvm::Type* retType = nullptr;
-	if (mReturnType == Type::Int)
+	if (returnType == Type::Int)
 	{
 		retType = llvm::Type::getInt32Ty(ctx.mGlobal);
 	}
-	else if (mReturnType == Type::Char)
+	else if (returnType == Type::Char)
 	{
 		retType = llvm::Type::getInt8Ty(ctx.mGlobal);
 	}
@@ -90,7 +136,7 @@ AST_EMIT(ASTFunction)
 		retType = llvm::Type::getVoidTy(ctx.mGlobal);
 	}
 	
-	if (mArgs.size() == 0)
+	if (numArgs == 0)
 	{
 		funcType = FunctionType::get(retType, false);
 	}
@@ -98,9 +144,9 @@ AST_EMIT(ASTFunction)
 	{
 
 		std::vector<llvm::Type*> args;
-		for (auto arg : mArgs)
+		for (size_t i = 0; i < numArgs; i++)
 		{
-			args.push_back(arg->getIdent().llvmType());
+			args.push_back(mAST.getIdent(mAST.getChild(node, i)).llvmType(ctx.mGlobal));
 		}
 		
 		funcType = FunctionType::get(retType, args, false);
@@ -109,13 +155,20 @@ AST_EMIT(ASTFunction)
 	// Create the function, and make it the current one
 	ctx.mFunc = Function::Create(funcType,
 								 GlobalValue::LinkageTypes::ExternalLinkage,
-								 mIdent.getName(), ctx.mModule);
+								 func.getIdent().getName(), ctx.mModule);
 	
 	// Now that we have a new function, reset our SSA builder
 	ctx.mSSA.reset();
 	
 	// Map the ident to this function
-	mIdent.setAddress(ctx.mFunc);
+	func.getIdent().setAddress(ctx.mFunc);
+	
+	// If the body comes from the function cache, a declaration is all we need
+	if (ctx.mDeclareOnly.count(&func))
+	{
+		ctx.mFunc->setCallingConv(CallingConv::C);
+		return ctx.mFunc;
+	}
 	
 	// Create the entry basic block
 	ctx.mBlock = BasicBlock::Create(ctx.mGlobal, "entry", ctx.mFunc);
@@ -123,14 +176,14 @@ AST_EMIT(ASTFunction)
 	ctx.mSSA.addBlock(ctx.mBlock, true);
 	
 	// If we have arguments, we need to set the name/value of them
-	if (mArgs.size() > 0)
+	if (numArgs > 0)
 	{
 		Function::arg_iterator iter = ctx.mFunc->arg_begin();
 		Function::arg_iterator end = ctx.mFunc->arg_end();
 		int i = 0;
 		while (iter != end)
 		{
-			Identifier& argIdent = mArgs[i]->getIdent();
+			Identifier& argIdent = mAST.getIdent(mAST.getChild(node, i));
 			iter->setName(argIdent.getName());
 			
 			// PA4: Remove the setAddress call
@@ -150,27 +203,27 @@ AST_EMIT(ASTFunction)
 	ctx.mFunc->setCallingConv(CallingConv::C);
 	
 	// Add all the declarations for variables created in this function
-	mScopeTable.emitIR(ctx);
+	func.getScopeTable().emitIR(ctx);
 	
 	// Now emit the body
-	mBody->emitIR(ctx);
+	emitChild(node, numArgs, ctx);
 	
 	return ctx.mFunc;
 }
 
-AST_EMIT(ASTArgDecl)
+AST_EMIT(ArgDecl)
 {
 	// This node actually doesn't have anything to emit
 	return nullptr;
 }
 
-AST_EMIT(ASTArraySub)
+AST_EMIT(ArraySub)
 {
 	// Evaluate the sub expression to get the desired index
-	Value* arrayIdx = mExpr->emitIR(ctx);
+	Value* arrayIdx = emitChild(node, 0, ctx);
 	
 	// This address should already be saved
-	Value* addr = mIdent.readFrom(ctx);
+	Value* addr = mAST.getIdent(node).readFrom(ctx);
 	
 	// GEP from the array address
 	IRBuilder<> build(ctx.mBlock);
@@ -179,13 +232,13 @@ AST_EMIT(ASTArraySub)
 
 // Expressions
 
-AST_EMIT(ASTBadExpr)
+AST_EMIT(BadExpr)
 {
 	// This node will never be emitted
 	return nullptr;
 }
 
-AST_EMIT(ASTLogicalAnd)
+AST_EMIT(LogicalAnd)
 {
 	// This is extremely similar to logical or
 	
@@ -202,7 +255,7 @@ AST_EMIT(ASTLogicalAnd)
 	ctx.mSSA.addBlock(endBlock);
 	
 	// Now generate the LHS
-	Value* lhsVal = mLHS->emitIR(ctx);
+	Value* lhsVal = emitChild(node, 0, ctx);
 	
 	BasicBlock* lhsBlock = ctx.mBlock;
 	
@@ -220,7 +273,7 @@ AST_EMIT(ASTLogicalAnd)
 	
 	// Code should now be generated in the RHS block
 	ctx.mBlock = rhsBlock;
-	Value* rhsVal = mRHS->emitIR(ctx);
+	Value* rhsVal = emitChild(node, 1, ctx);
 	
 	// This is the final RHS block (for the phi node)
 	rhsBlock = ctx.mBlock;
@@ -263,7 +316,7 @@ AST_EMIT(ASTLogicalAnd)
 	return build.CreateZExt(zextVal, llvm::Type::getInt32Ty(ctx.mGlobal));
 }
 
-AST_EMIT(ASTLogicalOr)
+AST_EMIT(LogicalOr)
 {
 	// Create the block for the RHS
 	BasicBlock* rhsBlock = BasicBlock::Create(ctx.mGlobal, "lor.rhs", ctx.mFunc);
@@ -278,7 +331,7 @@ AST_EMIT(ASTLogicalOr)
 	ctx.mSSA.addBlock(endBlock);
 	
 	// Now generate the LHS
-	Value* lhsVal = mLHS->emitIR(ctx);
+	Value* lhsVal = emitChild(node, 0, ctx);
 	
 	BasicBlock* lhsBlock = ctx.mBlock;
 	
@@ -296,7 +349,7 @@ AST_EMIT(ASTLogicalOr)
 	
 	// Code should now be generated in the RHS block
 	ctx.mBlock = rhsBlock;
-	Value* rhsVal = mRHS->emitIR(ctx);
+	Value* rhsVal = emitChild(node, 1, ctx);
 	
 	// This is the final RHS block (for the phi node)
 	rhsBlock = ctx.mBlock;
@@ -340,30 +393,31 @@ AST_EMIT(ASTLogicalOr)
 
 
 // PA3:
-AST_EMIT(ASTBinaryCmpOp)
+AST_EMIT(BinaryCmpOp)
 {
+	scan::Token::Tokens op = mAST.getOp(node);
 	Value* retVal = nullptr;
-    Value* lhsVal = mLHS->emitIR(ctx);
-    Value* rhsVal = mRHS->emitIR(ctx);
-    if(mOp == scan::Token::Tokens::LessThan)
+    Value* lhsVal = emitChild(node, 0, ctx);
+    Value* rhsVal = emitChild(node, 1, ctx);
+    if(op == scan::Token::Tokens::LessThan)
     {
         IRBuilder<> build(ctx.mBlock);
         retVal = build.CreateICmpSLT(lhsVal, rhsVal,"lessthan");
         return build.CreateZExt(retVal, llvm::Type::getInt32Ty(ctx.mGlobal));
     }
-    else if(mOp == scan::Token::Tokens::GreaterThan)
+    else if(op == scan::Token::Tokens::GreaterThan)
     {
         IRBuilder<> build(ctx.mBlock);
         retVal = build.CreateICmpSGT(lhsVal, rhsVal,"greaterthan");
         return build.CreateZExt(retVal, llvm::Type::getInt32Ty(ctx.mGlobal));
     }
-    else if(mOp == scan::Token::Tokens::NotEqual)
+    else if(op == scan::Token::Tokens::NotEqual)
     {
         IRBuilder<> build(ctx.mBlock);
         retVal = build.CreateICmpNE(lhsVal, rhsVal,"notequal");
         return build.CreateZExt(retVal, llvm::Type::getInt32Ty(ctx.mGlobal));
     }
-    else if(mOp == scan::Token::Tokens::EqualTo)
+    else if(op == scan::Token::Tokens::EqualTo)
     {
         IRBuilder<> build(ctx.mBlock);
         retVal = build.CreateICmpEQ(lhsVal, rhsVal,"equal");
@@ -373,32 +427,33 @@ AST_EMIT(ASTBinaryCmpOp)
 }
 
 // PA3: generate lhs, rhs expressions and create and return instruction based on op
-AST_EMIT(ASTBinaryMathOp)
+AST_EMIT(BinaryMathOp)
 {
+	scan::Token::Tokens op = mAST.getOp(node);
 	Value* retVal = nullptr;
-    Value* lhsVal = mLHS->emitIR(ctx);
-    Value* rhsVal = mRHS->emitIR(ctx);
-    if(mOp == scan::Token::Tokens::Plus)
+    Value* lhsVal = emitChild(node, 0, ctx);
+    Value* rhsVal = emitChild(node, 1, ctx);
+    if(op == scan::Token::Tokens::Plus)
     {
         IRBuilder<> build(ctx.mBlock);
         retVal = build.CreateAdd(lhsVal, rhsVal,"add");
     }
-    else if(mOp == scan::Token::Tokens::Minus)
+    else if(op == scan::Token::Tokens::Minus)
     {
         IRBuilder<> build(ctx.mBlock);
         retVal = build.CreateSub(lhsVal, rhsVal,"sub");
     }
-    else if(mOp == scan::Token::Tokens::Mult)
+    else if(op == scan::Token::Tokens::Mult)
     {
         IRBuilder<> build(ctx.mBlock);
         retVal = build.CreateMul(lhsVal, rhsVal,"mul");
     }
-    else if(mOp == scan::Token::Tokens::Div)
+    else if(op == scan::Token::Tokens::Div)
     {
         IRBuilder<> build(ctx.mBlock);
         retVal = build.CreateSDiv(lhsVal, rhsVal,"sdiv");
     }
-    else if(mOp == scan::Token::Tokens::Mod)
+    else if(op == scan::Token::Tokens::Mod)
     {
         IRBuilder<> build(ctx.mBlock);
         retVal = build.CreateSRem(lhsVal, rhsVal,"srem");
@@ -408,45 +463,45 @@ AST_EMIT(ASTBinaryMathOp)
 
 // Value -->
 // PA3
-AST_EMIT(ASTNotExpr)
+AST_EMIT(NotExpr)
 {
 	Value* retVal = nullptr;
     IRBuilder<> build(ctx.mBlock);
-    Value* lhsVal = mExpr->emitIR(ctx);
+    Value* lhsVal = emitChild(node, 0, ctx);
     retVal = build.CreateICmpEQ(lhsVal, ctx.mZero, "not");
     return build.CreateZExt(retVal, llvm::Type::getInt32Ty(ctx.mGlobal));
 }
 
 // Factor -->
 // PA3
-AST_EMIT(ASTConstantExpr)
+AST_EMIT(ConstantExpr)
 {
 	Value* retVal = nullptr;
-    if(mType == Type::Int)
+    if(mAST.getType(node) == Type::Int)
     {
-        retVal = ConstantInt::get(llvm::Type::getInt32Ty(ctx.mGlobal), mValue);
+        retVal = ConstantInt::get(llvm::Type::getInt32Ty(ctx.mGlobal), mAST.getValue(node));
     }
-    if(mType == Type::Char)
+    if(mAST.getType(node) == Type::Char)
     {
-        retVal = ConstantInt::get(llvm::Type::getInt8Ty(ctx.mGlobal), mValue);
+        retVal = ConstantInt::get(llvm::Type::getInt8Ty(ctx.mGlobal), mAST.getValue(node));
     }
 	return retVal;
 }
 
-AST_EMIT(ASTStringExpr)
+AST_EMIT(StringExpr)
 {
-	return mString->getValue();
+	return mAST.getString(node)->getValue();
 }
 
-AST_EMIT(ASTIdentExpr)
+AST_EMIT(IdentExpr)
 {
-	return mIdent.readFrom(ctx);
+	return mAST.getIdent(node).readFrom(ctx);
 }
 
-AST_EMIT(ASTArrayExpr)
+AST_EMIT(ArrayExpr)
 {
 	// Generate the array subscript, which'll give us the address
-	Value* addr = mArray->emitIR(ctx);
+	Value* addr = emitChild(node, 0, ctx);
 
 	IRBuilder<> build(ctx.mBlock);
 	// Now load this value and return
@@ -455,15 +510,15 @@ AST_EMIT(ASTArrayExpr)
 	return build.CreateLoad(addr);
 }
 
-AST_EMIT(ASTFuncExpr)
+AST_EMIT(FuncExpr)
 {
 	
 	// At this point, we can assume the argument types match
 	// Create the list of arguments
 	std::vector<Value*> callList;
-	for (auto arg : mArgs)
+	for (const FlatAST::NodeId* arg = mAST.childBegin(node); arg != mAST.childEnd(node); ++arg)
 	{
-		Value* argValue = arg->emitIR(ctx);
+		Value* argValue = visit(*arg, ctx);
 		// If this is an array or ptr, we need to change this to a getelemptr
 		// (Provided it already isn't one)
 		if (!isa<GetElementPtrInst>(argValue) &&
@@ -493,87 +548,91 @@ AST_EMIT(ASTFuncExpr)
 	// Now call the function, and return it
 	Value* retVal = nullptr;
 	
+	Identifier& ident = mAST.getIdent(node);
 	IRBuilder<> build(ctx.mBlock);
-	if (mType != Type::Void)
+	if (mAST.getType(node) != Type::Void)
 	{
-		retVal = build.CreateCall(mIdent.getAddress(), callList, "call");
+		retVal = build.CreateCall(ident.getAddress(), callList, "call");
 	}
 	else            //getting seg fault b/c mIdent is null
 	{
-		retVal = build.CreateCall(mIdent.getAddress(), callList);
+		retVal = build.CreateCall(ident.getAddress(), callList);
 	}
 	
 	return retVal;
 }
 
 //PA3: read identifier, add one to the value, write back into the identifier with writeto.
-AST_EMIT(ASTIncExpr)
+AST_EMIT(IncExpr)
 {
+    Identifier& ident = mAST.getIdent(node);
     llvm::IRBuilder<> build(ctx.mBlock);
     Value* constant  = nullptr;
-    Value* temp = mIdent.readFrom(ctx);
-    if(mIdent.getType() == Type::Int)          // int
+    Value* temp = ident.readFrom(ctx);
+    if(ident.getType() == Type::Int)          // int
     {
         constant = ConstantInt::get(llvm::Type::getInt32Ty(ctx.mGlobal), 1);
     }
-    else if(mIdent.getType() == Type::Char)        // char
+    else if(ident.getType() == Type::Char)        // char
     {
         constant = ConstantInt::get(llvm::Type::getInt8Ty(ctx.mGlobal), 1);
     }
-    mIdent.writeTo(ctx, build.CreateAdd(temp, constant));
-    return mIdent.readFrom(ctx);
+    ident.writeTo(ctx, build.CreateAdd(temp, constant));
+    return ident.readFrom(ctx);
 }
 
-AST_EMIT(ASTDecExpr)
+AST_EMIT(DecExpr)
 {
+    Identifier& ident = mAST.getIdent(node);
     llvm::IRBuilder<> build(ctx.mBlock);
     Value* constant  = nullptr;
-    Value* temp = mIdent.readFrom(ctx);
-    if(mIdent.getType() == Type::Int)          // int
+    Value* temp = ident.readFrom(ctx);
+    if(ident.getType() == Type::Int)          // int
     {
         constant = ConstantInt::get(llvm::Type::getInt32Ty(ctx.mGlobal), 1);
     }
-    else if(mIdent.getType() == Type::Char)        // char
+    else if(ident.getType() == Type::Char)        // char
     {
         constant = ConstantInt::get(llvm::Type::getInt8Ty(ctx.mGlobal), 1);
     }
-    mIdent.writeTo(ctx, build.CreateSub(temp, constant));
-	return mIdent.readFrom(ctx);
+    ident.writeTo(ctx, build.CreateSub(temp, constant));
+	return ident.readFrom(ctx);
 }
 
-AST_EMIT(ASTAddrOfArray)
+AST_EMIT(AddrOfArray)
 {
-	return mArray->emitIR(ctx);
+	return emitChild(node, 0, ctx);
 }
 
-AST_EMIT(ASTToIntExpr)
+AST_EMIT(ToIntExpr)
 {
-	Value* exprVal = mExpr->emitIR(ctx);
+	Value* exprVal = emitChild(node, 0, ctx);
 	IRBuilder<> build(ctx.mBlock);
 	return build.CreateSExt(exprVal, llvm::Type::getInt32Ty(ctx.mGlobal), "conv");
 }
 
-AST_EMIT(ASTToCharExpr)
+AST_EMIT(ToCharExpr)
 {
-	Value* exprVal = mExpr->emitIR(ctx);
+	Value* exprVal = emitChild(node, 0, ctx);
 	IRBuilder<> build(ctx.mBlock);
 	return build.CreateTrunc(exprVal, llvm::Type::getInt8Ty(ctx.mGlobal), "conv");
 }
 
 // Declaration
-AST_EMIT(ASTDecl)
+AST_EMIT(Decl)
 {
 	// If there's an expression, emit this also and store it in the ident
-	if (mExpr)
+	if (mAST.getNumChildren(node) > 0)
 	{
-		Value* declExpr = mExpr->emitIR(ctx);
+		Identifier& ident = mAST.getIdent(node);
+		Value* declExpr = emitChild(node, 0, ctx);
 		
 		IRBuilder<> build(ctx.mBlock);
 		// If this is a string, we have to memcpy
 		if (declExpr->getType()->isPointerTy())
 		{
 			// This address should already be saved
-			Value* arrayLoc = mIdent.readFrom(ctx);
+			Value* arrayLoc = ident.readFrom(ctx);
 			
 			// GEP the address of the src
 			std::vector<llvm::Value*> gepIdx;
@@ -584,12 +643,12 @@ AST_EMIT(ASTDecl)
 			
 			// Memcpy into the array
 			// memcpy(dest, src, size, align, volatile)
-			build.CreateMemCpy(arrayLoc, src, mIdent.getArrayCount(), 1);
+			build.CreateMemCpy(arrayLoc, src, ident.getArrayCount(), 1);
 		}
 		else
 		{
 			// Basic types can just be written
-			mIdent.writeTo(ctx, declExpr);
+			ident.writeTo(ctx, declExpr);
 		}
 	}
 	
@@ -598,38 +657,35 @@ AST_EMIT(ASTDecl)
 
 // Statements PA3
 // Emit each of the declarations and statements
-AST_EMIT(ASTCompoundStmt)
+AST_EMIT(CompoundStmt)
 {
-    for(auto decl : mDecls)
-    {
-        decl->emitIR(ctx);
-    }
-    for(auto stmt : mStmts)
+    // The declarations, then the statements
+    for(const FlatAST::NodeId* child = mAST.childBegin(node); child != mAST.childEnd(node); ++child)
     {
-        stmt->emitIR(ctx);
+        visit(*child, ctx);
     }
 	return nullptr;
 }
 
-AST_EMIT(ASTAssignStmt)
+AST_EMIT(AssignStmt)
 {
 	// This is simpler than decl because we don't allow
 	// assignments to happen later for full arrays
 	
 	// PA3: Implement
     
-    Value* value = mExpr->emitIR(ctx);
-    mIdent.writeTo(ctx,value);
+    Value* value = emitChild(node, 0, ctx);
+    mAST.getIdent(node).writeTo(ctx,value);
 	return nullptr;
 }
 
-AST_EMIT(ASTAssignArrayStmt)
+AST_EMIT(AssignArrayStmt)
 {
 	// Generate the expression
-	Value* exprVal = mExpr->emitIR(ctx);
+	Value* exprVal = emitChild(node, 1, ctx);
 	
 	// Generate the array subscript, which'll give us the address
-	Value* addr = mArray->emitIR(ctx);
+	Value* addr = emitChild(node, 0, ctx);
 
 	IRBuilder<> build(ctx.mBlock);
 	
@@ -639,18 +695,19 @@ AST_EMIT(ASTAssignArrayStmt)
 	return nullptr;
 }
 
-AST_EMIT(ASTIfStmt)
+AST_EMIT(IfStmt)
 {
+    bool hasElse = mAST.getNumChildren(node) > 2;
     BasicBlock* thenBlock = BasicBlock::Create(ctx.mGlobal,"if.then",ctx.mFunc);
     ctx.mSSA.addBlock(thenBlock);
     BasicBlock* elseBlock;
     BasicBlock* endBlock;
     // predecessor, conditional branch then, end or then, else.
     {
-        Value* condition = mExpr->emitIR(ctx);
+        Value* condition = emitChild(node, 0, ctx);
         IRBuilder<> build(ctx.mBlock);
         condition = build.CreateICmpNE(condition, ctx.mZero);
-        if(mElseStmt)       // else exists
+        if(hasElse)       // else exists
         {
             elseBlock = BasicBlock::Create(ctx.mGlobal,"if.else",ctx.mFunc);
             ctx.mSSA.addBlock(elseBlock);
@@ -671,16 +728,16 @@ AST_EMIT(ASTIfStmt)
     // then
     {
         ctx.mBlock = thenBlock;
-        mThenStmt->emitIR(ctx);
+        emitChild(node, 1, ctx);
         IRBuilder<> build(ctx.mBlock);
         build.CreateBr(endBlock);
     }
     // else
     {
-        if(mElseStmt)
+        if(hasElse)
         {
             ctx.mBlock = elseBlock;
-            mElseStmt->emitIR(ctx);
+            emitChild(node, 2, ctx);
             IRBuilder<> build(ctx.mBlock);
             build.CreateBr(endBlock);
         }
@@ -696,7 +753,7 @@ AST_EMIT(ASTIfStmt)
 }
 
 // PA3: Implement
-AST_EMIT(ASTWhileStmt)
+AST_EMIT(WhileStmt)
 {
     BasicBlock* cond = BasicBlock::Create(ctx.mGlobal,"while.cond",ctx.mFunc);
     ctx.mSSA.addBlock(cond);
@@ -713,7 +770,7 @@ AST_EMIT(ASTWhileStmt)
     // cond
     {
         ctx.mBlock = cond;
-        Value* condition = mExpr->emitIR(ctx);
+        Value* condition = emitChild(node, 0, ctx);
         IRBuilder<> build(ctx.mBlock);        
         condition = build.CreateICmpNE(condition, ctx.mZero);
         build.CreateCondBr(condition, body, end);
@@ -723,7 +780,7 @@ AST_EMIT(ASTWhileStmt)
     // body
     {
         ctx.mBlock = body;
-        mLoopStmt->emitIR(ctx);
+        emitChild(node, 1, ctx);
         IRBuilder<> build(ctx.mBlock);
         build.CreateBr(cond);       // unconditional branch
     }
@@ -737,16 +794,16 @@ AST_EMIT(ASTWhileStmt)
 }
 
 // PA3
-AST_EMIT(ASTReturnStmt)
+AST_EMIT(ReturnStmt)
 {
-    if(!mExpr)          // void return stmt
+    if(mAST.getNumChildren(node) == 0)          // void return stmt
     {
         IRBuilder<> build(ctx.mBlock);
         build.CreateRetVoid();
     }
     else            // not void, emit first
     {
-        Value* retVal = mExpr->emitIR(ctx);
+        Value* retVal = emitChild(node, 0, ctx);
         IRBuilder<> build(ctx.mBlock);
         build.CreateRet(retVal);
     }
@@ -754,14 +811,14 @@ AST_EMIT(ASTReturnStmt)
 }
 
 // PA 3:evaluates expression stmt, doesot return any value
-AST_EMIT(ASTExprStmt)
+AST_EMIT(ExprStmt)
 {
    
-    mExpr->emitIR(ctx);
+    emitChild(node, 0, ctx);
     return nullptr;
 }
 
-AST_EMIT(ASTNullStmt)
+AST_EMIT(NullStmt)
 {
 	// Doesn't do anything (hence empty)
 	return nullptr;
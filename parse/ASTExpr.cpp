@@ -141,7 +141,15 @@ ASTStringExpr::ASTStringExpr(const std::string& str, StringTable& tbl)
 	mString = tbl.getString(actStr);
 }
 
-void ASTFuncExpr::addArg(std::shared_ptr<ASTExpr> arg) noexcept
+// Switches to the same string in tbl (for a literal
+// parsed with a string table of its own)
+void ASTStringExpr::moveTo(StringTable& tbl) noexcept
+{
+	std::string text = mString->getText();
+	mString = tbl.getString(text);
+}
+
+void ASTFuncExpr::addArg(ASTExpr* arg) noexcept
 {
 	mArgs.push_back(arg);
 }
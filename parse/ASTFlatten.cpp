@@ -0,0 +1,239 @@
+//
+//  ASTFlatten.cpp
+//  uscc
+//
+//  Implements the flatten function for every AST node.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#include "ASTNodes.h"
+
+using namespace uscc::parse;
+
+#define AST_FLATTEN(a) FlatAST::NodeId a::flatten(FlatAST& flat) noexcept
+
+// (Children in a braced list are flattened left to right, so
+// they always come out in source order)
+
+// Program/Functions
+AST_FLATTEN(ASTProgram)
+{
+	std::vector<FlatAST::NodeId> children;
+	children.reserve(mFuncs.size());
+	for (auto func : mFuncs)
+	{
+		children.push_back(func->flatten(flat));
+	}
+	return flat.addNode(ASTKind::Program, Type::Void, FlatAST::noData(), children);
+}
+
+AST_FLATTEN(ASTFunction)
+{
+	// The arguments, then the body
+	std::vector<FlatAST::NodeId> children;
+	children.reserve(mArgs.size() + 1);
+	for (auto arg : mArgs)
+	{
+		children.push_back(arg->flatten(flat));
+	}
+	children.push_back(mBody->flatten(flat));
+	return flat.addNode(ASTKind::Function, mReturnType, FlatAST::functionData(*this),
+						children);
+}
+
+AST_FLATTEN(ASTArgDecl)
+{
+	return flat.addNode(ASTKind::ArgDecl, getType(), FlatAST::identData(mIdent));
+}
+
+AST_FLATTEN(ASTArraySub)
+{
+	return flat.addNode(ASTKind::ArraySub, getType(), FlatAST::identData(mIdent),
+						{ mExpr->flatten(flat) });
+}
+
+// Expressions
+AST_FLATTEN(ASTBadExpr)
+{
+	return flat.addNode(ASTKind::BadExpr, mType, FlatAST::noData());
+}
+
+AST_FLATTEN(ASTLogicalAnd)
+{
+	return flat.addNode(ASTKind::LogicalAnd, mType, FlatAST::noData(),
+						{ mLHS->flatten(flat), mRHS->flatten(flat) });
+}
+
+AST_FLATTEN(ASTLogicalOr)
+{
+	return flat.addNode(ASTKind::LogicalOr, mType, FlatAST::noData(),
+						{ mLHS->flatten(flat), mRHS->flatten(flat) });
+}
+
+AST_FLATTEN(ASTBinaryCmpOp)
+{
+	return flat.addNode(ASTKind::BinaryCmpOp, mType, FlatAST::opData(mOp),
+						{ mLHS->flatten(flat), mRHS->flatten(flat) });
+}
+
+AST_FLATTEN(ASTBinaryMathOp)
+{
+	return flat.addNode(ASTKind::BinaryMathOp, mType, FlatAST::opData(mOp),
+						{ mLHS->flatten(flat), mRHS->flatten(flat) });
+}
+
+// Value -->
+AST_FLATTEN(ASTNotExpr)
+{
+	return flat.addNode(ASTKind::NotExpr, mType, FlatAST::noData(),
+						{ mExpr->flatten(flat) });
+}
+
+// Factor -->
+AST_FLATTEN(ASTConstantExpr)
+{
+	return flat.addNode(ASTKind::ConstantExpr, mType, FlatAST::valueData(mValue));
+}
+
+AST_FLATTEN(ASTStringExpr)
+{
+	return flat.addNode(ASTKind::StringExpr, mType, FlatAST::stringData(mString));
+}
+
+AST_FLATTEN(ASTIdentExpr)
+{
+	return flat.addNode(ASTKind::IdentExpr, mType, FlatAST::identData(mIdent));
+}
+
+AST_FLATTEN(ASTArrayExpr)
+{
+	return flat.addNode(ASTKind::ArrayExpr, mType, FlatAST::noData(),
+						{ mArray->flatten(flat) });
+}
+
+AST_FLATTEN(ASTFuncExpr)
+{
+	std::vector<FlatAST::NodeId> children;
+	children.reserve(mArgs.size());
+	for (auto arg : mArgs)
+	{
+		children.push_back(arg->flatten(flat));
+	}
+	return flat.addNode(ASTKind::FuncExpr, mType, FlatAST::identData(mIdent), children);
+}
+
+AST_FLATTEN(ASTIncExpr)
+{
+	return flat.addNode(ASTKind::IncExpr, mType, FlatAST::identData(mIdent));
+}
+
+AST_FLATTEN(ASTDecExpr)
+{
+	return flat.addNode(ASTKind::DecExpr, mType, FlatAST::identData(mIdent));
+}
+
+AST_FLATTEN(ASTAddrOfArray)
+{
+	return flat.addNode(ASTKind::AddrOfArray, mType, FlatAST::noData(),
+						{ mArray->flatten(flat) });
+}
+
+AST_FLATTEN(ASTToIntExpr)
+{
+	return flat.addNode(ASTKind::ToIntExpr, mType, FlatAST::noData(),
+						{ mExpr->flatten(flat) });
+}
+
+AST_FLATTEN(ASTToCharExpr)
+{
+	return flat.addNode(ASTKind::ToCharExpr, mType, FlatAST::noData(),
+						{ mExpr->flatten(flat) });
+}
+
+// Declaration
+AST_FLATTEN(ASTDecl)
+{
+	// The initializer is optional
+	if (mExpr)
+	{
+		return flat.addNode(ASTKind::Decl, Type::Void, FlatAST::identData(mIdent),
+							{ mExpr->flatten(flat) });
+	}
+	return flat.addNode(ASTKind::Decl, Type::Void, FlatAST::identData(mIdent));
+}
+
+// Statements
+AST_FLATTEN(ASTCompoundStmt)
+{
+	// The declarations, then the statements
+	std::vector<FlatAST::NodeId> children;
+	children.reserve(mDecls.size() + mStmts.size());
+	for (auto decl : mDecls)
+	{
+		children.push_back(decl->flatten(flat));
+	}
+	for (auto stmt : mStmts)
+	{
+		children.push_back(stmt->flatten(flat));
+	}
+	return flat.addNode(ASTKind::CompoundStmt, Type::Void, FlatAST::noData(), children);
+}
+
+AST_FLATTEN(ASTAssignStmt)
+{
+	return flat.addNode(ASTKind::AssignStmt, Type::Void, FlatAST::identData(mIdent),
+						{ mExpr->flatten(flat) });
+}
+
+AST_FLATTEN(ASTAssignArrayStmt)
+{
+	return flat.addNode(ASTKind::AssignArrayStmt, Type::Void, FlatAST::noData(),
+						{ mArray->flatten(flat), mExpr->flatten(flat) });
+}
+
+AST_FLATTEN(ASTIfStmt)
+{
+	// The else is optional
+	if (mElseStmt)
+	{
+		return flat.addNode(ASTKind::IfStmt, Type::Void, FlatAST::noData(),
+							{ mExpr->flatten(flat), mThenStmt->flatten(flat),
+							  mElseStmt->flatten(flat) });
+	}
+	return flat.addNode(ASTKind::IfStmt, Type::Void, FlatAST::noData(),
+						{ mExpr->flatten(flat), mThenStmt->flatten(flat) });
+}
+
+AST_FLATTEN(ASTWhileStmt)
+{
+	return flat.addNode(ASTKind::WhileStmt, Type::Void, FlatAST::noData(),
+						{ mExpr->flatten(flat), mLoopStmt->flatten(flat) });
+}
+
+AST_FLATTEN(ASTReturnStmt)
+{
+	// A void return has no expression
+	if (mExpr)
+	{
+		return flat.addNode(ASTKind::ReturnStmt, Type::Void, FlatAST::noData(),
+							{ mExpr->flatten(flat) });
+	}
+	return flat.addNode(ASTKind::ReturnStmt, Type::Void, FlatAST::noData());
+}
+
+AST_FLATTEN(ASTExprStmt)
+{
+	return flat.addNode(ASTKind::ExprStmt, Type::Void, FlatAST::noData(),
+						{ mExpr->flatten(flat) });
+}
+
+AST_FLATTEN(ASTNullStmt)
+{
+	return flat.addNode(ASTKind::NullStmt, Type::Void, FlatAST::noData());
+}
@@ -14,21 +14,30 @@
 //---------------------------------------------------------
 
 #include "ASTNodes.h"
+#include <algorithm>
 
 using namespace uscc::parse;
-using std::shared_ptr;
 
-void ASTProgram::addFunction(shared_ptr<ASTFunction> func) noexcept
+void ASTProgram::addFunction(ASTFunction* func) noexcept
 {
 	mFuncs.push_back(func);
 }
 
 // Add an argument to this function
-void ASTFunction::addArg(shared_ptr<ASTArgDecl> arg) noexcept
+void ASTFunction::addArg(ASTArgDecl* arg) noexcept
 {
 	mArgs.push_back(arg);
 }
 
+// Records that this function calls the function with this identifier
+void ASTFunction::addCallee(Identifier& callee) noexcept
+{
+	if (std::find(mCallees.begin(), mCallees.end(), &callee) == mCallees.end())
+	{
+		mCallees.push_back(&callee);
+	}
+}
+
 // Returns true if the type passed in matches the argument
 // declaration for that particular argument
 bool ASTFunction::checkArgType(unsigned int argNum, Type type) const noexcept
@@ -56,7 +65,7 @@ Type ASTFunction::getArgType(unsigned int argNum) const noexcept
 }
 
 // Set the compound statement body
-void ASTFunction::setBody(shared_ptr<ASTCompoundStmt> body) noexcept
+void ASTFunction::setBody(ASTCompoundStmt* body) noexcept
 {
 	mBody = body;
 }
@@ -5,8 +5,11 @@
 //  Declares all of the AST node classes that are used
 //  by the parser.
 //
-//  Each AST node supports pretty-printing its node
-//  contents as well as generating the LLVM IR.
+//  The parser builds a tree of these nodes (allocated
+//  from its ASTArena, and referring to their children with
+//  plain pointers). Once the parse succeeds, the tree is
+//  flattened into a FlatAST, which is what gets printed
+//  and emitted as LLVM IR.
 //
 //---------------------------------------------------------
 //  Copyright (c) 2014, Sanjay Madhav
@@ -18,42 +21,36 @@
 
 #pragma once
 
-#include <ostream>
 #include <string>
-#include <memory>
-#include <list>
 #include <vector>
 
 #include "Types.h"
 #include "Symbols.h"
+#include "FlatAST.h"
 #include "../scan/Tokens.h"
+#include "../opt/MemReport.h"
 
 // Macro so I don't have to copy/paste over and over
-#define AST_DECL_PRINT_EMIT() \
-virtual void printNode(std::ostream& output, int depth = 0) const noexcept override; \
-virtual llvm::Value* emitIR(CodeContext& ctx) noexcept override;
-
-namespace llvm
-{
-	class Value;
-}
+#define AST_DECL_FLATTEN() \
+virtual FlatAST::NodeId flatten(FlatAST& flat) noexcept override;
 
 namespace uscc
 {
 namespace parse
 {
 
-class CodeContext;
-	
 class ASTNode
 {
 public:
-	virtual void printNode(std::ostream& output, int depth = 0) const noexcept = 0;
-	virtual llvm::Value* emitIR(CodeContext& ctx) noexcept = 0;
-	virtual ~ASTNode() { }
+	// Adds this node (after its children) to flat, and returns its ID
+	virtual FlatAST::NodeId flatten(FlatAST& flat) noexcept = 0;
 protected:
-	ASTNode() { }
-	ASTNode(const ASTNode& copy) { }
+	// Nodes are counted for --mem-report
+	ASTNode() { opt::MemReport::count(opt::MemReport::ASTNodes); }
+	// Only the ASTArena destroys nodes, and it knows their actual type
+	// (leaving this non-virtual lets most nodes skip destruction entirely)
+	~ASTNode() = default;
+	ASTNode(const ASTNode& copy) { opt::MemReport::count(opt::MemReport::ASTNodes); }
 	ASTNode& operator=(const ASTNode& rhs) { return *this; }
 };
 
@@ -62,10 +59,16 @@ class ASTFunction;
 class ASTProgram : public ASTNode
 {
 public:
-	void addFunction(std::shared_ptr<ASTFunction> func) noexcept;
-	AST_DECL_PRINT_EMIT();
+	void addFunction(ASTFunction* func) noexcept;
+	
+	const std::vector<ASTFunction*>& getFunctions() const noexcept
+	{
+		return mFuncs;
+	}
+	
+	AST_DECL_FLATTEN();
 private:
-	std::list<std::shared_ptr<ASTFunction>> mFuncs;
+	std::vector<ASTFunction*> mFuncs;
 };
 	
 // Function AST Nodes
@@ -77,16 +80,17 @@ class ASTFunction : public ASTNode
 {
 public:
 	ASTFunction(Identifier& ident, Type returnType, SymbolTable::ScopeTable& scopeTable) noexcept
-	: mIdent(ident)
+	: mBody(nullptr)
+	, mIdent(ident)
 	, mReturnType(returnType)
 	, mScopeTable(scopeTable)
 	{ }
 	
 	// Add an argument to this function
-	void addArg(std::shared_ptr<ASTArgDecl> arg) noexcept;
+	void addArg(ASTArgDecl* arg) noexcept;
 		
 	// Set the compound statement body
-	void setBody(std::shared_ptr<ASTCompoundStmt> body) noexcept;
+	void setBody(ASTCompoundStmt* body) noexcept;
 	
 	Type getReturnType() const noexcept
 	{
@@ -105,10 +109,36 @@ public:
 	
 	Type getArgType(unsigned int argNum) const noexcept;
 	
-	AST_DECL_PRINT_EMIT();
+	const Identifier& getIdent() const noexcept
+	{
+		return mIdent;
+	}
+	
+	Identifier& getIdent() noexcept
+	{
+		return mIdent;
+	}
+	
+	// Variables declared in this function
+	SymbolTable::ScopeTable& getScopeTable() noexcept
+	{
+		return mScopeTable;
+	}
+	
+	// Records that this function calls the function with this identifier
+	void addCallee(Identifier& callee) noexcept;
+	
+	// Functions this function calls, in the order they're first called
+	const std::vector<Identifier*>& getCallees() const noexcept
+	{
+		return mCallees;
+	}
+	
+	AST_DECL_FLATTEN();
 private:
-	std::shared_ptr<ASTCompoundStmt> mBody;
-	std::vector<std::shared_ptr<ASTArgDecl>> mArgs;
+	ASTCompoundStmt* mBody;
+	std::vector<ASTArgDecl*> mArgs;
+	std::vector<Identifier*> mCallees;
 	Identifier& mIdent;
 	SymbolTable::ScopeTable& mScopeTable;
 	Type mReturnType;
@@ -131,7 +161,7 @@ public:
 		return mIdent;
 	}
 	
-	AST_DECL_PRINT_EMIT();
+	AST_DECL_FLATTEN();
 private:
 	Identifier& mIdent;
 };
@@ -158,7 +188,7 @@ protected:
 class ASTArraySub : public ASTNode
 {
 public:
-	ASTArraySub(Identifier& ident, std::shared_ptr<ASTExpr> expr) noexcept
+	ASTArraySub(Identifier& ident, ASTExpr* expr) noexcept
 	: mIdent(ident)
 	, mExpr(expr)
 	{ }
@@ -168,10 +198,10 @@ public:
 		return mIdent.getType();
 	}
 	
-	AST_DECL_PRINT_EMIT();
+	AST_DECL_FLATTEN();
 private:
 	Identifier& mIdent;
-	std::shared_ptr<ASTExpr> mExpr;
+	ASTExpr* mExpr;
 };
 
 // "Bad" expr is returned if a () subexpr fails, so at least
@@ -179,18 +209,23 @@ private:
 class ASTBadExpr : public ASTExpr
 {
 public:
-	AST_DECL_PRINT_EMIT();
+	AST_DECL_FLATTEN();
 };
 
 class ASTLogicalAnd : public ASTExpr
 {
 public:
+	ASTLogicalAnd() noexcept
+	: mLHS(nullptr)
+	, mRHS(nullptr)
+	{ }
+	
 	// We need to be able to manually set the lhs/rhs
-	void setLHS(std::shared_ptr<ASTExpr> lhs) noexcept
+	void setLHS(ASTExpr* lhs) noexcept
 	{
 		mLHS = lhs;
 	}
-	void setRHS(std::shared_ptr<ASTExpr> rhs) noexcept
+	void setRHS(ASTExpr* rhs) noexcept
 	{
 		mRHS = rhs;
 	}
@@ -201,21 +236,26 @@ public:
 	// Returns false if this is an invalid operation.
 	bool finalizeOp() noexcept;
 	
-	AST_DECL_PRINT_EMIT();
+	AST_DECL_FLATTEN();
 private:
-	std::shared_ptr<ASTExpr> mLHS;
-	std::shared_ptr<ASTExpr> mRHS;
+	ASTExpr* mLHS;
+	ASTExpr* mRHS;
 };
 
 class ASTLogicalOr : public ASTExpr
 {
 public:
+	ASTLogicalOr() noexcept
+	: mLHS(nullptr)
+	, mRHS(nullptr)
+	{ }
+	
 	// We need to be able to manually set the lhs/rhs
-	void setLHS(std::shared_ptr<ASTExpr> lhs) noexcept
+	void setLHS(ASTExpr* lhs) noexcept
 	{
 		mLHS = lhs;
 	}
-	void setRHS(std::shared_ptr<ASTExpr> rhs) noexcept
+	void setRHS(ASTExpr* rhs) noexcept
 	{
 		mRHS = rhs;
 	}
@@ -226,10 +266,10 @@ public:
 	// Returns false if this is an invalid operation.
 	bool finalizeOp() noexcept;
 	
-	AST_DECL_PRINT_EMIT();
+	AST_DECL_FLATTEN();
 private:
-	std::shared_ptr<ASTExpr> mLHS;
-	std::shared_ptr<ASTExpr> mRHS;
+	ASTExpr* mLHS;
+	ASTExpr* mRHS;
 };
 
 class ASTBinaryCmpOp : public ASTExpr
@@ -237,14 +277,16 @@ class ASTBinaryCmpOp : public ASTExpr
 public:
 	ASTBinaryCmpOp(scan::Token::Tokens op) noexcept
 	: mOp(op)
+	, mLHS(nullptr)
+	, mRHS(nullptr)
 	{ }
 	
 	// We need to be able to manually set the lhs/rhs
-	void setLHS(std::shared_ptr<ASTExpr> lhs) noexcept
+	void setLHS(ASTExpr* lhs) noexcept
 	{
 		mLHS = lhs;
 	}
-	void setRHS(std::shared_ptr<ASTExpr> rhs) noexcept
+	void setRHS(ASTExpr* rhs) noexcept
 	{
 		mRHS = rhs;
 	}
@@ -255,11 +297,11 @@ public:
 	// Returns false if this is an invalid operation.
 	bool finalizeOp() noexcept;
 	
-	AST_DECL_PRINT_EMIT();
+	AST_DECL_FLATTEN();
 private:
 	scan::Token::Tokens mOp;
-	std::shared_ptr<ASTExpr> mLHS;
-	std::shared_ptr<ASTExpr> mRHS;
+	ASTExpr* mLHS;
+	ASTExpr* mRHS;
 };
 	
 class ASTBinaryMathOp : public ASTExpr
@@ -267,14 +309,16 @@ class ASTBinaryMathOp : public ASTExpr
 public:
 	ASTBinaryMathOp(scan::Token::Tokens op) noexcept
 	: mOp(op)
+	, mLHS(nullptr)
+	, mRHS(nullptr)
 	{ }
 	
 	// We need to be able to manually set the lhs/rhs
-	void setLHS(std::shared_ptr<ASTExpr> lhs) noexcept
+	void setLHS(ASTExpr* lhs) noexcept
 	{
 		mLHS = lhs;
 	}
-	void setRHS(std::shared_ptr<ASTExpr> rhs) noexcept
+	void setRHS(ASTExpr* rhs) noexcept
 	{
 		mRHS = rhs;
 	}
@@ -286,11 +330,11 @@ public:
 	// Returns false if this is an invalid operation.
 	bool finalizeOp() noexcept;
 	
-	AST_DECL_PRINT_EMIT();
+	AST_DECL_FLATTEN();
 private:
 	scan::Token::Tokens mOp;
-	std::shared_ptr<ASTExpr> mLHS;
-	std::shared_ptr<ASTExpr> mRHS;
+	ASTExpr* mLHS;
+	ASTExpr* mRHS;
 };
 
 // Value -->
@@ -299,14 +343,14 @@ private:
 class ASTNotExpr : public ASTExpr
 {
 public:
-	ASTNotExpr(std::shared_ptr<ASTExpr> expr) noexcept
+	ASTNotExpr(ASTExpr* expr) noexcept
 	: mExpr(expr)
 	{
 		mType = mExpr->getType();
 	}
-	AST_DECL_PRINT_EMIT();
+	AST_DECL_FLATTEN();
 private:
-	std::shared_ptr<ASTExpr> mExpr;
+	ASTExpr* mExpr;
 };
 	
 // Factor -->
@@ -330,7 +374,7 @@ public:
 		mType = Type::Char;
 	}
 	
-	AST_DECL_PRINT_EMIT();
+	AST_DECL_FLATTEN();
 private:
 	int mValue;
 };
@@ -344,7 +388,11 @@ public:
 		return mString->getText().size();
 	}
 	
-	AST_DECL_PRINT_EMIT();
+	// Switches to the same string in tbl (for a literal
+	// parsed with a string table of its own)
+	void moveTo(StringTable& tbl) noexcept;
+	
+	AST_DECL_FLATTEN();
 private:
 	ConstStr* mString;
 };
@@ -357,7 +405,7 @@ public:
 	{
 		mType = mIdent.getType();
 	}
-	AST_DECL_PRINT_EMIT();
+	AST_DECL_FLATTEN();
 private:
 	Identifier& mIdent;
 };
@@ -366,7 +414,7 @@ private:
 class ASTArrayExpr : public ASTExpr
 {
 public:
-	ASTArrayExpr(std::shared_ptr<ASTArraySub> array) noexcept
+	ASTArrayExpr(ASTArraySub* array) noexcept
 	: mArray(array)
 	{
 		if (mArray->getType() == Type::IntArray)
@@ -378,9 +426,9 @@ public:
 			mType = Type::Char;
 		}
 	}
-	AST_DECL_PRINT_EMIT();
+	AST_DECL_FLATTEN();
 private:
-	std::shared_ptr<ASTArraySub> mArray;
+	ASTArraySub* mArray;
 };
 
 // id ( FuncCallArgs )
@@ -400,16 +448,16 @@ public:
 		}
 	}
 	
-	void addArg(std::shared_ptr<ASTExpr> arg) noexcept;
+	void addArg(ASTExpr* arg) noexcept;
 	size_t getNumArgs() const noexcept
 	{
 		return mArgs.size();
 	}
 	
-	AST_DECL_PRINT_EMIT();
+	AST_DECL_FLATTEN();
 private:
 	Identifier& mIdent;
-	std::list<std::shared_ptr<ASTExpr>> mArgs;
+	std::vector<ASTExpr*> mArgs;
 };
 
 // ++ id
@@ -421,7 +469,7 @@ public:
 	{
 		mType = mIdent.getType();
 	}
-	AST_DECL_PRINT_EMIT();
+	AST_DECL_FLATTEN();
 private:
 	Identifier& mIdent;
 };
@@ -435,7 +483,7 @@ public:
 	{
 		mType = mIdent.getType();
 	}
-	AST_DECL_PRINT_EMIT();
+	AST_DECL_FLATTEN();
 private:
 	Identifier& mIdent;
 };
@@ -443,68 +491,68 @@ private:
 class ASTAddrOfArray : public ASTExpr
 {
 public:
-	ASTAddrOfArray(std::shared_ptr<ASTArraySub> array) noexcept
+	ASTAddrOfArray(ASTArraySub* array) noexcept
 	: mArray(array)
 	{
 		mType = mArray->getType();
 	}
-	AST_DECL_PRINT_EMIT();
+	AST_DECL_FLATTEN();
 private:
-	std::shared_ptr<ASTArraySub> mArray;
+	ASTArraySub* mArray;
 };
 
 // Used for type conversion from char to int
 class ASTToIntExpr : public ASTExpr
 {
 public:
-	ASTToIntExpr(std::shared_ptr<ASTExpr> expr) noexcept
+	ASTToIntExpr(ASTExpr* expr) noexcept
 	: mExpr(expr)
 	{
 		mType = Type::Int;
 	}
 	
-	std::shared_ptr<ASTExpr> getChild() noexcept
+	ASTExpr* getChild() noexcept
 	{
 		return mExpr;
 	}
 	
-	AST_DECL_PRINT_EMIT();
+	AST_DECL_FLATTEN();
 private:
-	std::shared_ptr<ASTExpr> mExpr;
+	ASTExpr* mExpr;
 };
 
 // Used for type conversion from int to char
 class ASTToCharExpr : public ASTExpr
 {
 public:
-	ASTToCharExpr(std::shared_ptr<ASTExpr> expr) noexcept
+	ASTToCharExpr(ASTExpr* expr) noexcept
 	: mExpr(expr)
 	{
 		mType = Type::Char;
 	}
 	
-	std::shared_ptr<ASTExpr> getChild() noexcept
+	ASTExpr* getChild() noexcept
 	{
 		return mExpr;
 	}
 	
-	AST_DECL_PRINT_EMIT();
+	AST_DECL_FLATTEN();
 private:
-	std::shared_ptr<ASTExpr> mExpr;
+	ASTExpr* mExpr;
 };
 
 // Declaration Node
 class ASTDecl : public ASTNode
 {
 public:
-	ASTDecl(Identifier& ident, std::shared_ptr<ASTExpr> expr = nullptr) noexcept
+	ASTDecl(Identifier& ident, ASTExpr* expr = nullptr) noexcept
 	: mIdent(ident)
 	, mExpr(expr)
 	{ }
-	AST_DECL_PRINT_EMIT();
+	AST_DECL_FLATTEN();
 private:
 	Identifier& mIdent;
-	std::shared_ptr<ASTExpr> mExpr;
+	ASTExpr* mExpr;
 };
 	
 // Statement AST Nodes
@@ -516,96 +564,96 @@ class ASTStmt : public ASTNode
 class ASTCompoundStmt : public ASTStmt
 {
 public:
-	AST_DECL_PRINT_EMIT();
-	void addDecl(std::shared_ptr<ASTDecl> decl) noexcept;
-	void addStmt(std::shared_ptr<ASTStmt> stmt) noexcept;
-	std::shared_ptr<ASTStmt> getLastStmt() noexcept;
+	AST_DECL_FLATTEN();
+	void addDecl(ASTDecl* decl) noexcept;
+	void addStmt(ASTStmt* stmt) noexcept;
+	ASTStmt* getLastStmt() noexcept;
 private:
-	std::list<std::shared_ptr<ASTDecl>> mDecls;
-	std::list<std::shared_ptr<ASTStmt>> mStmts;
+	std::vector<ASTDecl*> mDecls;
+	std::vector<ASTStmt*> mStmts;
 };
 
 class ASTAssignStmt : public ASTStmt
 {
 public:
-	ASTAssignStmt(Identifier& ident, std::shared_ptr<ASTExpr> expr) noexcept
+	ASTAssignStmt(Identifier& ident, ASTExpr* expr) noexcept
 	: mIdent(ident)
 	, mExpr(expr)
 	{ }
-	AST_DECL_PRINT_EMIT();
+	AST_DECL_FLATTEN();
 private:
 	Identifier& mIdent;
-	std::shared_ptr<ASTExpr> mExpr;
+	ASTExpr* mExpr;
 };
 	
 class ASTAssignArrayStmt : public ASTStmt
 {
 public:
-	ASTAssignArrayStmt(std::shared_ptr<ASTArraySub> array,
-					   std::shared_ptr<ASTExpr> expr) noexcept
+	ASTAssignArrayStmt(ASTArraySub* array,
+					   ASTExpr* expr) noexcept
 	: mArray(array)
 	, mExpr(expr)
 	{ }
-	AST_DECL_PRINT_EMIT();
+	AST_DECL_FLATTEN();
 private:
-	std::shared_ptr<ASTArraySub> mArray;
-	std::shared_ptr<ASTExpr> mExpr;
+	ASTArraySub* mArray;
+	ASTExpr* mExpr;
 };
 
 class ASTIfStmt : public ASTStmt
 {
 public:
-	ASTIfStmt(std::shared_ptr<ASTExpr> expr, std::shared_ptr<ASTStmt> thenStmt,
-			  std::shared_ptr<ASTStmt> elseStmt = nullptr) noexcept
+	ASTIfStmt(ASTExpr* expr, ASTStmt* thenStmt,
+			  ASTStmt* elseStmt = nullptr) noexcept
 	: mExpr(expr)
 	, mThenStmt(thenStmt)
 	, mElseStmt(elseStmt)
 	{ }
-	AST_DECL_PRINT_EMIT();
+	AST_DECL_FLATTEN();
 private:
-	std::shared_ptr<ASTExpr> mExpr;
-	std::shared_ptr<ASTStmt> mThenStmt;
-	std::shared_ptr<ASTStmt> mElseStmt;
+	ASTExpr* mExpr;
+	ASTStmt* mThenStmt;
+	ASTStmt* mElseStmt;
 };
 
 class ASTWhileStmt : public ASTStmt
 {
 public:
-	ASTWhileStmt(std::shared_ptr<ASTExpr> expr, std::shared_ptr<ASTStmt> loopStmt) noexcept
+	ASTWhileStmt(ASTExpr* expr, ASTStmt* loopStmt) noexcept
 	: mExpr(expr)
 	, mLoopStmt(loopStmt)
 	{ }
-	AST_DECL_PRINT_EMIT();
+	AST_DECL_FLATTEN();
 private:
-	std::shared_ptr<ASTExpr> mExpr;
-	std::shared_ptr<ASTStmt> mLoopStmt;
+	ASTExpr* mExpr;
+	ASTStmt* mLoopStmt;
 };
 	
 class ASTReturnStmt : public ASTStmt
 {
 public:
-	ASTReturnStmt(std::shared_ptr<ASTExpr> expr) noexcept
+	ASTReturnStmt(ASTExpr* expr) noexcept
 	: mExpr(expr)
 	{ }
-	AST_DECL_PRINT_EMIT();
+	AST_DECL_FLATTEN();
 private:
-	std::shared_ptr<ASTExpr> mExpr;
+	ASTExpr* mExpr;
 };
 
 class ASTExprStmt : public ASTStmt
 {
 public:
-	ASTExprStmt(std::shared_ptr<ASTExpr> expr) noexcept
+	ASTExprStmt(ASTExpr* expr) noexcept
 	: mExpr(expr)
 	{ }
-	AST_DECL_PRINT_EMIT();
+	AST_DECL_FLATTEN();
 private:
-	std::shared_ptr<ASTExpr> mExpr;
+	ASTExpr* mExpr;
 };
 
 class ASTNullStmt : public ASTStmt
 {
-	AST_DECL_PRINT_EMIT();
+	AST_DECL_FLATTEN();
 };
 
 
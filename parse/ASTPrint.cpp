@@ -1,8 +1,8 @@
 //
-//  ASTNodes.cpp
+//  ASTPrint.cpp
 //  uscc
 //
-//  Implements the printNode function for every AST node
+//  Implements printing every kind of node in the FlatAST
 //
 //---------------------------------------------------------
 //  Copyright (c) 2014, Sanjay Madhav
@@ -13,32 +13,72 @@
 //---------------------------------------------------------
 
 #include "ASTNodes.h"
-#include "Symbols.h"
+#include "ASTVisitor.h"
 
 using namespace uscc::parse;
 using namespace uscc::scan;
 
-using std::shared_ptr;
+namespace uscc
+{
+namespace parse
+{
+namespace
+{
+
+class ASTPrinter : public ASTVisitor<ASTPrinter, void, int>
+{
+public:
+	ASTPrinter(const FlatAST& ast, std::ostream& output) noexcept
+	: ASTVisitor(ast)
+	, mOutput(output)
+	{ }
+	
+	#define AST_KIND(a) void visit##a(FlatAST::NodeId node, int depth);
+	#include "ASTKinds.def"
+	#undef AST_KIND
+	
+private:
+	// Prints each child one level deeper
+	void printChildren(FlatAST::NodeId node, int depth)
+	{
+		for (const FlatAST::NodeId* child = mAST.childBegin(node);
+			 child != mAST.childEnd(node); ++child)
+		{
+			visit(*child, depth + 1);
+		}
+	}
+	
+	std::ostream& mOutput;
+};
+
+} // anonymous
+} // parse
+} // uscc
+
+// Prints the subtree rooted at node
+void uscc::parse::printAST(const FlatAST& ast, FlatAST::NodeId node, std::ostream& output)
+{
+	ASTPrinter printer(ast, output);
+	printer.visit(node, 0);
+}
 
 // DON'T TRY THIS AT HOME
-#define AST_PRINT(a) void a::printNode(std::ostream& output, int depth) const noexcept \
+#define AST_PRINT(a) void ASTPrinter::visit##a(FlatAST::NodeId node, int depth) \
 { \
+std::ostream& output = mOutput; \
 for (int i = 0; i < depth; i++) \
 { \
 	output << "---"; \
 }
 
-AST_PRINT(ASTProgram)
+AST_PRINT(Program)
 	output << "Program:" << std::endl;
-	for (auto func : mFuncs)
-	{
-		func->printNode(output, depth + 1);
-	}
+	printChildren(node, depth);
 }
 
-AST_PRINT(ASTFunction)
+AST_PRINT(Function)
 	output << "Function: ";
-	switch (mReturnType)
+	switch (mAST.getType(node))
 	{
 		case Type::Void:
 			output << "void ";
@@ -53,19 +93,16 @@ AST_PRINT(ASTFunction)
 			output <<  "Shouldn't have gotten here. ";
 			break;
 	}
-	output << mIdent.getName() << std::endl;
+	output << mAST.getFunction(node).getIdent().getName() << std::endl;
 
-	for (auto arg : mArgs)
-	{
-		arg->printNode(output, depth + 1);
-	}
-	
-	mBody->printNode(output, depth + 1);
+	// The arguments, then the body
+	printChildren(node, depth);
 }
 
-AST_PRINT(ASTArgDecl)
+AST_PRINT(ArgDecl)
+	const Identifier& ident = mAST.getIdent(node);
 	output << "ArgDecl: ";
-	switch (mIdent.getType())
+	switch (ident.getType())
 	{
 		case Type::Void:
 			output << "void ";
@@ -86,102 +123,96 @@ AST_PRINT(ASTArgDecl)
 			output << "Shouldn't have gotten here...";
 			break;
 	}
-	output << mIdent.getName() << std::endl;
+	output << ident.getName() << std::endl;
 }
 
-AST_PRINT(ASTArraySub)
-	output << "ArraySub: " << mIdent.getName() << std::endl;
-	mExpr->printNode(output, depth + 1);
+AST_PRINT(ArraySub)
+	output << "ArraySub: " << mAST.getIdent(node).getName() << std::endl;
+	printChildren(node, depth);
 }
 
 // Expressions
-AST_PRINT(ASTBadExpr)
+AST_PRINT(BadExpr)
 	output << "BadExpr:" <<std::endl;
 }
 
-AST_PRINT(ASTLogicalAnd)
+AST_PRINT(LogicalAnd)
 	output << "LogicalAnd: " << std::endl;
-	mLHS->printNode(output, depth + 1);
-	mRHS->printNode(output, depth + 1);
+	printChildren(node, depth);
 }
 
-AST_PRINT(ASTLogicalOr)
+AST_PRINT(LogicalOr)
 	output << "LogicalOr: " << std::endl;
-	mLHS->printNode(output, depth + 1);
-	mRHS->printNode(output, depth + 1);
+	printChildren(node, depth);
 }
 
-AST_PRINT(ASTBinaryCmpOp)
-output << "BinaryCmp " << Token::Values[mOp] << ':' << std::endl;
-	mLHS->printNode(output, depth + 1);
-	mRHS->printNode(output, depth + 1);
+AST_PRINT(BinaryCmpOp)
+output << "BinaryCmp " << Token::Values[mAST.getOp(node)] << ':' << std::endl;
+	printChildren(node, depth);
 }
 
-AST_PRINT(ASTBinaryMathOp)
-	output << "BinaryMath " << Token::Values[mOp] << ':' << std::endl;
-	mLHS->printNode(output, depth + 1);
-	mRHS->printNode(output, depth + 1);
+AST_PRINT(BinaryMathOp)
+	output << "BinaryMath " << Token::Values[mAST.getOp(node)] << ':' << std::endl;
+	printChildren(node, depth);
 }
 
 // Value -->
-AST_PRINT(ASTNotExpr)
+AST_PRINT(NotExpr)
 	output << "NotExpr:" << std::endl;
-	mExpr->printNode(output, depth + 1);
+	printChildren(node, depth);
 }
 
 // Factor -->
-AST_PRINT(ASTConstantExpr)
-	output << "ConstantExpr: " << mValue << std::endl;
+AST_PRINT(ConstantExpr)
+	output << "ConstantExpr: " << mAST.getValue(node) << std::endl;
 }
 
-AST_PRINT(ASTStringExpr)
-	output << "StringExpr: " << mString->getText() << std::endl;
+AST_PRINT(StringExpr)
+	output << "StringExpr: " << mAST.getString(node)->getText() << std::endl;
 }
 
-AST_PRINT(ASTIdentExpr)
-	output << "IdentExpr: " << mIdent.getName() << std::endl;
+AST_PRINT(IdentExpr)
+	output << "IdentExpr: " << mAST.getIdent(node).getName() << std::endl;
 }
 
-AST_PRINT(ASTArrayExpr)
+AST_PRINT(ArrayExpr)
 	output << "ArrayExpr: " << std::endl;
-	mArray->printNode(output, depth + 1);
+	printChildren(node, depth);
 }
 
-AST_PRINT(ASTFuncExpr)
-output << "FuncExpr: " << mIdent.getName() << std::endl;
-	for (auto arg : mArgs)
-	{
-		arg->printNode(output, depth + 1);
-	}
+AST_PRINT(FuncExpr)
+output << "FuncExpr: " << mAST.getIdent(node).getName() << std::endl;
+	printChildren(node, depth);
 }
 
-AST_PRINT(ASTIncExpr)
-	output << "IncExpr: " << mIdent.getName() << std::endl;
+AST_PRINT(IncExpr)
+	output << "IncExpr: " << mAST.getIdent(node).getName() << std::endl;
 }
 
-AST_PRINT(ASTDecExpr)
-	output << "DecExpr: " << mIdent.getName() << std::endl;
+AST_PRINT(DecExpr)
+	output << "DecExpr: " << mAST.getIdent(node).getName() << std::endl;
 }
 
-AST_PRINT(ASTAddrOfArray)
+AST_PRINT(AddrOfArray)
 	output << "AddrOfArray:" << std::endl;
-	mArray->printNode(output, depth + 1);
+	printChildren(node, depth);
 }
 			
-AST_PRINT(ASTToIntExpr)
+AST_PRINT(ToIntExpr)
 	output << "ToIntExpr: " << std::endl;
-	mExpr->printNode(output, depth + 1);
+	printChildren(node, depth);
 }
 			
-AST_PRINT(ASTToCharExpr)
+AST_PRINT(ToCharExpr)
 	output << "ToCharExpr: " << std::endl;
-	mExpr->printNode(output, depth + 1);
+	printChildren(node, depth);
 }
 
 // Declaration
-AST_PRINT(ASTDecl)
+AST_PRINT(Decl)
+	const Identifier& ident = mAST.getIdent(node);
 	output << "Decl: ";
-	switch (mIdent.getType())
+	switch (ident.getType())
 	{
 		case Type::Void:
 			output << "void";
@@ -193,79 +224,65 @@ AST_PRINT(ASTDecl)
 			output << "char";
 			break;
 		case Type::IntArray:
-			output << "int[" << mIdent.getArrayCount() << ']';
+			output << "int[" << ident.getArrayCount() << ']';
 			break;
 		case Type::CharArray:
-			output << "char[" << mIdent.getArrayCount() << ']';
+			output << "char[" << ident.getArrayCount() << ']';
 			break;
 		default:
 			output << "Shouldn't have gotten here...";
 			break;
 	}
-	output << ' ' << mIdent.getName() << std::endl;
-	if (mExpr)
-	{
-		mExpr->printNode(output, depth + 1);
-	}
+	output << ' ' << ident.getName() << std::endl;
+	// The initializer (if any)
+	printChildren(node, depth);
 }
 
 // Statements
-AST_PRINT(ASTCompoundStmt)
+AST_PRINT(CompoundStmt)
 	output << "CompoundStmt:" << std::endl;
-	for (auto decl : mDecls)
-	{
-		decl->printNode(output, depth + 1);
-	}
-	for (auto stmt : mStmts)
-	{
-		stmt->printNode(output, depth + 1);
-	}
+	// The declarations, then the statements
+	printChildren(node, depth);
 }
 
-AST_PRINT(ASTReturnStmt)
-	if (!mExpr)
+AST_PRINT(ReturnStmt)
+	if (mAST.getNumChildren(node) == 0)
 	{
 		output << "ReturnStmt: (empty)" << std::endl;
 	}
 	else
 	{
 		output << "ReturnStmt:" << std::endl;
-		mExpr->printNode(output, depth + 1);
+		printChildren(node, depth);
 	}
 }
 
-AST_PRINT(ASTAssignStmt)
-	output << "AssignStmt: " << mIdent.getName() << std::endl;
-	mExpr->printNode(output, depth + 1);
+AST_PRINT(AssignStmt)
+	output << "AssignStmt: " << mAST.getIdent(node).getName() << std::endl;
+	printChildren(node, depth);
 }
 
-AST_PRINT(ASTAssignArrayStmt)
+AST_PRINT(AssignArrayStmt)
 	output << "AssignArrayStmt:" << std::endl;
-	mArray->printNode(output, depth + 1);
-	mExpr->printNode(output, depth + 1);
+	printChildren(node, depth);
 }
 
-AST_PRINT(ASTIfStmt)
+AST_PRINT(IfStmt)
 	output << "IfStmt: " << std::endl;
-	mExpr->printNode(output, depth + 1);
-	mThenStmt->printNode(output, depth + 1);
-	if (mElseStmt)
-	{
-		mElseStmt->printNode(output, depth + 1);
-	}
+	// The condition, the then statement, and the else (if any)
+	printChildren(node, depth);
 }
 
-AST_PRINT(ASTWhileStmt)
+AST_PRINT(WhileStmt)
 	output << "WhileStmt" << std::endl;
-	mExpr->printNode(output, depth + 1);
-	mLoopStmt->printNode(output, depth + 1);
+	printChildren(node, depth);
 }
 
-AST_PRINT(ASTExprStmt)
+AST_PRINT(ExprStmt)
 	output << "ExprStmt" << std::endl;
-	mExpr->printNode(output, depth + 1);
+	printChildren(node, depth);
 }
 
-AST_PRINT(ASTNullStmt)
+AST_PRINT(NullStmt)
 	output << "NullStmt" << std::endl;
 }
@@ -0,0 +1,60 @@
+//
+//  ASTVisitor.h
+//  uscc
+//
+//  Declares the base class for passes over the FlatAST.
+//
+//  A visitor derives from ASTVisitor<Derived, RetVal, Arg>
+//  and defines a visit function for every kind in
+//  ASTKinds.def, e.g.
+//
+//    RetVal visitIfStmt(FlatAST::NodeId node, Arg arg);
+//
+//  visit(node, arg) then calls the right one with a switch
+//  on the node's kind, rather than a virtual call.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#pragma once
+
+#include "FlatAST.h"
+
+namespace uscc
+{
+namespace parse
+{
+
+template <typename Derived, typename RetVal, typename Arg>
+class ASTVisitor
+{
+public:
+	ASTVisitor(const FlatAST& ast) noexcept
+	: mAST(ast)
+	{ }
+	
+	RetVal visit(FlatAST::NodeId node, Arg arg)
+	{
+		Derived& derived = static_cast<Derived&>(*this);
+		switch (mAST.getKind(node))
+		{
+			#define AST_KIND(a) case ASTKind::a: return derived.visit##a(node, arg);
+			#include "ASTKinds.def"
+			#undef AST_KIND
+		}
+		
+		// Every kind is handled above
+		return RetVal();
+	}
+	
+protected:
+	const FlatAST& mAST;
+};
+
+} // parse
+} // uscc
@@ -16,6 +16,8 @@
 
 #include "Emitter.h"
 #include "Parse.h"
+#include "Session.h"
+#include "FunctionCache.h"
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wconversion"
@@ -25,6 +27,7 @@
 #include <llvm/IR/LegacyPassManager.h>
 #include <llvm/Bitcode/BitcodeWriterPass.h>
 #include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/raw_os_ostream.h>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Constants.h>
 #include <llvm/IR/Verifier.h>
@@ -41,14 +44,21 @@
 #include <llvm/Support//FileSystem.h>
 #include <llvm/Support/SourceMgr.h>
 #include <llvm/MC/SubtargetFeature.h>
+#include <llvm/Linker/Linker.h>
+#include <llvm/ExecutionEngine/ExecutionEngine.h>
+#include <llvm/ExecutionEngine/MCJIT.h>
+#include <llvm/Support/DynamicLibrary.h>
 #include "../opt/Passes.h"
 #pragma clang diagnostic pop
+#include <mutex>
+#include <cstdio>
 
 using namespace uscc::parse;
 using namespace llvm;
 
-CodeContext::CodeContext(StringTable& strings)
-: mGlobal(getGlobalContext())
+CodeContext::CodeContext(Session& session, StringTable& strings)
+: mSession(session)
+, mGlobal(session.getContext())
 , mModule(nullptr)
 , mBlock(nullptr)
 , mStrings(strings)
@@ -59,8 +69,9 @@ CodeContext::CodeContext(StringTable& strings)
 	
 }
 
-Emitter::Emitter(Parser& parser) noexcept
-: mContext(parser.mStrings)
+Emitter::Emitter(Parser& parser, Session& session, FunctionCache* cache) noexcept
+: mContext(session, parser.mStrings)
+, mCache(cache)
 {
 	if (parser.mNeedPrintf)
 	{
@@ -70,21 +81,123 @@ Emitter::Emitter(Parser& parser) noexcept
 	// Initialize zero
 	mContext.mZero = Constant::getNullValue(IntegerType::getInt32Ty(mContext.mGlobal));
 	
+	if (mCache)
+	{
+		// Functions with an entry in the cache are only declared,
+		// and everything else is emitted as usual
+		const FlatAST& ast = parser.mFlat;
+		for (const FlatAST::NodeId* node = ast.childBegin(ast.getRoot());
+			 node != ast.childEnd(ast.getRoot()); ++node)
+		{
+			ASTFunction& func = ast.getFunction(*node);
+			const std::string& name = func.getIdent().getName();
+			mFunctionNames.push_back(name);
+			
+			std::string key = mCache->computeKey(ast, *node);
+			std::unique_ptr<Module> cached = mCache->load(key, mContext.mGlobal);
+			if (cached)
+			{
+				mContext.mDeclareOnly.insert(&func);
+				mCachedModules.emplace_back(key, std::move(cached));
+			}
+			else
+			{
+				mNewFunctions.emplace_back(name, key);
+			}
+		}
+	}
+	
 	// This is what kicks off the generation of the LLVM IR from the AST
-	parser.mRoot->emitIR(mContext);
+	emitAST(parser.mFlat, mContext);
 }
 
-void Emitter::optimize() noexcept
+Emitter::~Emitter()
+{
+	
+}
+
+void Emitter::optimize(uscc::opt::TimeReport* timeReport) noexcept
 {
 	legacy::PassManager pm;
-	uscc::opt::registerOptPasses(pm);
+	uscc::opt::registerOptPasses(pm, timeReport);
 	pm.run(*mContext.mModule);
 }
 
-void Emitter::print() noexcept
+bool Emitter::linkCached(std::string& err) noexcept
 {
+	if (!mCache)
+	{
+		return true;
+	}
+	
+	Module* module = mContext.mModule;
+	
+	// Strings only used by the cached functions are dead in this module
+	// (each cached module brings its own copy)
+	Module::global_iterator iter = module->global_begin();
+	while (iter != module->global_end())
+	{
+		GlobalVariable* var = iter++;
+		if (var->hasPrivateLinkage() && var->use_empty())
+		{
+			var->eraseFromParent();
+		}
+	}
+	
+	for (auto& cached : mCachedModules)
+	{
+		if (Linker::LinkModules(module, cached.second.get(), Linker::DestroySource, &err))
+		{
+			mCache->remove(cached.first);
+			mCachedModules.clear();
+			return false;
+		}
+	}
+	mCachedModules.clear();
+	
+	// Linking appends the cached definitions, so put the
+	// functions back in source order
+	for (auto& name : mFunctionNames)
+	{
+		Function* func = module->getFunction(name);
+		if (func)
+		{
+			module->getFunctionList().remove(func);
+			module->getFunctionList().push_back(func);
+		}
+	}
+	
+	return true;
+}
+
+uint64_t Emitter::storeCached() noexcept
+{
+	uint64_t retVal = 0;
+	if (!mCache)
+	{
+		return retVal;
+	}
+	
+	// Each entry only copies its own function (and declares
+	// its callees), so the linked in definitions aren't stored
+	Module* module = mContext.mModule;
+	for (auto& entry : mNewFunctions)
+	{
+		Function* func = module->getFunction(entry.first);
+		if (func && !func->isDeclaration())
+		{
+			retVal += mCache->store(entry.second, *func);
+		}
+	}
+	mNewFunctions.clear();
+	return retVal;
+}
+
+void Emitter::print(std::ostream& output) noexcept
+{
+	raw_os_ostream out(output);
 	legacy::PassManager pm;
-	pm.add(createPrintModulePass(outs()));
+	pm.add(createPrintModulePass(out));
 	pm.run(*mContext.mModule);
 }
 
@@ -102,10 +215,129 @@ bool Emitter::verify() noexcept
 	return !verifyModule(*mContext.mModule);
 }
 
-// This function will take the bitcode emitted by uscc and convert it to assembly
-bool Emitter::writeAsm(const char *fileName) noexcept
+// Compiles the module for the host (or for arch, if it isn't empty)
+// and writes an assembly file, or an object file if assembly is false.
+bool Emitter::writeNative(const char* fileName, bool assembly, const std::string& arch,
+						  const std::string& cpu, std::string& err) noexcept
 {
-	// 11/20/2014 - This function removed because it doesn't work with LLVM 3.5.0...
+	// Only the native target is linked in, so -march can select
+	// between its variants (such as x86 and x86-64)
+	static std::once_flag initFlag;
+	std::call_once(initFlag, []()
+	{
+		InitializeNativeTarget();
+		InitializeNativeTargetAsmPrinter();
+	});
+	
+	Module* module = mContext.mModule;
+	Triple triple(sys::getDefaultTargetTriple());
+	const Target* target = TargetRegistry::lookupTarget(arch, triple, err);
+	if (target == nullptr)
+	{
+		return false;
+	}
+	
+	// With "native", use the host CPU and whatever features it reports
+	std::string cpuName = cpu;
+	std::string features;
+	if (cpu == "native")
+	{
+		cpuName = sys::getHostCPUName();
+		StringMap<bool> hostFeatures;
+		if (sys::getHostCPUFeatures(hostFeatures))
+		{
+			SubtargetFeatures featureList;
+			for (auto& feature : hostFeatures)
+			{
+				featureList.AddFeature(feature.first(), feature.second);
+			}
+			features = featureList.getString();
+		}
+	}
+	
+	TargetOptions targetOptions;
+	std::unique_ptr<TargetMachine> machine(
+		target->createTargetMachine(triple.getTriple(), cpuName, features,
+									targetOptions, Reloc::PIC_, CodeModel::Default,
+									CodeGenOpt::Default));
+	if (!machine)
+	{
+		err = "unable to create a target machine for " + triple.getTriple();
+		return false;
+	}
+	
+	module->setTargetTriple(triple.getTriple());
+	module->setDataLayout(machine->getDataLayout());
+	
+	tool_output_file out(fileName, err, assembly ? sys::fs::F_Text : sys::fs::F_None);
+	if (!err.empty())
+	{
+		return false;
+	}
+	
+	legacy::PassManager pm;
+	pm.add(new TargetLibraryInfo(triple));
+	pm.add(new DataLayoutPass(module));
+	machine->addAnalysisPasses(pm);
+	
+	{
+		formatted_raw_ostream fos(out.os());
+		TargetMachine::CodeGenFileType fileType = assembly ?
+			TargetMachine::CGFT_AssemblyFile : TargetMachine::CGFT_ObjectFile;
+		if (machine->addPassesToEmitFile(pm, fos, fileType))
+		{
+			err = "target does not support this file type";
+			return false;
+		}
+		pm.run(*module);
+	}
+	
+	// Otherwise the file is removed when out is destroyed
+	out.keep();
+	return true;
+}
+
+// JIT compiles the module and runs its main, passing args as argv.
+bool Emitter::run(const std::vector<std::string>& args, int& exitCode,
+				  std::string& err) noexcept
+{
+	// The native target and host symbols only need to be set up once
+	static std::once_flag initFlag;
+	std::call_once(initFlag, []()
+	{
+		InitializeNativeTarget();
+		InitializeNativeTargetAsmPrinter();
+		InitializeNativeTargetAsmParser();
+		// Makes the symbols in uscc itself (like printf) visible to the program
+		sys::DynamicLibrary::LoadLibraryPermanently(nullptr);
+	});
+	
+	Module* module = mContext.mModule;
+	Function* mainFunc = module->getFunction("main");
+	if (mainFunc == nullptr || mainFunc->isDeclaration())
+	{
+		err = "no main function";
+		return false;
+	}
+	
+	EngineBuilder builder(module);
+	builder.setErrorStr(&err);
+	builder.setEngineKind(EngineKind::JIT);
+	builder.setUseMCJIT(true);
+	std::unique_ptr<ExecutionEngine> engine(builder.create());
+	if (!engine)
+	{
+		return false;
+	}
+	engine->finalizeObject();
+	
+	exitCode = engine->runFunctionAsMain(mainFunc, args, nullptr);
+	
+	// The program's output goes through C stdio, so make sure
+	// it's out before anything else uscc prints
+	fflush(stdout);
 	
+	// The engine takes ownership of the module, but it belongs to the session
+	engine->removeModule(module);
 	return true;
 }
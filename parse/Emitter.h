@@ -20,8 +20,16 @@
 #include <llvm/IR/Value.h>
 #pragma clang diagnostic pop
 
+#include <ostream>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
 #include "Types.h"
 #include "../opt/SSABuilder.h"
+#include "../opt/TimeReport.h"
 
 namespace uscc
 {
@@ -30,18 +38,24 @@ namespace parse
 
 class StringTable;
 class Identifier;
+class Session;
+class ASTFunction;
+class FunctionCache;
 
 struct CodeContext
 {
-	CodeContext(StringTable& strings);
+	CodeContext(Session& session, StringTable& strings);
 	
 	// Used for our SSA construction algorithm
 	opt::SSABuilder mSSA;
 	
-	// Global context for LLVM
+	// The session that owns the LLVM state for this compilation
+	Session& mSession;
+	
+	// LLVM context for this compilation (owned by the session)
 	llvm::LLVMContext& mGlobal;
 	
-	// Module for this program
+	// Module for this program (owned by the session)
 	llvm::Module* mModule;
 	
 	// Current basic block
@@ -58,6 +72,10 @@ struct CodeContext
 	
 	// stores the current function
 	llvm::Function* mFunc;
+	
+	// Functions that should only be declared, since their
+	// bodies come from the function cache
+	std::unordered_set<const ASTFunction*> mDeclareOnly;
 };
 
 class Parser;
@@ -65,14 +83,46 @@ class Parser;
 class Emitter
 {
 public:
-	Emitter(Parser& parser) noexcept;
-	void optimize() noexcept;
-	void print() noexcept;
+	// If cache is non-null, functions that are in the cache are not emitted
+	// (they're linked in from the cache by linkCached)
+	Emitter(Parser& parser, Session& session, FunctionCache* cache = nullptr) noexcept;
+	~Emitter();
+	// If timeReport is non-null, the time spent in each pass is added to it
+	void optimize(opt::TimeReport* timeReport = nullptr) noexcept;
+	// Links the cached functions into the module.
+	// Does nothing without a cache. Must be called after optimize.
+	// Returns false (with the reason in err) if a cached function can't be
+	// linked in, after removing its entry so the next compile rebuilds it.
+	bool linkCached(std::string& err) noexcept;
+	// Adds the functions compiled by this Emitter to the function cache,
+	// and returns how many bytes that added to it.
+	// Does nothing without a cache. Only call this once the module has
+	// been verified, so bad IR is never cached.
+	uint64_t storeCached() noexcept;
+	void print(std::ostream& output) noexcept;
 	void writeBitcode(const char* fileName) noexcept;
 	bool verify() noexcept;
-	bool writeAsm(const char* fileName) noexcept;
+	// Compiles the module for the host (or for arch, if it isn't empty)
+	// and writes an assembly file, or an object file if assembly is false.
+	// cpu can be "native" to tune for the host CPU, or empty for a generic one.
+	// Returns false (with the reason in err) if the file can't be written.
+	bool writeNative(const char* fileName, bool assembly, const std::string& arch,
+					 const std::string& cpu, std::string& err) noexcept;
+	// JIT compiles the module and runs its main, passing args as argv.
+	// Returns false (with the reason in err) if the module can't be run.
+	bool run(const std::vector<std::string>& args, int& exitCode,
+			 std::string& err) noexcept;
 private:
 	CodeContext mContext;
+	
+	// Function cache (if any)
+	FunctionCache* mCache;
+	// Names of all the functions, in source order
+	std::vector<std::string> mFunctionNames;
+	// Functions emitted by us, with their cache keys
+	std::vector<std::pair<std::string, std::string>> mNewFunctions;
+	// Modules loaded from the cache (with their cache keys), still to be linked in
+	std::vector<std::pair<std::string, std::unique_ptr<llvm::Module>>> mCachedModules;
 };
 
 } // uscc
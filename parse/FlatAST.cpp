@@ -0,0 +1,53 @@
+//
+//  FlatAST.cpp
+//  uscc
+//
+//  Implements adding nodes to the flat form of the AST.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#include "FlatAST.h"
+
+using namespace uscc::parse;
+
+// Adds a node, whose children have to be added already
+FlatAST::NodeId FlatAST::addNode(ASTKind::Kinds kind, Type type, Data data,
+								 std::initializer_list<NodeId> children)
+{
+	return addNode(kind, type, data, children.begin(), children.size());
+}
+
+FlatAST::NodeId FlatAST::addNode(ASTKind::Kinds kind, Type type, Data data,
+								 const std::vector<NodeId>& children)
+{
+	return addNode(kind, type, data, children.data(), children.size());
+}
+
+FlatAST::NodeId FlatAST::addNode(ASTKind::Kinds kind, Type type, Data data,
+								 const NodeId* children, size_t numChildren)
+{
+	NodeId node = static_cast<NodeId>(mKinds.size());
+	mKinds.push_back(static_cast<uint8_t>(kind));
+	mTypes.push_back(static_cast<uint8_t>(type));
+	mData.push_back(data);
+	mFirstChild.push_back(static_cast<uint32_t>(mChildren.size()));
+	mNumChildren.push_back(static_cast<uint32_t>(numChildren));
+	mChildren.insert(mChildren.end(), children, children + numChildren);
+	return node;
+}
+
+void FlatAST::clear() noexcept
+{
+	mKinds.clear();
+	mTypes.clear();
+	mData.clear();
+	mFirstChild.clear();
+	mNumChildren.clear();
+	mChildren.clear();
+}
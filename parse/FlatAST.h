@@ -0,0 +1,205 @@
+//
+//  FlatAST.h
+//  uscc
+//
+//  Declares the flat form of the AST that printing and
+//  IR emission work from.
+//
+//  Once a parse succeeds, the tree of AST nodes is flattened
+//  into one array of nodes. Each node has a kind, a type,
+//  a small payload (its identifier, value, operator, ...)
+//  and the range of its children, each in an array of its
+//  own. Children are added before their parent, so a
+//  function's nodes are next to each other in memory.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#pragma once
+
+#include "Types.h"
+#include "../scan/Tokens.h"
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <ostream>
+#include <vector>
+
+namespace uscc
+{
+namespace parse
+{
+
+class Identifier;
+class ConstStr;
+class ASTFunction;
+class CodeContext;
+
+struct ASTKind
+{
+	enum Kinds
+	{
+		#define AST_KIND(a) a,
+		#include "ASTKinds.def"
+		#undef AST_KIND
+	};
+};
+
+class FlatAST
+{
+public:
+	typedef uint32_t NodeId;
+	
+	// What a node holds besides its type and children
+	// (which member is used depends on the kind)
+	union Data
+	{
+		// Ident nodes, ArgDecl, ArraySub, Decl, AssignStmt, FuncExpr
+		Identifier* mIdent;
+		// Function
+		ASTFunction* mFunction;
+		// StringExpr
+		ConstStr* mString;
+		// ConstantExpr
+		int mValue;
+		// BinaryCmpOp, BinaryMathOp
+		scan::Token::Tokens mOp;
+	};
+	
+	static Data noData() noexcept
+	{
+		Data data;
+		data.mIdent = nullptr;
+		return data;
+	}
+	static Data identData(Identifier& ident) noexcept
+	{
+		Data data;
+		data.mIdent = &ident;
+		return data;
+	}
+	static Data functionData(ASTFunction& func) noexcept
+	{
+		Data data;
+		data.mFunction = &func;
+		return data;
+	}
+	static Data stringData(ConstStr* str) noexcept
+	{
+		Data data;
+		data.mString = str;
+		return data;
+	}
+	static Data valueData(int value) noexcept
+	{
+		Data data;
+		data.mValue = value;
+		return data;
+	}
+	static Data opData(scan::Token::Tokens op) noexcept
+	{
+		Data data;
+		data.mOp = op;
+		return data;
+	}
+	
+	// Adds a node, whose children have to be added already
+	NodeId addNode(ASTKind::Kinds kind, Type type, Data data,
+				   std::initializer_list<NodeId> children = {});
+	NodeId addNode(ASTKind::Kinds kind, Type type, Data data,
+				   const std::vector<NodeId>& children);
+	
+	void clear() noexcept;
+	
+	size_t size() const noexcept
+	{
+		return mKinds.size();
+	}
+	
+	// The program is added last, so it's the last node
+	NodeId getRoot() const noexcept
+	{
+		return static_cast<NodeId>(mKinds.size() - 1);
+	}
+	
+	ASTKind::Kinds getKind(NodeId node) const noexcept
+	{
+		return static_cast<ASTKind::Kinds>(mKinds[node]);
+	}
+	
+	Type getType(NodeId node) const noexcept
+	{
+		return static_cast<Type>(mTypes[node]);
+	}
+	
+	Identifier& getIdent(NodeId node) const noexcept
+	{
+		return *mData[node].mIdent;
+	}
+	
+	ASTFunction& getFunction(NodeId node) const noexcept
+	{
+		return *mData[node].mFunction;
+	}
+	
+	ConstStr* getString(NodeId node) const noexcept
+	{
+		return mData[node].mString;
+	}
+	
+	int getValue(NodeId node) const noexcept
+	{
+		return mData[node].mValue;
+	}
+	
+	scan::Token::Tokens getOp(NodeId node) const noexcept
+	{
+		return mData[node].mOp;
+	}
+	
+	size_t getNumChildren(NodeId node) const noexcept
+	{
+		return mNumChildren[node];
+	}
+	
+	NodeId getChild(NodeId node, size_t index) const noexcept
+	{
+		return mChildren[mFirstChild[node] + index];
+	}
+	
+	// Pointers to the children of node, for range-based for loops
+	const NodeId* childBegin(NodeId node) const noexcept
+	{
+		return mChildren.data() + mFirstChild[node];
+	}
+	const NodeId* childEnd(NodeId node) const noexcept
+	{
+		return childBegin(node) + mNumChildren[node];
+	}
+	
+private:
+	NodeId addNode(ASTKind::Kinds kind, Type type, Data data,
+				   const NodeId* children, size_t numChildren);
+	
+	std::vector<uint8_t> mKinds;
+	std::vector<uint8_t> mTypes;
+	std::vector<Data> mData;
+	// Each node's children are mChildren[mFirstChild, mFirstChild + mNumChildren)
+	std::vector<uint32_t> mFirstChild;
+	std::vector<uint32_t> mNumChildren;
+	std::vector<NodeId> mChildren;
+};
+
+// Prints the subtree rooted at node (in ASTPrint.cpp)
+void printAST(const FlatAST& ast, FlatAST::NodeId node, std::ostream& output);
+
+// Emits the IR for the whole program (in ASTEmit.cpp)
+void emitAST(const FlatAST& ast, CodeContext& ctx);
+
+} // parse
+} // uscc
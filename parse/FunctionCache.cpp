@@ -0,0 +1,289 @@
+//
+//  FunctionCache.cpp
+//  uscc
+//
+//  Implements the on-disk cache of compiled functions used
+//  for incremental recompilation.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#include "FunctionCache.h"
+#include "ASTNodes.h"
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wconversion"
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Bitcode/ReaderWriter.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <llvm/Transforms/Utils/ValueMapper.h>
+#pragma clang diagnostic pop
+
+#include <sstream>
+#include <unordered_set>
+#include <vector>
+
+using namespace uscc::parse;
+using namespace llvm;
+
+namespace
+{
+
+// Any change to how functions are emitted or optimized
+// should bump this, so stale entries are never used
+const char* functionCacheVersion = "uscc 0.5 function cache 1";
+
+// Adds every global (function or variable) used by v to globals
+void collectGlobals(const Value* v, std::vector<const GlobalValue*>& globals,
+					std::unordered_set<const Value*>& visited)
+{
+	if (!visited.insert(v).second)
+	{
+		return;
+	}
+
+	if (const GlobalValue* global = dyn_cast<GlobalValue>(v))
+	{
+		globals.push_back(global);
+	}
+	else if (const Constant* constant = dyn_cast<Constant>(v))
+	{
+		// String literals are used through constant GEPs
+		for (User::const_op_iterator op = constant->op_begin();
+			 op != constant->op_end(); ++op)
+		{
+			collectGlobals(op->get(), globals, visited);
+		}
+	}
+}
+
+// Copies func into a new module of its own, along with
+// everything it references
+std::unique_ptr<Module> extractFunction(const Function& func)
+{
+	std::unique_ptr<Module> module(new Module(func.getName(), func.getContext()));
+
+	Function* newFunc = Function::Create(func.getFunctionType(), func.getLinkage(),
+										 func.getName(), module.get());
+	newFunc->setCallingConv(func.getCallingConv());
+
+	ValueToValueMapTy vmap;
+	vmap[&func] = newFunc;
+
+	Function::arg_iterator newArg = newFunc->arg_begin();
+	for (Function::const_arg_iterator arg = func.arg_begin();
+		 arg != func.arg_end(); ++arg, ++newArg)
+	{
+		newArg->setName(arg->getName());
+		vmap[arg] = newArg;
+	}
+
+	std::vector<const GlobalValue*> globals;
+	std::unordered_set<const Value*> visited;
+	for (const BasicBlock& block : func)
+	{
+		for (const Instruction& instr : block)
+		{
+			for (User::const_op_iterator op = instr.op_begin();
+				 op != instr.op_end(); ++op)
+			{
+				collectGlobals(op->get(), globals, visited);
+			}
+		}
+	}
+
+	for (const GlobalValue* global : globals)
+	{
+		if (global == &func)
+		{
+			continue;
+		}
+
+		if (const Function* callee = dyn_cast<Function>(global))
+		{
+			// Callees are only declared; the linker resolves them
+			Function* decl = Function::Create(callee->getFunctionType(),
+											  GlobalValue::LinkageTypes::ExternalLinkage,
+											  callee->getName(), module.get());
+			decl->setCallingConv(callee->getCallingConv());
+			vmap[callee] = decl;
+		}
+		else if (const GlobalVariable* var = dyn_cast<GlobalVariable>(global))
+		{
+			// Our only globals are string literals, whose initializers
+			// don't reference anything else
+			GlobalVariable* copy =
+				new GlobalVariable(*module, var->getType()->getElementType(),
+								   var->isConstant(), var->getLinkage(),
+								   const_cast<Constant*>(var->getInitializer()),
+								   var->getName());
+			copy->setUnnamedAddr(var->hasUnnamedAddr());
+			copy->setAlignment(var->getAlignment());
+			vmap[var] = copy;
+		}
+	}
+
+	SmallVector<ReturnInst*, 8> returns;
+	CloneFunctionInto(newFunc, &func, vmap, true, returns);
+	return module;
+}
+
+// Text used to tell types apart in keys
+const char* typeKey(Type type)
+{
+	switch (type)
+	{
+		case Type::Int:
+			return "int";
+		case Type::Char:
+			return "char";
+		case Type::IntArray:
+			return "int[]";
+		case Type::CharArray:
+			return "char[]";
+		case Type::Function:
+			return "function";
+		default:
+			return "void";
+	}
+}
+
+} // anonymous
+
+FunctionCache::FunctionCache(const std::string& dir, bool optimized)
+: mDir(dir)
+, mOptimized(optimized)
+{
+	sys::fs::create_directories(mDir);
+}
+
+// Computes the cache key for the function at node
+std::string FunctionCache::computeKey(const FlatAST& ast, FlatAST::NodeId node) const
+{
+	const ASTFunction& func = ast.getFunction(node);
+	
+	// The printed AST covers the function's signature, body,
+	// and the text of every string literal it uses
+	std::ostringstream text;
+	text << functionCacheVersion << '\n';
+	text << "optimized=" << mOptimized << '\n';
+	printAST(ast, node, text);
+
+	// The calls it emits also depend on the signatures of its callees
+	for (Identifier* callee : func.getCallees())
+	{
+		text << "callee " << callee->getName();
+		ASTFunction* calleeFunc = callee->getFunction();
+		if (calleeFunc)
+		{
+			text << ' ' << typeKey(calleeFunc->getReturnType()) << '(';
+			for (unsigned int i = 1; i <= calleeFunc->getNumArgs(); i++)
+			{
+				text << typeKey(calleeFunc->getArgType(i)) << ',';
+			}
+			text << ')';
+		}
+		text << '\n';
+	}
+
+	MD5 hash;
+	hash.update(text.str());
+	MD5::MD5Result result;
+	hash.final(result);
+	SmallString<32> str;
+	MD5::stringifyResult(result, str);
+	return str.str();
+}
+
+// Loads the entry for key into context.
+std::unique_ptr<Module> FunctionCache::load(const std::string& key,
+											LLVMContext& context) const
+{
+	std::unique_ptr<Module> retVal;
+	std::string path = entryPath(key);
+
+	auto buffer = MemoryBuffer::getFile(path);
+	if (!buffer)
+	{
+		return retVal;
+	}
+
+	ErrorOr<Module*> module = parseBitcodeFile(buffer->get(), context);
+	if (!module)
+	{
+		return retVal;
+	}
+	retVal.reset(module.get());
+
+	// Mark the entry as recently used, for eviction
+	int fd;
+	if (!sys::fs::openFileForWrite(path, fd, sys::fs::F_Append))
+	{
+		raw_fd_ostream touched(fd, true);
+		sys::fs::setLastModificationAndAccessTime(fd, sys::TimeValue::now());
+	}
+
+	return retVal;
+}
+
+// Stores the IR for func as the entry for key
+uint64_t FunctionCache::store(const std::string& key, const Function& func) const
+{
+	std::unique_ptr<Module> module = extractFunction(func);
+
+	int fd;
+	SmallString<128> tempPath;
+	if (sys::fs::createUniqueFile(mDir + "/tmp-%%%%%%%%", fd, tempPath))
+	{
+		return 0;
+	}
+
+	uint64_t size;
+	{
+		raw_fd_ostream file(fd, true);
+		WriteBitcodeToFile(module.get(), file);
+		size = file.tell();
+		file.close();
+		if (file.has_error())
+		{
+			file.clear_error();
+			sys::fs::remove(tempPath.str());
+			return 0;
+		}
+	}
+
+	// Rename is atomic, so concurrent readers never see a partial entry
+	if (sys::fs::rename(tempPath.str(), entryPath(key)))
+	{
+		sys::fs::remove(tempPath.str());
+		return 0;
+	}
+	return size;
+}
+
+// Removes the entry for key, if there is one
+void FunctionCache::remove(const std::string& key) const
+{
+	sys::fs::remove(entryPath(key));
+}
+
+// The .bc extension lets the --cache-dir eviction manage these entries
+std::string FunctionCache::entryPath(const std::string& key) const
+{
+	return mDir + "/" + key + ".fn.bc";
+}
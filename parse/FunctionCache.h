@@ -0,0 +1,72 @@
+//
+//  FunctionCache.h
+//  uscc
+//
+//  Declares the on-disk cache of compiled functions used
+//  for incremental recompilation (--incremental).
+//
+//  Each function is keyed by a hash of its AST, the
+//  signatures of the functions it calls, and whether it
+//  was optimized. An entry is a standalone module that has
+//  the function's (optimized) IR, the string literals it
+//  uses, and declarations for its callees.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#pragma once
+
+#include "FlatAST.h"
+#include <string>
+#include <memory>
+#include <cstdint>
+
+namespace llvm
+{
+	class LLVMContext;
+	class Module;
+	class Function;
+}
+
+namespace uscc
+{
+namespace parse
+{
+
+class FunctionCache
+{
+public:
+	// Entries are stored in dir, which may be shared with other
+	// uscc processes (and with the --cache-dir bitcode cache,
+	// whose eviction also keeps these entries in check)
+	FunctionCache(const std::string& dir, bool optimized);
+
+	// Computes the cache key for the function at node
+	std::string computeKey(const FlatAST& ast, FlatAST::NodeId node) const;
+
+	// Loads the entry for key into context.
+	// Returns null if there's no usable entry.
+	std::unique_ptr<llvm::Module> load(const std::string& key,
+									   llvm::LLVMContext& context) const;
+
+	// Stores the IR for func as the entry for key.
+	// Returns the size of the entry (0 if it couldn't be stored).
+	uint64_t store(const std::string& key, const llvm::Function& func) const;
+
+	// Removes the entry for key, if there is one
+	void remove(const std::string& key) const;
+
+private:
+	std::string entryPath(const std::string& key) const;
+
+	std::string mDir;
+	bool mOptimized;
+};
+
+} // parse
+} // uscc
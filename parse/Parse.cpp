@@ -15,12 +15,13 @@
 //---------------------------------------------------------
 
 #include "Parse.h"
-#include <FlexLexer.h>
 #include "Symbols.h"
+#include "../scan/Lexer.h"
 
 // Used if you want to see each token
 #define DEBUG_PRINT_TOKENS 0
 #include <sstream>
+#include <mutex>
 
 #if DEBUG_PRINT_TOKENS
 #include <iostream>
@@ -33,33 +34,79 @@ using std::make_shared;
 
 // Constructor takes in a file name and performs the parse
 Parser::Parser(const char* fileName, std::ostream* errStream,
-			   std::ostream* ASTStream)
-: mCurrToken(Token::Unknown)
+			   std::ostream* ASTStream, opt::TimeReport* timeReport,
+			   unsigned lexThreads, unsigned parseThreads)
+: mRoot(nullptr)
+, mUnusedArray(nullptr)
+, mInput(new Input(fileName))
+, mNames(mInput->mNames)
+, mSymbols(mNames)
+, mCurrToken(Token::Unknown)
 , mFileName(fileName)
-, mFileStream(fileName)
+, mSource(mInput->mSource)
+, mTokens(mInput->mTokens)
+, mTokenIndex(0)
+, mNextIndex(0)
 , mErrStream(errStream)
 , mASTStream(ASTStream)
-, mLineNumber(1)
-, mColNumber(1)
-, mUnusedIdent(nullptr)
+, mTimeReport(timeReport)
+, mWorkerCPU(0.0)
+, mCurrFunction(nullptr)
 , mNeedPrintf(false)
 , mCheckSemant(true) // PA2: Change to true
+, mNestingDepth(0)
+, mFileParser(nullptr)
+, mFuncIndex(0)
 {
-	if (mFileStream.is_open())
+	if (mSource.isOpen())
 	{
-		mLexer = new yyFlexLexer(&mFileStream);
-				
-		try
+		// Lex the whole file up front, so the parser can
+		// look ahead as far as it needs
 		{
-			// Get the first token
-			consumeToken();
-
-			// Now start the parse
-			mRoot = parseProgram();
+			opt::PhaseTimer timer(mTimeReport, "Scanning");
+			LexWorkerHook timeWorker;
+			std::mutex timerMutex;
+			if (mTimeReport)
+			{
+				// Lexing threads finish at different times,
+				// so they take turns adding to the timer
+				timeWorker = [&timer, &timerMutex](const std::function<void()>& work)
+				{
+					opt::Stopwatch workTimer;
+					work();
+					double cpu = workTimer.elapsed().mCPU;
+					std::lock_guard<std::mutex> lock(timerMutex);
+					timer.addWorkerCPU(cpu);
+				};
+			}
+			lexSource(mSource.getText(), mTokens, mNames, lexThreads, timeWorker);
 		}
-		catch (ParseExcept& e)
+		
 		{
-			reportError(e);
+			opt::PhaseTimer timer(mTimeReport, "Parsing and semantic analysis");
+			try
+			{
+				// Get the first token
+				consumeToken();
+				
+				// Now start the parse
+				mRoot = parseProgram(parseThreads);
+			}
+			catch (ParseExcept& e)
+			{
+				reportError(e);
+			}
+			catch (NestingTooDeep&)
+			{
+				// Already reported, where the limit was hit
+			}
+			timer.addWorkerCPU(mWorkerCPU);
+		}
+		
+		if (mTimeReport)
+		{
+			// EndOfFile isn't counted
+			mTimeReport->setInputSize(mSource.getNumLines(), mTokens.size() - 1);
 		}
 	}
 	else
@@ -73,89 +120,93 @@ Parser::Parser(const char* fileName, std::ostream* errStream,
 	}
 }
 
+// Makes a parser for the body of func, the funcIndex-th function
+// in file. It shares file's source, tokens and symbols.
+Parser::Parser(Parser& file, ASTFunction& func, size_t funcIndex)
+: mRoot(nullptr)
+, mUnusedArray(nullptr)
+, mNames(file.mNames)
+, mSymbols(file.mSymbols, &func.getScopeTable())
+, mCurrToken(Token::Unknown)
+, mFileName(file.mFileName)
+, mSource(file.mSource)
+, mTokens(file.mTokens)
+, mTokenIndex(0)
+, mNextIndex(0)
+, mErrStream(file.mErrStream)
+, mASTStream(nullptr)
+, mTimeReport(nullptr)
+, mWorkerCPU(0.0)
+, mCurrReturnType(func.getReturnType())
+, mCurrFunction(&func)
+, mNeedPrintf(false)
+, mCheckSemant(file.mCheckSemant)
+, mNestingDepth(0)
+, mFileParser(&file)
+, mFuncIndex(funcIndex)
+{
+}
+
 // Destructor not virtual; I don't expect any inheritance
 Parser::~Parser()
 {
-	delete mLexer;
 }
 
-// Returns the string for the current token's text
-const char* Parser::getTokenTxt() const noexcept
+// Returns the token that's ahead tokens after the current one
+Token::Tokens Parser::peekToken(size_t ahead) const noexcept
 {
-	const char* retVal = "";
-	if (mCurrToken != Token::Unknown && mCurrToken != Token::EndOfFile)
+	size_t index = mTokenIndex + ahead;
+	if (index >= mTokens.size())
 	{
-		retVal = mLexer->YYText();
+		return Token::EndOfFile;
 	}
-	
-	return retVal;
+	return mTokens.getKind(index);
+}
+
+// Returns the current token's text as a view into the source file
+llvm::StringRef Parser::getTokenView() const noexcept
+{
+	return mSource.getText().substr(mTokens.getOffset(mTokenIndex),
+									mTokens.getLength(mTokenIndex));
 }
 
 // Consumes the current token, and moves to the next
-// token that's not a NewLine or Comment.
+// token in the token buffer.
 //
 // Throws an exception if next token is Unknown,
 // if unknownIsExcept is true
 void Parser::consumeToken(bool unknownIsExcept)
 {
-	// Add to the column number once we move past
-	// this token.
-	if (mCurrToken != Token::Unknown)
-	{
-		int len = Token::Lengths[mCurrToken];
-		if (len != -1)
-		{
-			mColNumber += len;
-		}
-		else
-		{
-			mColNumber += mLexer->YYLeng();
-		}
-	}
-	
 	do
 	{
-		mCurrToken = static_cast<Token::Tokens>(mLexer->yylex());
-#if DEBUG_PRINT_TOKENS
-		if (mCurrToken == Token::Comment)
+		// The buffer always ends with EndOfFile, which we never move past
+		mTokenIndex = mNextIndex;
+		if (mNextIndex + 1 < mTokens.size())
 		{
-			std::cout << Token::Names[mCurrToken] << ": " << mLexer->YYText();
-		}
-		else if (mCurrToken != Token::Newline && mCurrToken != Token::Space &&
-				 mCurrToken != Token::Tab)
-		{
-			std::cout << Token::Names[mCurrToken] << ": " << mLexer->YYText() << "\n";
+			mNextIndex++;
 		}
+		
+		mCurrToken = mTokens.getKind(mTokenIndex);
+#if DEBUG_PRINT_TOKENS
+		std::cout << Token::Names[mCurrToken] << ": " << getTokenView().str() << "\n";
 #endif
-		if (mCurrToken == Token::Newline || mCurrToken == Token::Comment)
-		{
-			mLineNumber++;
-			mColNumber = 1;
-		}
-		else if (mCurrToken == Token::Space || mCurrToken == Token::Tab)
-		{
-			mColNumber++;
-		}
-		else if (mCurrToken == Token::Unknown)
+		if (mCurrToken == Token::Unknown)
 		{
 			// We don't want to always throw an exception, in case we are in
 			// error recovery mode.
 			if (unknownIsExcept)
 			{
-				throw UnknownToken(mLexer->YYText(), mColNumber);
+				throw UnknownToken(getTokenTxt());
 			}
 			else
 			{
 				std::string msg("Invalid symbol: ");
-				msg += mLexer->YYText();
+				msg += getTokenTxt();
 				reportError(msg);
-				mColNumber++;
 			}
 		}
 	}
-	while(mCurrToken == Token::Newline || mCurrToken == Token::Comment ||
-		  mCurrToken == Token::Space || mCurrToken == Token::Tab ||
-		  mCurrToken == Token::Unknown);
+	while (mCurrToken == Token::Unknown);
 }
 
 // Sees if the token matches the requested.
@@ -267,12 +318,32 @@ void Parser::reportError(const ParseExcept& except) noexcept
 {
 	std::stringstream errStrm;
 	except.printException(errStrm);
-	mErrors.push_back(std::make_shared<Error>(errStrm.str(), mLineNumber, mColNumber));
+	mErrors.push_back(std::make_shared<Error>(errStrm.str(), getLineNumber(), getColNumber()));
 }
 			
 void Parser::reportError(const std::string& msg) noexcept
 {
-	mErrors.push_back(std::make_shared<Error>(msg, mLineNumber, mColNumber));
+	mErrors.push_back(std::make_shared<Error>(msg, getLineNumber(), getColNumber()));
+}
+
+Parser::NestingGuard::NestingGuard(Parser& parser)
+: mParser(parser)
+, mLevels(0)
+{
+	addLevel();
+}
+
+void Parser::NestingGuard::addLevel()
+{
+	if (mParser.mNestingDepth == MaxNestingDepth)
+	{
+		std::ostringstream msg;
+		msg << "Nesting is too deep (the limit is " << MaxNestingDepth << " levels)";
+		mParser.reportError(msg.str());
+		throw NestingTooDeep();
+	}
+	mParser.mNestingDepth++;
+	mLevels++;
 }
 	
 void Parser::reportSemantError(const std::string& msg, int colOverride, int lineOverride) noexcept
@@ -282,7 +353,7 @@ void Parser::reportSemantError(const std::string& msg, int colOverride, int line
 		int col;
 		if (colOverride == -1)
 		{
-			col = mColNumber;
+			col = getColNumber();
 		}
 		else
 		{
@@ -292,7 +363,7 @@ void Parser::reportSemantError(const std::string& msg, int colOverride, int line
 		int line;
 		if (lineOverride == -1)
 		{
-			line = mLineNumber;
+			line = getLineNumber();
 		}
 		else
 		{
@@ -303,17 +374,18 @@ void Parser::reportSemantError(const std::string& msg, int colOverride, int line
 	}
 }
 
-void Parser::displayErrorMsg(const std::string& line, std::shared_ptr<Error> error) noexcept
+void Parser::displayErrorMsg(llvm::StringRef line, std::shared_ptr<Error> error) noexcept
 {
 	(*mErrStream) << mFileName << ":" << error->mLineNum << ":" << error->mColNum;
 	(*mErrStream) << ": error: ";
 	(*mErrStream) << error->mMsg << std::endl;
 	
-	(*mErrStream) << line << std::endl;
+	mErrStream->write(line.data(), static_cast<std::streamsize>(line.size()));
+	(*mErrStream) << std::endl;
 	// Now add the caret
 	for (int i = 0; i < error->mColNum - 1; i++)
 	{
-		if (line[i] == '\t')
+		if (static_cast<size_t>(i) < line.size() && line[static_cast<size_t>(i)] == '\t')
 		{
 			(*mErrStream) << '\t';
 		}
@@ -328,38 +400,39 @@ void Parser::displayErrorMsg(const std::string& line, std::shared_ptr<Error> err
 void Parser::displayErrors() noexcept
 {
 	// Output errors
-	// Move the filestream back to the start
-	int lineNum = 0;
-	std::string lineTxt;
-	mFileStream.clear();
-	mFileStream.seekg(0, std::ios::beg);
+	// The source lines are views into the mapped file,
+	// so nothing needs to be read again
 	for (auto i = mErrors.begin();
 		 i != mErrors.end();
 		 ++i)
 	{
-		while (lineNum < (*i)->mLineNum)
-		{
-			std::getline(mFileStream, lineTxt);
-			lineNum++;
-		}
-		
-		displayErrorMsg(lineTxt, *i);
+		displayErrorMsg(mSource.getLine(static_cast<unsigned int>((*i)->mLineNum)), *i);
 	}
 }
 
-Identifier* Parser::getVariable(const char* name) noexcept
+Identifier* Parser::getVariable(uint32_t nameId) noexcept
 {
 	
-	Identifier* ident = mSymbols.getIdentifier(name);
+	Identifier* ident = mSymbols.getIdentifier(nameId);
+	if (ident && mFileParser && ident->isFunction())
+	{
+		// A body parsed in parallel can already see the functions
+		// declared after it, which a serial parse wouldn't have yet
+		auto iter = mFileParser->mFunctionIndices.find(ident);
+		if (iter != mFileParser->mFunctionIndices.end() && iter->second > mFuncIndex)
+		{
+			ident = nullptr;
+		}
+	}
     if(ident == 0)
     {
         std::string msg = "Use of undeclared identifier ";
         std::string var = "\'";
-        var += name;
+        var += mSymbols.getName(nameId);
         var += "\'";
         msg += var;
         reportSemantError(msg);
-        return mSymbols.getIdentifier("@@variable");
+        return mSymbols.getDummyVariable();
     }
 	return ident;
 }
@@ -386,10 +459,10 @@ const char* Parser::getTypeText(Type type) const noexcept
 // Takes the expression, and if it's a char expression, converts it to an int type
 // expression.
 // Otherwise it doesn't do anything.
-std::shared_ptr<ASTExpr> Parser::charToInt(std::shared_ptr<ASTExpr> expr) noexcept
+ASTExpr* Parser::charToInt(ASTExpr* expr) noexcept
 {
-	std::shared_ptr<ASTExpr> retVal = expr;
-    //std::shared_ptr<ASTConstantExpr> constVal;
+	ASTExpr* retVal = expr;
+    //ASTConstantExpr* constVal;
     //expr = constVal;
     if(expr->getType() == Type::Int || expr->getType() == Type::CharArray || expr->getType() == Type::IntArray)        // expr is already int
     {
@@ -398,11 +471,11 @@ std::shared_ptr<ASTExpr> Parser::charToInt(std::shared_ptr<ASTExpr> expr) noexce
     // expression is char //
     else
     {
-        ASTConstantExpr* x = dynamic_cast<ASTConstantExpr *>(expr.get());
-        ASTIdentExpr* a = dynamic_cast<ASTIdentExpr *>(retVal.get());
-        ASTIncExpr* inc = dynamic_cast<ASTIncExpr *>(retVal.get());
-        ASTDecExpr* dec = dynamic_cast<ASTDecExpr *>(retVal.get());
-        ASTArrayExpr* array = dynamic_cast<ASTArrayExpr *>(retVal.get());
+        ASTConstantExpr* x = dynamic_cast<ASTConstantExpr *>(expr);
+        ASTIdentExpr* a = dynamic_cast<ASTIdentExpr *>(retVal);
+        ASTIncExpr* inc = dynamic_cast<ASTIncExpr *>(retVal);
+        ASTDecExpr* dec = dynamic_cast<ASTDecExpr *>(retVal);
+        ASTArrayExpr* array = dynamic_cast<ASTArrayExpr *>(retVal);
 
 
 
@@ -415,21 +488,21 @@ std::shared_ptr<ASTExpr> Parser::charToInt(std::shared_ptr<ASTExpr> expr) noexce
         {
             if(array !=0 )
             {
-                std::shared_ptr<ASTToIntExpr> parent = make_shared<ASTToIntExpr>(retVal);         //expr is char
+                ASTToIntExpr* parent = mArena.make<ASTToIntExpr>(retVal);         //expr is char
                 return parent;
             }
             if(a == 0)   // not IdentExpr
             {
                 if(inc != 0 || dec != 0)        // either inc or dec expression
                 {
-                    std::shared_ptr<ASTToIntExpr> parent = make_shared<ASTToIntExpr>(retVal);         //expr is char
+                    ASTToIntExpr* parent = mArena.make<ASTToIntExpr>(retVal);         //expr is char
                     return parent;
                 }
             }
             else    // is identexpr
             {
              
-                std::shared_ptr<ASTToIntExpr> parent = make_shared<ASTToIntExpr>(retVal);         //expr is char
+                ASTToIntExpr* parent = mArena.make<ASTToIntExpr>(retVal);         //expr is char
                 return parent;
             
             }
@@ -441,10 +514,10 @@ std::shared_ptr<ASTExpr> Parser::charToInt(std::shared_ptr<ASTExpr> expr) noexce
 
 // Like the above, but in reverse
 // Create conversion node from int to char
-std::shared_ptr<ASTExpr> Parser::intToChar(std::shared_ptr<ASTExpr> expr) noexcept
+ASTExpr* Parser::intToChar(ASTExpr* expr) noexcept
 {
-	std::shared_ptr<ASTExpr> retVal = expr;
-    std::shared_ptr<ASTConstantExpr> constVal;
+	ASTExpr* retVal = expr;
+    ASTConstantExpr* constVal = nullptr;
     
     if(expr->getType() == Type::Char)
     {
@@ -454,8 +527,8 @@ std::shared_ptr<ASTExpr> Parser::intToChar(std::shared_ptr<ASTExpr> expr) noexce
     else
     {
         // is ASTToIntExpr -> return parent of this Expr
-        ASTToIntExpr* x = dynamic_cast<ASTToIntExpr *>(expr.get());
-        ASTConstantExpr* a = dynamic_cast<ASTConstantExpr *>(expr.get());
+        ASTToIntExpr* x = dynamic_cast<ASTToIntExpr *>(expr);
+        ASTConstantExpr* a = dynamic_cast<ASTConstantExpr *>(expr);
 
         if(a !=0)
         {
@@ -467,7 +540,7 @@ std::shared_ptr<ASTExpr> Parser::intToChar(std::shared_ptr<ASTExpr> expr) noexce
         }
         else
         {
-            std::shared_ptr<ASTToCharExpr> char_node = make_shared<ASTToCharExpr>(retVal);
+            ASTToCharExpr* char_node = mArena.make<ASTToCharExpr>(retVal);
             return char_node;
         }
     }
@@ -475,17 +548,22 @@ std::shared_ptr<ASTExpr> Parser::intToChar(std::shared_ptr<ASTExpr> expr) noexce
 }
 
 // The entry point for the parser
-shared_ptr<ASTProgram> Parser::parseProgram()
+ASTProgram* Parser::parseProgram(unsigned numThreads)
 {
-	// Create our base program node.
-	shared_ptr<ASTProgram> retVal = make_shared<ASTProgram>();
-	
-	shared_ptr<ASTFunction> func = parseFunction();
+	ASTProgram* retVal = parseFunctionsInParallel(numThreads);
 	
-	while (func)
+	if (!retVal)
 	{
-		retVal->addFunction(func);
-		func = parseFunction();
+		// Create our base program node.
+		retVal = mArena.make<ASTProgram>();
+		
+		ASTFunction* func = parseFunction();
+		
+		while (func)
+		{
+			retVal->addFunction(func);
+			func = parseFunction();
+		}
 	}
 	
 	if (peekToken() != Token::EndOfFile)
@@ -495,18 +573,32 @@ shared_ptr<ASTProgram> Parser::parseProgram()
 	
 	if (IsValid())
 	{
+		// Printing and emission work from the flat form
+		retVal->flatten(mFlat);
 		if (mASTStream)
 		{
-			retVal->printNode((*mASTStream));
+			printAST(mFlat, mFlat.getRoot(), *mASTStream);
 		}
 	}
 	
 	return retVal;
 }
 	
-shared_ptr<ASTFunction> Parser::parseFunction()
+ASTFunction* Parser::parseFunction()
+{
+	ASTFunction* retVal = parseFunctionHeader();
+	if (retVal)
+	{
+		parseFunctionBody(retVal);
+	}
+	return retVal;
+}
+
+// Parses the return type, name and arguments, and leaves
+// the symbol table in the function's scope
+ASTFunction* Parser::parseFunctionHeader()
 {
-	shared_ptr<ASTFunction> retVal;
+	ASTFunction* retVal = nullptr;
 	
 	// Check for a return type
 	if (peekIsOneOf({Token::Key_void, Token::Key_int, Token::Key_char}))
@@ -535,7 +627,7 @@ shared_ptr<ASTFunction> Parser::parseFunction()
 		// an array, which USC doesn't allow
 		if (peekAndConsume(Token::LBracket))
 		{
-			reportSemantError("USC does not allow return of array types", mColNumber - 1);
+			reportSemantError("USC does not allow return of array types", getColNumber() - 1);
 			consumeUntil(Token::RBracket);
 			if (peekToken() == Token::EndOfFile)
 			{
@@ -556,7 +648,7 @@ shared_ptr<ASTFunction> Parser::parseFunction()
 			
 			// Set this to a bogus debug symbol so the parse continues
 			
-			ident = mSymbols.getIdentifier("@@function");
+			ident = mSymbols.getDummyFunction();
 			// skip until the open parenthesis
 			consumeUntil(Token::LParen);
 			if (peekToken() == Token::EndOfFile)
@@ -567,7 +659,7 @@ shared_ptr<ASTFunction> Parser::parseFunction()
 		else
 		{
 			// We're making a new function, see if it's valid to do so
-			if (mSymbols.isDeclaredInScope(getTokenTxt()))
+			if (mSymbols.isDeclaredInScope(getTokenNameId()))
 			{
 				// Invalid redeclaration
 				std::string err = "Invalid redeclaration of function '";
@@ -576,11 +668,11 @@ shared_ptr<ASTFunction> Parser::parseFunction()
 				reportSemantError(err);
 				
 				// Set the identifier to @@function
-				ident = mSymbols.getIdentifier("@@function");
+				ident = mSymbols.getDummyFunction();
 			}
 			else
 			{
-				ident = mSymbols.createIdentifier(getTokenTxt());
+				ident = mSymbols.createIdentifier(getTokenNameId());
 				ident->setType(Type::Function);
 				
 				if (ident->getName() == "main" && retType != Type::Int)
@@ -596,7 +688,8 @@ shared_ptr<ASTFunction> Parser::parseFunction()
 		// since arguments count as the function's main body scope
 		SymbolTable::ScopeTable* table = mSymbols.enterScope();
 		
-		retVal = make_shared<ASTFunction>(*ident, retType, *table);
+		retVal = mArena.make<ASTFunction>(*ident, retType, *table);
+		mCurrFunction = retVal;
 		
 		// If this isn't the dummy function, hook up the node
 		if (!ident->isDummy())
@@ -608,7 +701,7 @@ shared_ptr<ASTFunction> Parser::parseFunction()
 		{
 			try
 			{
-				shared_ptr<ASTArgDecl> arg = parseArgDecl();
+				ASTArgDecl* arg = parseArgDecl();
 				while (arg)
 				{
 					retVal->addArg(arg);
@@ -654,45 +747,49 @@ shared_ptr<ASTFunction> Parser::parseFunction()
 				throw EOFExcept();
 			}
 		}
-		
-		// Grab the compound statement for this function
-		shared_ptr<ASTCompoundStmt> funcCompoundStmt;
-		try
-		{
-			funcCompoundStmt = parseCompoundStmt(true);
-		}
-		catch (ParseExcept& e)
-		{
-			// Something really bad happened here
-			reportError(e);
-			// Skip all the tokens until the } brace
-			consumeUntil(Token::RBrace);
-			if (peekToken() == Token::EndOfFile)
-			{
-				throw EOFExcept();
-			}
-			consumeToken();
-		}
-		
-		// Exit the scope, before we potentially throw out of this function
-		// for a non-EOF message.
-		mSymbols.exitScope();
-		
-		if (!funcCompoundStmt)
+	}
+	
+	return retVal;
+}
+
+// Parses the body of func, and exits the function's scope
+void Parser::parseFunctionBody(ASTFunction* func)
+{
+	// Grab the compound statement for this function
+	ASTCompoundStmt* funcCompoundStmt = nullptr;
+	try
+	{
+		funcCompoundStmt = parseCompoundStmt(true);
+	}
+	catch (ParseExcept& e)
+	{
+		// Something really bad happened here
+		reportError(e);
+		// Skip all the tokens until the } brace
+		consumeUntil(Token::RBrace);
+		if (peekToken() == Token::EndOfFile)
 		{
-			throw ParseExceptMsg("Function implementation missing");
+			throw EOFExcept();
 		}
-		
-		// Add the compound statement to this function
-		retVal->setBody(funcCompoundStmt);
+		consumeToken();
 	}
 	
-	return retVal;
+	// Exit the scope, before we potentially throw out of this function
+	// for a non-EOF message.
+	mSymbols.exitScope();
+	
+	if (!funcCompoundStmt)
+	{
+		throw ParseExceptMsg("Function implementation missing");
+	}
+	
+	// Add the compound statement to this function
+	func->setBody(funcCompoundStmt);
 }
 	
-shared_ptr<ASTArgDecl> Parser::parseArgDecl()
+ASTArgDecl* Parser::parseArgDecl()
 {
-	shared_ptr<ASTArgDecl> retVal;
+	ASTArgDecl* retVal = nullptr;
 	
 	if (peekIsOneOf({Token::Key_int, Token::Key_char}))
 	{
@@ -720,8 +817,8 @@ shared_ptr<ASTArgDecl> Parser::parseArgDecl()
 		
 		// For now, set it to the default "error" until we see if this is a new
 		// identifier
-		Identifier* ident = mSymbols.getIdentifier("@@variable");
-		if (mSymbols.isDeclaredInScope(getTokenTxt()))
+		Identifier* ident = mSymbols.getDummyVariable();
+		if (mSymbols.isDeclaredInScope(getTokenNameId()))
 		{
 			std::string errMsg("Invalid redeclaration of argument '");
 			errMsg += getTokenTxt();
@@ -730,7 +827,7 @@ shared_ptr<ASTArgDecl> Parser::parseArgDecl()
 		}
 		else
 		{
-			ident = mSymbols.createIdentifier(getTokenTxt());
+			ident = mSymbols.createIdentifier(getTokenNameId());
 		}
 		
 		consumeToken();
@@ -750,7 +847,7 @@ shared_ptr<ASTArgDecl> Parser::parseArgDecl()
 		}
 		ident->setType(varType);
 		
-		retVal = make_shared<ASTArgDecl>(*ident);
+		retVal = mArena.make<ASTArgDecl>(*ident);
 	}
 	
 	return retVal;
@@ -9,6 +9,7 @@
 //
 //  These functions are implemented in three different
 //  source files - Parse.cpp, ParseExpr.cpp, ParseStmt.cpp
+//  (ParseBodies.cpp parses function bodies in parallel)
 //
 //---------------------------------------------------------
 //  Copyright (c) 2014, Sanjay Madhav
@@ -21,15 +22,19 @@
 #pragma once
 
 #include "../scan/Tokens.h"
+#include "../scan/SourceFile.h"
+#include "../scan/TokenBuffer.h"
 #include <initializer_list>
-#include <fstream>
 #include <memory>
 #include <list>
+#include <unordered_map>
+#include <vector>
 #include "ASTNodes.h"
+#include "ASTArena.h"
+#include "FlatAST.h"
 #include "ParseExcept.h"
 #include "Symbols.h"
-
-class FlexLexer;
+#include "../opt/TimeReport.h"
 
 namespace uscc
 {
@@ -43,8 +48,14 @@ class Parser
 	friend class Emitter;
 public:
 	// Constructor takes in a file name and performs the parse
+	// If timeReport is non-null, the scanning and parsing time is added to it
+	// A large file is lexed on up to lexThreads threads, and the bodies of a
+	// file with many functions are parsed on up to parseThreads threads
+	// (0 for one per hardware thread)
 	Parser(const char* fileName, std::ostream* errStream,
-		   std::ostream* ASTStream = nullptr);
+		   std::ostream* ASTStream = nullptr,
+		   opt::TimeReport* timeReport = nullptr,
+		   unsigned lexThreads = 0, unsigned parseThreads = 0);
 	
 	// Destructor not virtual; I don't expect any inheritance
 	~Parser();
@@ -60,6 +71,18 @@ public:
 		return mErrors.size();
 	}
 	
+	// Returns the source text that was parsed
+	// (only valid as long as the parser is)
+	llvm::StringRef GetSourceText() const noexcept
+	{
+		return mSource.getText();
+	}
+	
+	// Statements and expressions can't be nested deeper than this.
+	// The parser and the AST walks recurse once per level, so compiles
+	// run on a thread with a stack big enough for this many levels.
+	static const unsigned int MaxNestingDepth = 200000;
+	
 protected:
 	// Various helper functions
 	
@@ -69,11 +92,48 @@ protected:
 		return mCurrToken;
 	}
 	
-	// Returns the string for the current token's text
-	const char* getTokenTxt() const noexcept;
+	// Returns the token that's ahead tokens after the current one
+	// (peekToken(0) is the current token).
+	// Anything past the end of the file is EndOfFile.
+	scan::Token::Tokens peekToken(size_t ahead) const noexcept;
+	
+	// Returns a copy of the current token's text
+	// (use getTokenView when a copy isn't needed)
+	std::string getTokenTxt() const
+	{
+		return getTokenView().str();
+	}
+	
+	// Returns the current token's text as a view into the source file
+	llvm::StringRef getTokenView() const noexcept;
+	
+	// Returns the ID the current identifier's name was interned as
+	// (only meaningful if the current token is an Identifier)
+	uint32_t getTokenNameId() const noexcept
+	{
+		return mTokens.getNameId(mTokenIndex);
+	}
+	
+	// Returns the byte offset of the current token in the source file
+	uint32_t getTokenOffset() const noexcept
+	{
+		return mTokens.getOffset(mTokenIndex);
+	}
+	
+	// Returns the line/column of the current token.
+	// These are worked out from its offset, so only
+	// ask for them when reporting an error.
+	unsigned int getLineNumber() const noexcept
+	{
+		return mSource.getLineNumber(getTokenOffset());
+	}
+	unsigned int getColNumber() const noexcept
+	{
+		return mSource.getColNumber(getTokenOffset());
+	}
 	
 	// Consumes the current token, and moves to the next
-	// token that's not a NewLine or Comment.
+	// token in the token buffer.
 	//
 	// Throws an exception if next token is Unknown,
 	// if unknownIsExcept is true
@@ -122,6 +182,23 @@ protected:
 	void reportError(const ParseExcept& except) noexcept;
 	void reportError(const std::string& msg) noexcept;
 	
+	// Counts one more level of nesting for as long as it's in scope.
+	// Past MaxNestingDepth, it reports an error and throws NestingTooDeep
+	class NestingGuard
+	{
+	public:
+		NestingGuard(Parser& parser);
+		~NestingGuard() noexcept
+		{
+			mParser.mNestingDepth -= mLevels;
+		}
+		// Counts another level, also released when the guard goes out of scope
+		void addLevel();
+	private:
+		Parser& mParser;
+		unsigned int mLevels;
+	};
+	
 	// Helper function to report a semantic error
 	// (These only display if mCheckSemant == true)
 	void reportSemantError(const std::string& msg, int colOverride = -1,
@@ -142,14 +219,14 @@ protected:
 	};
 	
 	// Write an error message to the error stream
-	void displayErrorMsg(const std::string& line, std::shared_ptr<Error> error) noexcept;
+	void displayErrorMsg(llvm::StringRef line, std::shared_ptr<Error> error) noexcept;
 	
 	// Writes out all the error messages
 	void displayErrors() noexcept;
 	
 	// Gets the variable, if it exists. Otherwise
 	// reports a semant error and returns @@variable
-	Identifier* getVariable(const char* name) noexcept;
+	Identifier* getVariable(uint32_t nameId) noexcept;
 	
 	// Returns a char* that contains the type name
 	const char* getTypeText(Type type) const noexcept;
@@ -157,111 +234,166 @@ protected:
 	// Takes the expression, and if it's an char expression, converts it to an int type
 	// expression.
 	// Otherwise it doesn't do anything.
-	std::shared_ptr<ASTExpr> charToInt(std::shared_ptr<ASTExpr> expr) noexcept;
+	ASTExpr* charToInt(ASTExpr* expr) noexcept;
 	
 	// Like the above, but in reverse
-	std::shared_ptr<ASTExpr> intToChar(std::shared_ptr<ASTExpr> expr) noexcept;
+	ASTExpr* intToChar(ASTExpr* expr) noexcept;
 	
 protected:
 	// These are all the mutually recursive parse functions
 	
 	// The entry point for the parser (in Parse.cpp)
-	std::shared_ptr<ASTProgram> parseProgram();
+	ASTProgram* parseProgram(unsigned numThreads);
 	
 	// Functions (in Parse.cpp)
-	std::shared_ptr<ASTFunction> parseFunction();
-	std::shared_ptr<ASTArgDecl> parseArgDecl();
+	ASTFunction* parseFunction();
+	// Parses the return type, name and arguments, and leaves
+	// the symbol table in the function's scope
+	ASTFunction* parseFunctionHeader();
+	// Parses the body of func, and exits the function's scope
+	void parseFunctionBody(ASTFunction* func);
+	ASTArgDecl* parseArgDecl();
+	
+	// Parallel parsing of function bodies (in ParseBodies.cpp)
+	
+	// Where a function's tokens are: mStart is its return type,
+	// mBody its {, and mEnd is the token after its }
+	struct FunctionBounds
+	{
+		size_t mStart;
+		size_t mBody;
+		size_t mEnd;
+	};
+	
+	// Finds every function in the file by matching braces,
+	// without parsing anything. Returns false if the file
+	// isn't a plain list of functions.
+	bool findFunctions(std::vector<FunctionBounds>& funcs) const noexcept;
+	
+	// Parses the headers in order, then the bodies on up to numThreads
+	// threads. Returns null, with the parser back at the first token,
+	// if the file has to be parsed serially instead.
+	ASTProgram* parseFunctionsInParallel(unsigned numThreads);
+	
+	// For a body parser: parses the body that starts at the token body.
+	// Returns false unless it parsed cleanly up to the token end.
+	bool parseBody(size_t body, size_t end) noexcept;
+	
+	// Throws out everything parsed so far, and goes back to the first token
+	void restartParse();
 	
 	// Declaration (in ParseStmt.cpp)
-	std::shared_ptr<ASTDecl> parseDecl();
+	ASTDecl* parseDecl();
 	
 	// Statements (in ParseStmt.cpp)
-	std::shared_ptr<ASTStmt> parseStmt();
+	ASTStmt* parseStmt();
 	// If the compound statement is a function body, then the symbol table scope
 	// change will happen at a higher level, so it shouldn't happen in
 	// parseCompoundStmt.
-	std::shared_ptr<ASTCompoundStmt> parseCompoundStmt(bool isFuncBody = false);
-	std::shared_ptr<ASTStmt> parseAssignStmt();
-	std::shared_ptr<ASTIfStmt> parseIfStmt();
-	std::shared_ptr<ASTWhileStmt> parseWhileStmt();
-	std::shared_ptr<ASTReturnStmt> parseReturnStmt();
-	std::shared_ptr<ASTExprStmt> parseExprStmt();
-	std::shared_ptr<ASTNullStmt> parseNullStmt();
+	ASTCompoundStmt* parseCompoundStmt(bool isFuncBody = false);
+	ASTStmt* parseAssignStmt();
+	ASTIfStmt* parseIfStmt();
+	ASTWhileStmt* parseWhileStmt();
+	ASTReturnStmt* parseReturnStmt();
+	ASTExprStmt* parseExprStmt();
+	ASTNullStmt* parseNullStmt();
 	
 	// Expressions (in ParseExpr.cpp)
-	std::shared_ptr<ASTExpr> parseExpr();
-	std::shared_ptr<ASTLogicalOr> parseExprPrime(std::shared_ptr<ASTExpr> lhs);
-	
-	// AndTerm (in ParseExpr.cpp)
-	std::shared_ptr<ASTExpr> parseAndTerm();
-	std::shared_ptr<ASTLogicalAnd> parseAndTermPrime(std::shared_ptr<ASTExpr> lhs);
-	
-	// RelExpr (in ParseExpr.cpp)
-	std::shared_ptr<ASTExpr> parseRelExpr();
-	std::shared_ptr<ASTBinaryCmpOp> parseRelExprPrime(std::shared_ptr<ASTExpr> lhs);
+	ASTExpr* parseExpr();
 	
-	// NumExpr (in ParseExpr.cpp)
-	std::shared_ptr<ASTExpr> parseNumExpr();
-	std::shared_ptr<ASTBinaryMathOp> parseNumExprPrime(std::shared_ptr<ASTExpr> lhs);
-	
-	// Term (in ParseExpr.cpp)
-	std::shared_ptr<ASTExpr> parseTerm();
-	std::shared_ptr<ASTBinaryMathOp> parseTermPrime(std::shared_ptr<ASTExpr> lhs);
+	// Binary operators (in ParseExpr.cpp)
+	// Parses a Value followed by any operators whose precedence
+	// is at least minPrecedence
+	ASTExpr* parseBinaryExpr(int minPrecedence);
+	// Makes the node for op, and checks the types of its operands
+	ASTExpr* makeBinaryOp(scan::Token::Tokens op, ASTExpr* lhs, ASTExpr* rhs,
+						  uint32_t opOffset);
 	
 	// Value (in ParseExpr.cpp)
-	std::shared_ptr<ASTExpr> parseValue();
+	ASTExpr* parseValue();
 	
 	// Factor (in ParseExpr.cpp)
-	std::shared_ptr<ASTExpr> parseFactor();
-	std::shared_ptr<ASTExpr> parseParenFactor();
-	std::shared_ptr<ASTConstantExpr> parseConstantFactor();
-	std::shared_ptr<ASTStringExpr> parseStringFactor();
+	ASTExpr* parseFactor();
+	ASTExpr* parseParenFactor();
+	ASTConstantExpr* parseConstantFactor();
+	ASTStringExpr* parseStringFactor();
 	// parseIdentFactor parses id, id [Expr], and id (FunCallArgs)
-	std::shared_ptr<ASTExpr> parseIdentFactor();
-	std::shared_ptr<ASTExpr> parseIncFactor();
-	std::shared_ptr<ASTExpr> parseDecFactor();
-	std::shared_ptr<ASTExpr> parseAddrOfArrayFactor();
+	ASTExpr* parseIdentFactor();
+	ASTExpr* parseIncFactor();
+	ASTExpr* parseDecFactor();
+	ASTExpr* parseAddrOfArrayFactor();
 	
 private:
 	// Disallow copy/assignment
-	Parser(const Parser& copy) { }
-	Parser& operator=(const Parser& rhs) { return *this; }
+	Parser(const Parser& copy) = delete;
+	Parser& operator=(const Parser& rhs) = delete;
+	
+	// Makes a parser for the body of func, the funcIndex-th function
+	// in file. It shares file's source, tokens and symbols.
+	Parser(Parser& file, ASTFunction& func, size_t funcIndex);
+	
+	// What the parser reads. Body parsers share their file's.
+	struct Input
+	{
+		Input(const char* fileName)
+		: mSource(fileName)
+		{ }
+		
+		scan::NamePool mNames;
+		scan::SourceFile mSource;
+		scan::TokenBuffer mTokens;
+	};
+	
+	// Every AST node for this file is allocated from here
+	ASTArena mArena;
 	
 	// Pointer to the root of our AST root
-	std::shared_ptr<ASTProgram> mRoot;
+	ASTProgram* mRoot;
+	// The AST, flattened once the parse succeeds
+	FlatAST mFlat;
 	
-	// Used to resolve AsisgnStmt/Factor ambiguity
-	Identifier* mUnusedIdent;
-	std::shared_ptr<ASTArraySub> mUnusedArray;
+	// Used to resolve AsisgnStmt/Factor ambiguity for id [ Expr ]
+	ASTArraySub* mUnusedArray;
 	
+	// Owns mNames, mSource and mTokens (null for body parsers)
+	std::unique_ptr<Input> mInput;
+	
+	// Names of the identifiers in the file (declared
+	// before mSymbols, since the table refers to it)
+	scan::NamePool& mNames;
 	// Symbol table corresponding to the parsed file
 	SymbolTable mSymbols;
 	// String table for this file
 	StringTable mStrings;
 	
-	// Flex wrapper class
-	FlexLexer* mLexer;
-
 	// Name of the file we're parsing
 	const char* mFileName;
-	// File stream that we use to process the file
-	std::ifstream mFileStream;
+	// Contents of the file, mapped into memory
+	scan::SourceFile& mSource;
+	// Every token in the file, lexed before the parse starts
+	scan::TokenBuffer& mTokens;
+	// Index of the current token in mTokens
+	size_t mTokenIndex;
+	// Index of the token consumeToken moves to next
+	size_t mNextIndex;
 	// Ostream exceptions should be output to
 	std::ostream* mErrStream;
 	// Ostream for AST output
 	std::ostream* mASTStream;
 	
+	// Report for -ftime-report (null if not requested)
+	opt::TimeReport* mTimeReport;
+	// CPU time spent by the threads that parsed bodies in parallel
+	double mWorkerCPU;
+	
 	// Tracks the return type of the current function
 	Type mCurrReturnType;
+	// The function currently being parsed
+	ASTFunction* mCurrFunction;
 	
 	// Current active token
 	uscc::scan::Token::Tokens mCurrToken;
 	
-	// Keeps track of the line number in the file
-	unsigned int mLineNumber;
-	// Keeps track of the column number in the current line
-	unsigned int mColNumber;
-	
 	// List used to store all of the errors
 	std::list<std::shared_ptr<Error>> mErrors;
 	
@@ -270,6 +402,21 @@ private:
 	
 	// Do we want to check for semantic errors?
 	bool mCheckSemant;
+	
+	// How many statements/expressions deep the parse currently is
+	unsigned int mNestingDepth;
+	
+	// For a body parser, the file's parser and the index of the function
+	Parser* mFileParser;
+	size_t mFuncIndex;
+	// Where each function was declared, so a body parsed in parallel
+	// can't see the functions declared after it
+	std::unordered_map<const Identifier*, size_t> mFunctionIndices;
+	// The parsers that hold the function bodies, if they were
+	// parsed in parallel (their arenas own the bodies' nodes)
+	std::vector<std::unique_ptr<Parser>> mBodyParsers;
+	// The string literals a body parser made, in order
+	std::vector<ASTStringExpr*> mStringExprs;
 };
 
 } // parse
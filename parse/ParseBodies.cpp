@@ -0,0 +1,303 @@
+//
+//  ParseBodies.cpp
+//  uscc
+//
+//  Implements parsing the bodies of a file's functions in
+//  parallel.
+//
+//  A body only needs the signatures of the functions declared
+//  before it, plus its own scopes. So the headers are parsed
+//  first, in order, which puts every function in the global
+//  scope. Then each body is parsed by a parser of its own,
+//  which shares the file's tokens and symbol table but has its
+//  own arena, errors and scopes. Merging the errors and string
+//  literals back in function order gives the same results as
+//  parsing the file serially.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#include "Parse.h"
+#include "StackThread.h"
+#include "../opt/MemReport.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+using namespace uscc::parse;
+using namespace uscc::scan;
+
+namespace
+{
+
+// Files with fewer functions than this aren't worth the threads
+const size_t minParallelFunctions = 32;
+
+// Threads that parse bodies need a stack big enough for a body
+// nested Parser::MaxNestingDepth deep (which takes about 64MB)
+const size_t bodyStackSize = 128 * 1024 * 1024;
+
+} // anonymous
+
+// Finds every function in the file by matching braces,
+// without parsing anything. Returns false if the file
+// isn't a plain list of functions.
+bool Parser::findFunctions(std::vector<FunctionBounds>& funcs) const noexcept
+{
+	// The buffer always ends with EndOfFile
+	size_t i = 0;
+	while (mTokens.getKind(i) != Token::EndOfFile)
+	{
+		FunctionBounds bounds;
+		bounds.mStart = i;
+
+		// A return type, then a name and a (
+		Token::Tokens type = mTokens.getKind(i);
+		if ((type != Token::Key_void && type != Token::Key_int && type != Token::Key_char) ||
+			mTokens.getKind(i + 1) != Token::Identifier ||
+			mTokens.getKind(i + 2) != Token::LParen)
+		{
+			return false;
+		}
+
+		// The arguments go up to the first ), which has to be
+		// right before the body
+		i += 3;
+		while (mTokens.getKind(i) != Token::RParen)
+		{
+			switch (mTokens.getKind(i))
+			{
+				case Token::EndOfFile:
+				case Token::Unknown:
+				case Token::LParen:
+				case Token::LBrace:
+				case Token::RBrace:
+					return false;
+				default:
+					i++;
+					break;
+			}
+		}
+		i++;
+		if (mTokens.getKind(i) != Token::LBrace)
+		{
+			return false;
+		}
+		bounds.mBody = i;
+
+		// The body ends at the } that matches its {
+		size_t depth = 0;
+		do
+		{
+			switch (mTokens.getKind(i))
+			{
+				case Token::LBrace:
+					depth++;
+					break;
+				case Token::RBrace:
+					depth--;
+					break;
+				case Token::EndOfFile:
+					return false;
+				default:
+					break;
+			}
+			i++;
+		}
+		while (depth > 0);
+		bounds.mEnd = i;
+
+		funcs.push_back(bounds);
+	}
+
+	return true;
+}
+
+// Parses the headers in order, then the bodies on up to numThreads
+// threads. Returns null, with the parser back at the first token,
+// if the file has to be parsed serially instead.
+ASTProgram* Parser::parseFunctionsInParallel(unsigned numThreads)
+{
+	if (numThreads == 0)
+	{
+		numThreads = std::thread::hardware_concurrency();
+	}
+
+	// --mem-report counts objects on the thread that made them
+	if (numThreads <= 1 || opt::MemReport::isActive())
+	{
+		return nullptr;
+	}
+
+	std::vector<FunctionBounds> bounds;
+	if (!findFunctions(bounds) || bounds.size() < minParallelFunctions)
+	{
+		return nullptr;
+	}
+
+	// The headers are parsed in order, so every function is in the
+	// global scope before any body is parsed. Each header's errors
+	// are set aside, to go in front of its body's.
+	std::vector<ASTFunction*> funcs;
+	std::vector<std::list<std::shared_ptr<Error>>> headerErrors(bounds.size());
+	try
+	{
+		for (size_t i = 0; i < bounds.size(); i++)
+		{
+			ASTFunction* func = parseFunctionHeader();
+			if (!func)
+			{
+				restartParse();
+				return nullptr;
+			}
+			mSymbols.exitScope();
+			headerErrors[i].splice(headerErrors[i].end(), mErrors);
+
+			// A header with a syntax error may not have stopped at the body
+			if (mTokenIndex != bounds[i].mBody)
+			{
+				restartParse();
+				return nullptr;
+			}
+
+			if (!func->getIdent().isDummy())
+			{
+				mFunctionIndices.emplace(&func->getIdent(), i);
+			}
+			funcs.push_back(func);
+
+			// Skip the body for now
+			mNextIndex = bounds[i].mEnd;
+			consumeToken();
+		}
+	}
+	catch (ParseExcept&)
+	{
+		restartParse();
+		return nullptr;
+	}
+
+	for (size_t i = 0; i < funcs.size(); i++)
+	{
+		mBodyParsers.emplace_back(new Parser(*this, *funcs[i], i));
+	}
+
+	// Each thread grabs the next body that hasn't been started yet
+	std::vector<char> parsed(funcs.size(), false);
+	std::atomic<size_t> nextBody(0);
+	std::function<void()> parseBodies = [this, &bounds, &parsed, &nextBody]()
+	{
+		size_t curr = nextBody++;
+		while (curr < bounds.size())
+		{
+			parsed[curr] = mBodyParsers[curr]->parseBody(bounds[curr].mBody,
+														 bounds[curr].mEnd);
+			curr = nextBody++;
+		}
+	};
+
+	numThreads = static_cast<unsigned>(std::min(static_cast<size_t>(numThreads),
+												funcs.size()));
+	std::vector<std::unique_ptr<StackThread>> workers;
+	std::vector<double> workerCPU(numThreads, 0.0);
+	bool timed = mTimeReport != nullptr;
+	for (unsigned i = 1; i < numThreads; i++)
+	{
+		// -ftime-report only sees this thread's time, so
+		// the others keep track of their own
+		workers.emplace_back(new StackThread([&parseBodies, &workerCPU, timed, i]()
+		{
+			opt::Stopwatch timer(timed);
+			parseBodies();
+			if (timed)
+			{
+				workerCPU[i] = timer.elapsed().mCPU;
+			}
+		}, bodyStackSize));
+	}
+	// This thread (which already has a big enough stack) works too
+	parseBodies();
+	for (auto& t : workers)
+	{
+		t->join();
+	}
+	for (double cpu : workerCPU)
+	{
+		mWorkerCPU += cpu;
+	}
+
+	// A body that threw, or didn't end at its }, would've been
+	// parsed differently as part of the whole file
+	if (std::find(parsed.begin(), parsed.end(), false) != parsed.end())
+	{
+		restartParse();
+		return nullptr;
+	}
+
+	ASTProgram* retVal = mArena.make<ASTProgram>();
+	for (size_t i = 0; i < funcs.size(); i++)
+	{
+		Parser& body = *mBodyParsers[i];
+		mErrors.splice(mErrors.end(), headerErrors[i]);
+		mErrors.splice(mErrors.end(), body.mErrors);
+		mNeedPrintf = mNeedPrintf || body.mNeedPrintf;
+
+		// Adding the strings in source order fills the string table
+		// the same way a serial parse would
+		for (ASTStringExpr* str : body.mStringExprs)
+		{
+			str->moveTo(mStrings);
+		}
+
+		retVal->addFunction(funcs[i]);
+	}
+	mCurrFunction = funcs.back();
+
+	return retVal;
+}
+
+// For a body parser: parses the body that starts at the token body.
+// Returns false unless it parsed cleanly up to the token end.
+bool Parser::parseBody(size_t body, size_t end) noexcept
+{
+	try
+	{
+		mNextIndex = body;
+		consumeToken();
+		parseFunctionBody(mCurrFunction);
+	}
+	catch (ParseExcept&)
+	{
+		return false;
+	}
+	catch (NestingTooDeep&)
+	{
+		return false;
+	}
+
+	return mTokenIndex == end;
+}
+
+// Throws out everything parsed so far, and goes back to the first token
+void Parser::restartParse()
+{
+	// The body parsers refer to the scopes the symbol table owns
+	mBodyParsers.clear();
+	mSymbols.reset();
+	mFunctionIndices.clear();
+	mErrors.clear();
+	mNeedPrintf = false;
+	mCurrFunction = nullptr;
+	mUnusedArray = nullptr;
+	mNestingDepth = 0;
+
+	mNextIndex = 0;
+	consumeToken();
+}
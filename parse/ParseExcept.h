@@ -16,6 +16,7 @@
 
 #include <exception>
 #include <ostream>
+#include <string>
 #include "../scan/Tokens.h"
 
 namespace uscc
@@ -70,19 +71,25 @@ public:
 	}
 };
 
+// Thrown once statements or expressions are nested deeper than
+// the parser allows. This isn't a ParseExcept, so the parse
+// functions don't try to recover from it, and the parse stops.
+class NestingTooDeep : public virtual std::exception
+{
+public:
+	virtual const char* what() const noexcept override
+	{
+		return "Nesting too deep";
+	}
+};
+
 class UnknownToken : public virtual ParseExcept
 {
 public:
-	UnknownToken(const char* tokStr, unsigned int& colNum)
+	UnknownToken(const std::string& tokStr)
 	: mToken(tokStr)
-	, mColNum(colNum)
 	{ }
 	
-	virtual ~UnknownToken() override
-	{
-		mColNum++;
-	}
-	
 	virtual const char* what() const noexcept override
 	{
 		return "Unknown token";
@@ -90,15 +97,14 @@ public:
 	
 	virtual void printException(std::ostream& output) const noexcept override;
 private:
-	const char* mToken;
-	unsigned int& mColNum;
+	std::string mToken;
 };
 	
 class TokenMismatch : public virtual ParseExcept
 {
 public:
 	TokenMismatch(scan::Token::Tokens expected, scan::Token::Tokens actual,
-				  const char* tokStr)
+				  const std::string& tokStr)
 	: mExpectedTok(expected)
 	, mActualTok(actual)
 	, mTokenStr(tokStr)
@@ -114,7 +120,7 @@ public:
 private:
 	scan::Token::Tokens mExpectedTok;
 	scan::Token::Tokens mActualTok;
-	const char* mTokenStr;
+	std::string mTokenStr;
 };
 	
 class OperandMissing : public virtual ParseExcept
@@ -4,6 +4,8 @@
 //
 //  Implements all of the recursive descent parsing
 //  functions for the expression grammar rules.
+//  Binary operators are parsed by precedence climbing,
+//  using the precedences in Tokens.def.
 //
 //---------------------------------------------------------
 //  Copyright (c) 2014, Sanjay Madhav
@@ -20,299 +22,150 @@
 using namespace uscc::parse;
 using namespace uscc::scan;
 
-using std::shared_ptr;
-using std::make_shared;
-
-shared_ptr<ASTExpr> Parser::parseExpr()
+namespace
 {
-    shared_ptr<ASTExpr> retVal;
-    
-    // We should first get a AndTerm
-    shared_ptr<ASTExpr> andTerm = parseAndTerm();
-    // If we didn't get an andTerm, then this isn't an Expr
-    if (andTerm)            // this is an Expr
-    {
-        retVal = andTerm;
-        // Check if this is followed by an op (optional)
-        shared_ptr<ASTLogicalOr> exprPrime = parseExprPrime(retVal);        // || operator
-        
-        if (exprPrime)
-        {
-            // If we got a exprPrime, return this instead of just term
-            retVal = exprPrime;
-        }
-    }
-    
-    return retVal;
-}
 
-shared_ptr<ASTLogicalOr> Parser::parseExprPrime(shared_ptr<ASTExpr> lhs)
+// Precedence of each token as a binary operator, from the
+// BINARY_OP entries in Tokens.def (0 if it isn't one)
+const int binaryPrecedence[] =
 {
-    shared_ptr<ASTLogicalOr> retVal;
-    
-    // Must be ||
-    if (peekToken() == Token::Or)
-    {
-        // Make the binary cmp op
-        Token::Tokens op = peekToken();
-        retVal = make_shared<ASTLogicalOr>();
-        consumeToken();
-        
-        // Set the lhs to our parameter
-        retVal->setLHS(lhs);
-        
-        // We MUST get a AndTerm as the RHS of this operand
-        shared_ptr<ASTExpr> rhs = parseAndTerm();
-        if (!rhs)
-        {
-            throw OperandMissing(op);
-        }
-        
-        retVal->setRHS(rhs);
-        
-        // PA2: Finalize op
-        if(!retVal->finalizeOp())
-        {
-            std::string msg = "Cannot perform op between type ";
-            msg += getTypeText(lhs->getType());
-            msg += " and ";
-            msg += getTypeText(rhs->getType());
-            reportSemantError(msg,14);
-        }
-        
-        // See comment in parseTermPrime if you're confused by this
-        shared_ptr<ASTLogicalOr> exprPrime = parseExprPrime(retVal);
-        if (exprPrime)
-        {
-            retVal = exprPrime;
-        }
-    }
-    
-    return retVal;
-}
+    #define TOKEN(a,b,c) 0,
+    #define BINARY_OP(a,b,c,d) d,
+    #include "../scan/Tokens.def"
+    #undef TOKEN
+};
 
-// AndTerm -->
-shared_ptr<ASTExpr> Parser::parseAndTerm()
+// Sets the operands of a binary op node, and returns
+// whether their types are valid for it
+template <typename T>
+bool setOperands(T* node, ASTExpr* lhs, ASTExpr* rhs) noexcept
 {
-    shared_ptr<ASTExpr> retVal;
-    retVal = parseRelExpr();       // should call parseNumExpr
-    
-    if(peekToken() == Token::And)
-    {
-        retVal = parseAndTermPrime(retVal);
-    }
-    
-    return retVal;
+    node->setLHS(lhs);
+    node->setRHS(rhs);
+    return node->finalizeOp();
 }
 
-shared_ptr<ASTLogicalAnd> Parser::parseAndTermPrime(shared_ptr<ASTExpr> lhs)
+} // anonymous
+
+ASTExpr* Parser::parseExpr()
 {
-    shared_ptr<ASTLogicalAnd> retVal;
-    shared_ptr<ASTExpr> rhs;
-    if(peekToken() == Token::And)
-    {
-        Token::Tokens op = peekToken();
-        retVal = make_shared<ASTLogicalAnd>();
-        consumeToken();
-        rhs = parseAndTerm();
-        if (!rhs)
-        {
-            throw OperandMissing(op);
-        }
-        retVal->setLHS(lhs);
-        retVal->setRHS(rhs);
-        if(!retVal->finalizeOp())
-        {
-            std::string msg = "Cannot perform op between type ";
-            msg += getTypeText(lhs->getType());
-            msg += " and ";
-            msg += getTypeText(rhs->getType());
-            reportSemantError(msg,14);
-        }
-        if(peekToken() == Token::And)
-        {
-            retVal = parseAndTermPrime(retVal);
-            return retVal;
-        }
-    }
-    return retVal;
+    // || has the lowest precedence, so this takes every binary operator
+    return parseBinaryExpr(binaryPrecedence[Token::Or]);
 }
 
-// RelExpr -->
-shared_ptr<ASTExpr> Parser::parseRelExpr()
+// Precedence climbing: each operator takes as its rhs everything
+// after it that binds more tightly, so the loop only recurses once
+// per operator instead of once per precedence level
+ASTExpr* Parser::parseBinaryExpr(int minPrecedence)
 {
-    shared_ptr<ASTExpr> retVal;
-    retVal = parseNumExpr();        // this will parse value
-    if(peekToken() == Token::LessThan || peekToken() == Token::GreaterThan || peekToken() == Token::NotEqual || peekToken() == Token::EqualTo)
+    // Parens, subscripts, call arguments and && chains all nest through here
+    NestingGuard nesting(*this);
+    ASTExpr* retVal = parseValue();
+    if (!retVal)
     {
-        retVal = parseRelExprPrime(retVal);
+        return retVal;
     }
     
-    return retVal;
-}
-
-shared_ptr<ASTBinaryCmpOp> Parser::parseRelExprPrime(shared_ptr<ASTExpr> lhs)
-{
-    shared_ptr<ASTBinaryCmpOp> retVal;
-    shared_ptr<ASTExpr> rhs;
-    if(peekToken() == Token::LessThan || peekToken() == Token::GreaterThan || peekToken() == Token::NotEqual || peekToken() == Token::EqualTo)
+    int precedence = binaryPrecedence[peekToken()];
+    while (precedence != 0 && precedence >= minPrecedence)
     {
+        // Each operator in a left associative chain (a + b + c) puts
+        // everything before it one level deeper in the AST, without recursing
+        nesting.addLevel();
+        
         Token::Tokens op = peekToken();
-        retVal = make_shared<ASTBinaryCmpOp>(peekToken());
-        consumeToken();                 // token is now rhs
-        rhs = parseNumExpr();            // should not call expr because it will call parseRel again
-        if (!rhs)
-        {
-            throw OperandMissing(op);
-        }
-        retVal->setLHS(lhs);
-        retVal->setRHS(rhs);
-        //PA2: op check
-        if(!retVal->finalizeOp())
-        {
-            std::string msg = "Cannot perform op between type ";
-            msg += getTypeText(lhs->getType());
-            msg += " and ";
-            msg += getTypeText(rhs->getType());
-            reportSemantError(msg);
-        }
-        // token is now operand
-        if(peekToken() == Token::LessThan || peekToken() == Token::GreaterThan || peekToken() == Token::NotEqual || peekToken() == Token::EqualTo)
+        uint32_t opOffset = getTokenOffset();
+        consumeToken();
+        
+        // && is right associative (a && (b && c)), everything
+        // else is left associative
+        int rhsPrecedence = precedence + 1;
+        if (op == Token::And)
         {
-            retVal = parseRelExprPrime(retVal);
-            return retVal;
+            rhsPrecedence = precedence;
         }
-        if(peekToken() == Token::Mult || peekToken() == Token::Div || peekToken() == Token::Mod)
+        
+        ASTExpr* rhs = parseBinaryExpr(rhsPrecedence);
+        if (!rhs)
         {
-            // retVal->setRHS(parseTermPrime(rhs));
+            throw OperandMissing(op);
         }
         
-        else return retVal;
-    }
-    return retVal;
-}
-
-// NumExpr --> handle + and -
-shared_ptr<ASTExpr> Parser::parseNumExpr()
-{
-    shared_ptr<ASTExpr> retVal;
-    retVal = parseValue();               // retval is lhs (will consume token)
-    
-    if(peekToken() == Token::Plus || peekToken() == Token::Minus)
-    {
-        // current token is operand
-        retVal = parseNumExprPrime(retVal);     // handle operator
+        retVal = makeBinaryOp(op, retVal, rhs, opOffset);
+        precedence = binaryPrecedence[peekToken()];
     }
-    if(peekToken() == Token::Mult || peekToken() == Token::Div || peekToken() == Token::Mod)
-    {
-        retVal = parseTermPrime(retVal);        // should call parseterm
-    }
-    
-    else return retVal;
     
     return retVal;
 }
 
-shared_ptr<ASTBinaryMathOp> Parser::parseNumExprPrime(shared_ptr<ASTExpr> lhs)
+ASTExpr* Parser::makeBinaryOp(Token::Tokens op, ASTExpr* lhs, ASTExpr* rhs,
+                              uint32_t opOffset)
 {
-    shared_ptr<ASTBinaryMathOp> retVal;
-    shared_ptr<ASTExpr> rhs;
-    if(peekToken() == Token::Plus || peekToken() == Token::Minus)
+    ASTExpr* retVal = nullptr;
+    bool valid = false;
+    switch (op)
     {
-        Token::Tokens op = peekToken();
-        retVal = make_shared<ASTBinaryMathOp>(peekToken());
-        consumeToken();                 // token is now rhs
-        rhs = parseFactor();            // token is at the end
-        if (!rhs)
+        case Token::Or:
         {
-            throw OperandMissing(op);
+            ASTLogicalOr* node = mArena.make<ASTLogicalOr>();
+            valid = setOperands(node, lhs, rhs);
+            retVal = node;
+            break;
         }
-        retVal->setLHS(lhs);
-        retVal->setRHS(rhs);
-        if(!retVal->finalizeOp())
+        case Token::And:
         {
-            std::string msg = "Cannot perform op between type ";
-            msg += getTypeText(lhs->getType());
-            msg += " and ";
-            msg += getTypeText(rhs->getType());
-            reportSemantError(msg,14);
+            ASTLogicalAnd* node = mArena.make<ASTLogicalAnd>();
+            valid = setOperands(node, lhs, rhs);
+            retVal = node;
+            break;
         }
-        // token is now operand
-        if(peekToken() == Token::Plus || peekToken() == Token::Minus)
+        case Token::EqualTo:
+        case Token::NotEqual:
+        case Token::LessThan:
+        case Token::GreaterThan:
         {
-            retVal = parseNumExprPrime(retVal);
-            return retVal;
+            ASTBinaryCmpOp* node = mArena.make<ASTBinaryCmpOp>(op);
+            valid = setOperands(node, lhs, rhs);
+            retVal = node;
+            break;
         }
-        if(peekToken() == Token::Mult || peekToken() == Token::Div || peekToken() == Token::Mod)
+        default:
         {
-            retVal->setRHS(parseTermPrime(rhs));
+            ASTBinaryMathOp* node = mArena.make<ASTBinaryMathOp>(op);
+            valid = setOperands(node, lhs, rhs);
+            retVal = node;
+            break;
         }
-        if(peekToken() == Token::LessThan) {
-            //retVal->setRHS(parseRelExprPrime(rhs));
-        }
-    }
-    return retVal;
-}
-
-// Term -->
-shared_ptr<ASTExpr> Parser::parseTerm()
-{
-    shared_ptr<ASTExpr> retVal;
-    retVal = parseValue();
-    if(peekToken() == Token::Mult || peekToken() == Token::Div || peekToken() == Token::Mod)
-    {
-        retVal = parseTermPrime(retVal);        //retval is lhs
     }
-    return retVal;
-}
-
-shared_ptr<ASTBinaryMathOp> Parser::parseTermPrime(shared_ptr<ASTExpr> lhs)
-{
-    shared_ptr<ASTBinaryMathOp> retVal;
-    shared_ptr<ASTExpr> rhs;
-    if(peekToken() == Token::Mult || peekToken() == Token::Div || peekToken() == Token::Mod)
+    
+    // PA2: Finalize op
+    // The error points at the operator
+    if (!valid)
     {
-        retVal = make_shared<ASTBinaryMathOp>(peekToken()); // create
-        consumeToken();         //token is rhs num
-        rhs = parseFactor();        // grab rhs
-        retVal->setLHS(lhs);
-        retVal->setRHS(rhs);
-        //pa2: op check
-        if(!retVal->finalizeOp())
-        {
-            std::string msg = "Cannot perform op between type ";
-            msg += getTypeText(lhs->getType());
-            msg += " and ";
-            msg += getTypeText(rhs->getType());
-            reportSemantError(msg,14);
-        }
-        // token is now pointing at operand
-        if(peekToken() == Token::Mult || peekToken() == Token::Div || peekToken() == Token::Mod)
-        {
-            retVal = parseTermPrime(retVal);
-            return retVal;
-        }
-        if(peekToken() == Token::LessThan) {
-            return retVal;
-        }
-        ///else return retVal;         // end recursion
+        std::string msg = "Cannot perform op between type ";
+        msg += getTypeText(lhs->getType());
+        msg += " and ";
+        msg += getTypeText(rhs->getType());
+        reportSemantError(msg, mSource.getColNumber(opOffset),
+                          mSource.getLineNumber(opOffset));
     }
+    
     return retVal;
 }
 
 // Value -->
-shared_ptr<ASTExpr> Parser::parseValue()
+ASTExpr* Parser::parseValue()
 {
-    shared_ptr<ASTExpr> retVal;
+    ASTExpr* retVal = nullptr;
     if(peekAndConsume(Token::Not))
     {
-        shared_ptr<ASTExpr> temp;
+        ASTExpr* temp = nullptr;
         temp = parseFactor();
         if(!temp)
         {
             throw ParseExceptMsg("! must be followed by an expression.");
         }
-        retVal = make_shared<ASTNotExpr>(temp);
+        retVal = mArena.make<ASTNotExpr>(temp);
     }
     else                // regualr value
     {
@@ -322,35 +175,54 @@ shared_ptr<ASTExpr> Parser::parseValue()
 }
 
 // Factor -->
-shared_ptr<ASTExpr> Parser::parseFactor()
+ASTExpr* Parser::parseFactor()
 {
-    shared_ptr<ASTExpr> retVal;
+    ASTExpr* retVal = nullptr;
     
     // Try parse identifier factors FIRST so
-    // we make sure to consume the mUnusedIdents
+    // we make sure to consume the mUnusedArray
     // before we try any other rules
-    if ((retVal = parseIdentFactor()))
-        ;
-    else if((retVal = parseConstantFactor()))
-        ;
-    else if((retVal = parseStringFactor()))
-        ;
-    else if((retVal = parseParenFactor()))
-        ;
-    else if((retVal = parseIncFactor()))
-        ;
-    else if((retVal = parseDecFactor()))
-        ;
-    else if((retVal = parseAddrOfArrayFactor()))
-        ;
+    // (Otherwise, every rule starts with a different token)
+    Token::Tokens token = peekToken();
+    if (mUnusedArray != nullptr)
+    {
+        token = Token::Identifier;
+    }
+    
+    switch (token)
+    {
+        case Token::Identifier:
+            retVal = parseIdentFactor();
+            break;
+        case Token::Constant:
+            retVal = parseConstantFactor();
+            break;
+        case Token::String:
+            retVal = parseStringFactor();
+            break;
+        case Token::LParen:
+            retVal = parseParenFactor();
+            break;
+        case Token::Inc:
+            retVal = parseIncFactor();
+            break;
+        case Token::Dec:
+            retVal = parseDecFactor();
+            break;
+        case Token::Addr:
+            retVal = parseAddrOfArrayFactor();
+            break;
+        default:
+            break;
+    }
     
     return retVal;
 }
 
 // ( Expr )
-shared_ptr<ASTExpr> Parser::parseParenFactor()
+ASTExpr* Parser::parseParenFactor()
 {
-    shared_ptr<ASTExpr> retVal;
+    ASTExpr* retVal = nullptr;
     if(peekToken() == Token::LParen)
     {
         consumeToken();                 // eat (
@@ -369,13 +241,13 @@ shared_ptr<ASTExpr> Parser::parseParenFactor()
 }
 
 // constant
-shared_ptr<ASTConstantExpr> Parser::parseConstantFactor()
+ASTConstantExpr* Parser::parseConstantFactor()
 {
-    shared_ptr<ASTConstantExpr> retVal;
+    ASTConstantExpr* retVal = nullptr;
     
     if(peekToken() == (Token::Constant))
     {
-        retVal = make_shared<ASTConstantExpr>(getTokenTxt());
+        retVal = mArena.make<ASTConstantExpr>(getTokenTxt());
         consumeToken(); // eat constant
     }
     
@@ -383,12 +255,16 @@ shared_ptr<ASTConstantExpr> Parser::parseConstantFactor()
 }
 
 // string
-shared_ptr<ASTStringExpr> Parser::parseStringFactor()
+ASTStringExpr* Parser::parseStringFactor()
 {
-    shared_ptr<ASTStringExpr> retVal;
+    ASTStringExpr* retVal = nullptr;
     if(peekToken() == (Token::String))
     {
-        retVal = make_shared<ASTStringExpr>(getTokenTxt(),mStrings);
+        retVal = mArena.make<ASTStringExpr>(getTokenTxt(),mStrings);
+        if (mFileParser)
+        {
+            mStringExprs.push_back(retVal);
+        }
         consumeToken();         // eat string
     }
     return retVal;
@@ -397,11 +273,10 @@ shared_ptr<ASTStringExpr> Parser::parseStringFactor()
 // id
 // id [ Expr ]
 // id ( FuncCallArgs )
-shared_ptr<ASTExpr> Parser::parseIdentFactor()
+ASTExpr* Parser::parseIdentFactor()
 {
-    shared_ptr<ASTExpr> retVal;
-    if (peekToken() == Token::Identifier ||
-        mUnusedIdent != nullptr || mUnusedArray != nullptr)
+    ASTExpr* retVal = nullptr;
+    if (peekToken() == Token::Identifier || mUnusedArray != nullptr)
     {
         
         if (mUnusedArray)
@@ -409,26 +284,13 @@ shared_ptr<ASTExpr> Parser::parseIdentFactor()
             // "unused array" means that AssignStmt looked at this array
             // and decided it didn't want it, so it's already made an
             // array sub node
-            retVal = make_shared<ASTArrayExpr>(mUnusedArray);
+            retVal = mArena.make<ASTArrayExpr>(mUnusedArray);
             mUnusedArray = nullptr;
         }
         else
         {
-            Identifier* ident = nullptr;
-            
-            // If we have an "unused identifier," which means that
-            // AssignStmt looked at this and decided it didn't want it,
-            // that means we're already a token AFTER the identifier.
-            if (mUnusedIdent)
-            {
-                ident = mUnusedIdent;
-                mUnusedIdent = nullptr;
-            }
-            else
-            {
-                ident = getVariable(getTokenTxt());
-                consumeToken();
-            }
+            Identifier* ident = getVariable(getTokenNameId());
+            consumeToken();
             
             // Now we need to look ahead and see if this is an array
             // or function call reference, since id is a common
@@ -453,21 +315,21 @@ shared_ptr<ASTExpr> Parser::parseIdentFactor()
                     matchToken(Token::RBracket);
                     
                     // Just return our error variable
-                    retVal = make_shared<ASTIdentExpr>(*mSymbols.getIdentifier("@@variable"));
+                    retVal = mArena.make<ASTIdentExpr>(*mSymbols.getDummyVariable());
                 }
                 else
                 {
                     consumeToken();
                     try
                     {
-                        shared_ptr<ASTExpr> expr = parseExpr();
+                        ASTExpr* expr = parseExpr();
                         if (!expr)
                         {
                             throw ParseExceptMsg("Valid expression required inside [ ].");
                         }
                         
-                        shared_ptr<ASTArraySub> array = make_shared<ASTArraySub>(*ident, expr);
-                        retVal = make_shared<ASTArrayExpr>(array);
+                        ASTArraySub* array = mArena.make<ASTArraySub>(*ident, expr);
+                        retVal = mArena.make<ASTArrayExpr>(array);
                     }
                     catch (ParseExcept& e)
                     {
@@ -502,23 +364,27 @@ shared_ptr<ASTExpr> Parser::parseIdentFactor()
                     matchToken(Token::RParen);
                     
                     // Just return our error variable
-                    retVal = make_shared<ASTIdentExpr>(*mSymbols.getIdentifier("@@variable"));
+                    retVal = mArena.make<ASTIdentExpr>(*mSymbols.getDummyVariable());
                 }
                 else
                 {
                     consumeToken();
                     // A function call can have zero or more arguments
-                    shared_ptr<ASTFuncExpr> funcCall = make_shared<ASTFuncExpr>(*ident);
+                    ASTFuncExpr* funcCall = mArena.make<ASTFuncExpr>(*ident);
                     retVal = funcCall;
+                    if (mCurrFunction)
+                    {
+                        mCurrFunction->addCallee(*ident);
+                    }
                     
                     // Get the number of arguments for this function
-                    shared_ptr<ASTFunction> func = ident->getFunction();
+                    ASTFunction* func = ident->getFunction();
                     
                     try
                     {
                         int currArg = 1;
-                        int col = mColNumber;
-                        shared_ptr<ASTExpr> arg = parseExpr();
+                        uint32_t colOffset = getTokenOffset();
+                        ASTExpr* arg = parseExpr();
                         while (arg)
                         {
                             // Check for validity of this argument (for non-dummy functions)
@@ -544,7 +410,7 @@ shared_ptr<ASTExpr> Parser::parseIdentFactor()
                                         ss << func->getNumArgs();
                                         err += ss.str();
                                         err += " arguments";
-                                        reportSemantError(err, col);
+                                        reportSemantError(err, mSource.getColNumber(colOffset));
                                     }
                                     else if (!func->checkArgType(currArg, arg->getType()))
                                     {
@@ -568,7 +434,7 @@ shared_ptr<ASTExpr> Parser::parseIdentFactor()
                                         {
                                             std::string err("Expected expression of type ");
                                             err += getTypeText(func->getArgType(currArg));
-                                            reportSemantError(err, col);
+                                            reportSemantError(err, mSource.getColNumber(colOffset));
                                         }
                                     }
                                 }
@@ -580,7 +446,7 @@ shared_ptr<ASTExpr> Parser::parseIdentFactor()
                             
                             if (peekAndConsume(Token::Comma))
                             {
-                                col = mColNumber;
+                                colOffset = getTokenOffset();
                                 arg = parseExpr();
                                 if (!arg)
                                 {
@@ -634,7 +500,7 @@ shared_ptr<ASTExpr> Parser::parseIdentFactor()
             else
             {
                 // Just a plain old ident
-                retVal = make_shared<ASTIdentExpr>(*ident);
+                retVal = mArena.make<ASTIdentExpr>(*ident);
                 
             }
         }
@@ -644,14 +510,14 @@ shared_ptr<ASTExpr> Parser::parseIdentFactor()
 }
 
 // ++ id
-shared_ptr<ASTExpr> Parser::parseIncFactor()
+ASTExpr* Parser::parseIncFactor()
 {
-    shared_ptr<ASTExpr> retVal;
+    ASTExpr* retVal = nullptr;
     if(peekToken() == Token::Inc)
     {
         consumeToken();
-        Identifier* ident = getVariable(getTokenTxt());
-        retVal = make_shared<ASTIncExpr>(*ident);
+        Identifier* ident = getVariable(getTokenNameId());
+        retVal = mArena.make<ASTIncExpr>(*ident);
         consumeToken();             // eat identifier
         retVal = charToInt(retVal);
         
@@ -660,14 +526,14 @@ shared_ptr<ASTExpr> Parser::parseIncFactor()
 }
 
 // -- id
-shared_ptr<ASTExpr> Parser::parseDecFactor()
+ASTExpr* Parser::parseDecFactor()
 {
-    shared_ptr<ASTExpr> retVal;
+    ASTExpr* retVal = nullptr;
     if(peekToken() == Token::Dec)
     {
         consumeToken();
-        Identifier* ident = getVariable(getTokenTxt());
-        retVal = make_shared<ASTDecExpr>(*ident);
+        Identifier* ident = getVariable(getTokenNameId());
+        retVal = mArena.make<ASTDecExpr>(*ident);
         consumeToken();
         retVal = charToInt(retVal);
     }
@@ -675,16 +541,16 @@ shared_ptr<ASTExpr> Parser::parseDecFactor()
 }
 
 // & id [ Expr ]
-shared_ptr<ASTExpr> Parser::parseAddrOfArrayFactor()
+ASTExpr* Parser::parseAddrOfArrayFactor()
 {
-    shared_ptr<ASTExpr> retVal;
-    shared_ptr<ASTArraySub> array;
-    shared_ptr<ASTExpr> expr;
+    ASTExpr* retVal = nullptr;
+    ASTArraySub* array = nullptr;
+    ASTExpr* expr = nullptr;
     
     if(peekToken() == Token::Addr)
     {
         consumeToken();         // consume &
-        Identifier* ident = getVariable(getTokenTxt());
+        Identifier* ident = getVariable(getTokenNameId());
         if(peekToken() == Token::SemiColon)
         {   
             throw ParseExceptMsg("& must be followed by an identifier.");
@@ -693,8 +559,8 @@ shared_ptr<ASTExpr> Parser::parseAddrOfArrayFactor()
         if(peekToken() == Token::LBracket)
         {
             consumeToken();         // consume LBracket
-            shared_ptr<ASTExpr> expr = parseConstantFactor();
-            array = make_shared<ASTArraySub>(*ident,expr);
+            ASTExpr* expr = parseConstantFactor();
+            array = mArena.make<ASTArraySub>(*ident,expr);
             if(!expr) {
                 throw ParseExceptMsg("Missing required subscript expression.");
             }
@@ -703,7 +569,7 @@ shared_ptr<ASTExpr> Parser::parseAddrOfArrayFactor()
         
         // check for empty expr
         
-        retVal = make_shared<ASTAddrOfArray>(array);
+        retVal = mArena.make<ASTAddrOfArray>(array);
         
     }
     return retVal;
@@ -19,12 +19,9 @@
 using namespace uscc::parse;
 using namespace uscc::scan;
 
-using std::shared_ptr;
-using std::make_shared;
-
-shared_ptr<ASTDecl> Parser::parseDecl()
+ASTDecl* Parser::parseDecl()
 {
-	shared_ptr<ASTDecl> retVal;
+	ASTDecl* retVal = nullptr;
 	// A decl MUST start with int or char
 	if (peekIsOneOf({Token::Key_int, Token::Key_char}))
 	{
@@ -42,7 +39,7 @@ shared_ptr<ASTDecl> Parser::parseDecl()
 		
 		// Set this to @@variable for now. We'll later change it
 		// assuming we parse the identifier properly
-		Identifier* ident = mSymbols.getIdentifier("@@variable");
+		Identifier* ident = mSymbols.getDummyVariable();
 		
 		// Now we MUST get an identifier so go into a try
 		try
@@ -51,7 +48,7 @@ shared_ptr<ASTDecl> Parser::parseDecl()
 			{
 				throw ParseExceptMsg("Type must be followed by identifier");
 			}
-            if(mSymbols.isDeclaredInScope(getTokenTxt()))
+            if(mSymbols.isDeclaredInScope(getTokenNameId()))
             {
                 std::string msg ="Invalid redeclaration of identifier ";
                 std::string var = "\'";
@@ -60,14 +57,14 @@ shared_ptr<ASTDecl> Parser::parseDecl()
                 msg += var;
                 reportSemantError(msg);
             }
-			ident = mSymbols.createIdentifier(getTokenTxt());
+			ident = mSymbols.createIdentifier(getTokenNameId());
 			
 			consumeToken();
 			
 			// Is this an array declaration?
 			if (peekAndConsume(Token::LBracket))
 			{
-				shared_ptr<ASTConstantExpr> constExpr;
+				ASTConstantExpr* constExpr = nullptr;
 				if (declType == Type::Int)
 				{
 					declType = Type::IntArray;
@@ -122,7 +119,7 @@ shared_ptr<ASTDecl> Parser::parseDecl()
 			
 			ident->setType(declType);
 			
-			shared_ptr<ASTExpr> assignExpr;
+			ASTExpr* assignExpr = nullptr;
 			
 			// Optionally, this decl may have an assignment
 			if (peekAndConsume(Token::Assign))
@@ -188,7 +185,7 @@ shared_ptr<ASTDecl> Parser::parseDecl()
 				// If this is a character array, we need to do extra checks
 				if (ident->getType() == Type::CharArray)
 				{
-					ASTStringExpr* strExpr = dynamic_cast<ASTStringExpr*>(assignExpr.get());
+					ASTStringExpr* strExpr = dynamic_cast<ASTStringExpr*>(assignExpr);
 					if (strExpr != nullptr)
 					{
 						// If we have a declared size, we need to make sure
@@ -212,7 +209,7 @@ shared_ptr<ASTDecl> Parser::parseDecl()
 			
 			matchToken(Token::SemiColon);
 			
-			retVal = make_shared<ASTDecl>(*ident, assignExpr);
+			retVal = mArena.make<ASTDecl>(*ident, assignExpr);
 		}
 		catch (ParseExcept& e)
 		{
@@ -232,15 +229,16 @@ shared_ptr<ASTDecl> Parser::parseDecl()
 			// Put in a decl here with the bogus identifier
 			// "@@error". This is so the parse will continue to the
 			// next decl, if there is one.
-			retVal = make_shared<ASTDecl>(*(ident));
+			retVal = mArena.make<ASTDecl>(*(ident));
 		}
     }
 	return retVal;
 }
 
-shared_ptr<ASTStmt> Parser::parseStmt()
+ASTStmt* Parser::parseStmt()
 {
-	shared_ptr<ASTStmt> retVal;
+	NestingGuard nesting(*this);
+	ASTStmt* retVal = nullptr;
 	try
 	{
 		// NOTE: AssignStmt HAS to go before ExprStmt!!
@@ -285,7 +283,7 @@ shared_ptr<ASTStmt> Parser::parseStmt()
 		
 		// Put in a null statement here
 		// so we can try to continue.
-		retVal = make_shared<ASTNullStmt>();
+		retVal = mArena.make<ASTNullStmt>();
 	}
 	
 	return retVal;
@@ -294,12 +292,12 @@ shared_ptr<ASTStmt> Parser::parseStmt()
 // If the compound statement is a function body, then the symbol table scope
 // change will happen at a higher level, so it shouldn't happen in
 // parseCompoundStmt.
-shared_ptr<ASTCompoundStmt> Parser::parseCompoundStmt(bool isFuncBody)
+ASTCompoundStmt* Parser::parseCompoundStmt(bool isFuncBody)
 {
-   shared_ptr<ASTCompoundStmt> retVal;
-   shared_ptr<ASTReturnStmt> voidReturn;
+   ASTCompoundStmt* retVal = nullptr;
+   ASTReturnStmt* voidReturn = nullptr;
 
-   ASTReturnStmt* x;
+   ASTReturnStmt* x = nullptr;
    if(peekToken() == Token::LBrace)
    {
         consumeToken();                 // consume brace
@@ -307,9 +305,9 @@ shared_ptr<ASTCompoundStmt> Parser::parseCompoundStmt(bool isFuncBody)
        {
            mSymbols.enterScope();
        }
-        retVal = make_shared<ASTCompoundStmt>();        // create instance of compound
-        shared_ptr<ASTDecl> decl;
-        shared_ptr<ASTStmt> stmt;
+        retVal = mArena.make<ASTCompoundStmt>();        // create instance of compound
+        ASTDecl* decl = nullptr;
+        ASTStmt* stmt = nullptr;
        
        decl = parseDecl();
         while(decl)
@@ -321,7 +319,7 @@ shared_ptr<ASTCompoundStmt> Parser::parseCompoundStmt(bool isFuncBody)
        stmt = parseStmt();  // need to get if, else if in this loop
        while(stmt)
        {
-           x = dynamic_cast<ASTReturnStmt *>(stmt.get());
+           x = dynamic_cast<ASTReturnStmt *>(stmt);
            if(x != 0) returnExist = true;
            retVal->addStmt(stmt);
            stmt = parseStmt();
@@ -334,8 +332,8 @@ shared_ptr<ASTCompoundStmt> Parser::parseCompoundStmt(bool isFuncBody)
        if(isFuncBody && mCurrReturnType == Type::Void && !returnExist)
        {
            // create a void return node
-           shared_ptr<ASTExpr> expr;
-           voidReturn = make_shared<ASTReturnStmt>(expr);
+           ASTExpr* expr = nullptr;
+           voidReturn = mArena.make<ASTReturnStmt>(expr);
            retVal->addStmt(voidReturn);
        }
        matchToken(Token::RBrace);       // reached end of compound stmt
@@ -347,14 +345,18 @@ shared_ptr<ASTCompoundStmt> Parser::parseCompoundStmt(bool isFuncBody)
     return retVal;
 }
 
-shared_ptr<ASTStmt> Parser::parseAssignStmt()
+ASTStmt* Parser::parseAssignStmt()
 {
-	shared_ptr<ASTStmt> retVal;
-	shared_ptr<ASTArraySub> arraySub;
+	ASTStmt* retVal = nullptr;
+	ASTArraySub* arraySub = nullptr;
 	
-	if (peekToken() == Token::Identifier)
+	// id ; and id ( FuncCallArgs ) are left for parseExprStmt.
+	// Since every token is already lexed, we can tell from the
+	// token after the identifier.
+	if (peekToken() == Token::Identifier &&
+		(peekToken(1) == Token::Assign || peekToken(1) == Token::LBracket))
 	{
-		Identifier* ident = getVariable(getTokenTxt());
+		Identifier* ident = getVariable(getTokenNameId());
 		
 		consumeToken();
 		
@@ -363,13 +365,13 @@ shared_ptr<ASTStmt> Parser::parseAssignStmt()
 		{
 			try
 			{
-				shared_ptr<ASTExpr> expr = parseExpr();
+				ASTExpr* expr = parseExpr();
 				if (!expr)
 				{
 					throw ParseExceptMsg("Valid expression required inside [ ].");
 				}
 				
-				arraySub = make_shared<ASTArraySub>(*ident, expr);
+				arraySub = mArena.make<ASTArraySub>(*ident, expr);
 			}
 			catch (ParseExcept& e)
 			{
@@ -393,13 +395,14 @@ shared_ptr<ASTStmt> Parser::parseAssignStmt()
 		// id [ Expr ] ;
 		// id ( FuncCallArgs ) ;
 		
-		// So... We see if the next token is a =. If it is, then this is
-		// an AssignStmt. Otherwise, we set the "unused" variables
-		// so parseFactor will later find it and be able to match
-		int col = mColNumber;
+		// Only the array gets this far, so we see if the token after
+		// the ] is a =. If it is, then this is an AssignStmt. Otherwise,
+		// we set the "unused" array so parseFactor will later find it
+		// and be able to match
+		uint32_t colOffset = getTokenOffset();
 		if (peekAndConsume(Token::Assign))
 		{
-			shared_ptr<ASTExpr> expr = parseExpr();
+			ASTExpr* expr = parseExpr();
 			
 			if (!expr)
 			{
@@ -433,10 +436,10 @@ shared_ptr<ASTStmt> Parser::parseAssignStmt()
 						err += getTypeText(expr->getType());
 						err += " to ";
 						err += getTypeText(subType);
-						reportSemantError(err, col);
+						reportSemantError(err, mSource.getColNumber(colOffset));
 					}
 				}
-				retVal = make_shared<ASTAssignArrayStmt>(arraySub, expr);
+				retVal = mArena.make<ASTAssignArrayStmt>(arraySub, expr);
 			}
 			else
 			{
@@ -490,36 +493,28 @@ shared_ptr<ASTStmt> Parser::parseAssignStmt()
                     msg += getTypeText(ident->getType());
                     reportSemantError(msg,4);
                 }
-				retVal = make_shared<ASTAssignStmt>(*ident, expr);
+				retVal = mArena.make<ASTAssignStmt>(*ident, expr);
 			}
 			
 			matchToken(Token::SemiColon);
 		}
-		else
+		else if (arraySub)
 		{
-			// We either have an unused array, or an unused ident
-			if (arraySub)
-			{
-				mUnusedArray = arraySub;
-			}
-			else
-			{
-				mUnusedIdent = ident;
-			}
+			mUnusedArray = arraySub;
 		}
 	}
 	
 	return retVal;
 }
 
-shared_ptr<ASTIfStmt> Parser::parseIfStmt()
+ASTIfStmt* Parser::parseIfStmt()
 {
-	shared_ptr<ASTIfStmt> retVal;
+	ASTIfStmt* retVal = nullptr;
     if(peekToken() == Token::Key_if || peekToken() == Token::Key_else)
     {
-        shared_ptr<ASTExpr> expr;
-        shared_ptr<ASTStmt> stmt;
-        shared_ptr<ASTStmt> stmt_else;
+        ASTExpr* expr = nullptr;
+        ASTStmt* stmt = nullptr;
+        ASTStmt* stmt_else = nullptr;
         consumeToken();                         // eat if
         if(peekToken() == Token::SemiColon) {
             throw ParseExceptMsg("Expected: ( but saw: ;");
@@ -540,30 +535,30 @@ shared_ptr<ASTIfStmt> Parser::parseIfStmt()
         stmt = parseStmt();
 
         if(!stmt) {
-            stmt = make_shared<ASTNullStmt>();
+            stmt = mArena.make<ASTNullStmt>();
         }
  
         if(peekToken() == Token::Key_else)
         {
             consumeToken();
             stmt_else = parseStmt();
-            retVal = make_shared<ASTIfStmt>(expr,stmt,stmt_else); // stmt should be next if stmt if else exists
+            retVal = mArena.make<ASTIfStmt>(expr,stmt,stmt_else); // stmt should be next if stmt if else exists
         }
         else
         {
-            retVal = make_shared<ASTIfStmt>(expr,stmt);
+            retVal = mArena.make<ASTIfStmt>(expr,stmt);
         }
     }
 	return retVal;
 }
 
-shared_ptr<ASTWhileStmt> Parser::parseWhileStmt()
+ASTWhileStmt* Parser::parseWhileStmt()
 {
-	shared_ptr<ASTWhileStmt> retVal;
+	ASTWhileStmt* retVal = nullptr;
     if(peekToken() == Token::Key_while)
     {
-        shared_ptr<ASTExpr> expr;
-        shared_ptr<ASTStmt> stmt;
+        ASTExpr* expr = nullptr;
+        ASTStmt* stmt = nullptr;
 
         consumeToken();                  // eat while
         try
@@ -578,21 +573,21 @@ shared_ptr<ASTWhileStmt> Parser::parseWhileStmt()
         }
         stmt = parseStmt();
         if(!stmt) {
-            stmt = make_shared<ASTNullStmt>();
+            stmt = mArena.make<ASTNullStmt>();
         }
-        retVal = make_shared<ASTWhileStmt>(expr,stmt);
+        retVal = mArena.make<ASTWhileStmt>(expr,stmt);
     }
 	
 	return retVal;
 }
 
-shared_ptr<ASTReturnStmt> Parser::parseReturnStmt()
+ASTReturnStmt* Parser::parseReturnStmt()
 {
-	shared_ptr<ASTReturnStmt> retVal;
-    int col = mColNumber;
+	ASTReturnStmt* retVal = nullptr;
+    uint32_t colOffset = getTokenOffset();
     if (peekToken() == (Token::Key_return))       // return statement exist
     {
-        shared_ptr<ASTExpr> expr;
+        ASTExpr* expr = nullptr;
         consumeToken();                  // eat return stmt
         
         if(mCurrReturnType != Type::Void && peekToken() == Token::SemiColon)
@@ -620,7 +615,7 @@ shared_ptr<ASTReturnStmt> Parser::parseReturnStmt()
             std::string msg = "Expected type ";
             msg += getTypeText(mCurrReturnType);
             msg += " in return statement";
-            reportSemantError(msg,col+7);
+            reportSemantError(msg,mSource.getColNumber(colOffset)+7);
         }
         if(peekToken() == Token::SemiColon) {
             consumeToken();               // eat semicolon
@@ -628,33 +623,33 @@ shared_ptr<ASTReturnStmt> Parser::parseReturnStmt()
 
         if(mCurrReturnType != Type::Void)
         {
-            retVal = make_shared<ASTReturnStmt>(expr);
+            retVal = mArena.make<ASTReturnStmt>(expr);
         }
     }
     return retVal;
 }
 
-shared_ptr<ASTExprStmt> Parser::parseExprStmt()
+ASTExprStmt* Parser::parseExprStmt()
 {
-	shared_ptr<ASTExprStmt> retVal;
-    shared_ptr<ASTExpr> expr;
+	ASTExprStmt* retVal = nullptr;
+    ASTExpr* expr = nullptr;
     expr = parseExpr();
     if(expr) {
-        retVal = make_shared<ASTExprStmt>(expr);
+        retVal = mArena.make<ASTExprStmt>(expr);
         consumeToken();               // eat semicolon
     }
 	return retVal;
 }
 
-shared_ptr<ASTNullStmt> Parser::parseNullStmt()
+ASTNullStmt* Parser::parseNullStmt()
 {
-	shared_ptr<ASTNullStmt> retVal;
-    shared_ptr<ASTExpr> expr;
+	ASTNullStmt* retVal = nullptr;
+    ASTExpr* expr = nullptr;
 
     if(peekToken() == Token::SemiColon)
     {
         consumeToken();               // eat semicolon
-        retVal = make_shared<ASTNullStmt>();
+        retVal = mArena.make<ASTNullStmt>();
 
     }
 	return retVal;
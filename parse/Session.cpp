@@ -0,0 +1,45 @@
+//
+//  Session.cpp
+//  uscc
+//
+//  Implements the Session class, which owns the LLVM state
+//  for a single compilation.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#include "Session.h"
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wconversion"
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#pragma clang diagnostic pop
+
+using namespace uscc::parse;
+
+Session::Session()
+: mContext(new llvm::LLVMContext())
+{
+
+}
+
+Session::~Session() noexcept
+{
+	// The module has to go before the context it was created in
+	mModule.reset();
+	mContext.reset();
+}
+
+// Creates the module for this compilation.
+// Any module previously created by this session is destroyed.
+llvm::Module* Session::createModule(const char* name)
+{
+	mModule.reset(new llvm::Module(name, *mContext));
+	return mModule.get();
+}
@@ -0,0 +1,72 @@
+//
+//  Session.h
+//  uscc
+//
+//  Declares the Session class, which owns the LLVM state
+//  for a single compilation.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#pragma once
+
+#include <memory>
+
+namespace llvm
+{
+	class LLVMContext;
+	class Module;
+}
+
+namespace uscc
+{
+namespace parse
+{
+
+// A session owns the LLVMContext and Module for one compilation.
+// Nothing in a session is shared with any other session, so separate
+// sessions can be used on separate threads at the same time.
+//
+// Once the session is destroyed, everything LLVM allocated for the
+// compilation (including the context's type and constant uniquing
+// tables) is freed, so long-running hosts don't grow with every job.
+class Session
+{
+public:
+	Session();
+	~Session() noexcept;
+
+	llvm::LLVMContext& getContext() noexcept
+	{
+		return *mContext;
+	}
+
+	// Creates the module for this compilation.
+	// Any module previously created by this session is destroyed.
+	llvm::Module* createModule(const char* name);
+
+	// Returns the module for this compilation (nullptr if it's not
+	// created yet)
+	llvm::Module* getModule() noexcept
+	{
+		return mModule.get();
+	}
+
+private:
+	// Disallow copy/assignment
+	Session(const Session& copy) = delete;
+	Session& operator=(const Session& rhs) = delete;
+
+	// NOTE: The module must be declared after the context,
+	// so that it's destroyed first.
+	std::unique_ptr<llvm::LLVMContext> mContext;
+	std::unique_ptr<llvm::Module> mModule;
+};
+
+} // parse
+} // uscc
@@ -0,0 +1,101 @@
+//
+//  StackThread.cpp
+//  uscc
+//
+//  Implements the StackThread class, a thread with a stack
+//  of a requested size.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#include "StackThread.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+using namespace uscc::parse;
+
+namespace
+{
+
+thread_local size_t currStackSize = 0;
+
+} // anonymous
+
+// Starts running func on a new thread with a stack of stackSize bytes
+StackThread::StackThread(std::function<void()> func, size_t stackSize)
+: mFunc(std::move(func))
+, mStackSize(stackSize)
+, mStarted(false)
+, mJoined(false)
+{
+#ifdef _WIN32
+	// Only reserve the stack, so it's committed as it's used
+	mHandle = CreateThread(nullptr, stackSize, &StackThread::run, this,
+						   STACK_SIZE_PARAM_IS_A_RESERVATION, nullptr);
+	mStarted = mHandle != nullptr;
+#else
+	pthread_attr_t attr;
+	if (pthread_attr_init(&attr) == 0)
+	{
+		mStarted = pthread_attr_setstacksize(&attr, stackSize) == 0 &&
+			pthread_create(&mHandle, &attr, &StackThread::run, this) == 0;
+		pthread_attr_destroy(&attr);
+	}
+#endif
+}
+
+// Joins the thread, if it hasn't been already
+StackThread::~StackThread()
+{
+	join();
+}
+
+// Waits for func to finish. If the thread couldn't be created,
+// func runs on the calling thread instead.
+void StackThread::join()
+{
+	if (mJoined)
+	{
+		return;
+	}
+	mJoined = true;
+
+	if (!mStarted)
+	{
+		mFunc();
+		return;
+	}
+
+#ifdef _WIN32
+	WaitForSingleObject(mHandle, INFINITE);
+	CloseHandle(mHandle);
+#else
+	pthread_join(mHandle, nullptr);
+#endif
+}
+
+// The stack size the calling thread was started with,
+// or 0 if a StackThread didn't start it
+size_t StackThread::currentStackSize() noexcept
+{
+	return currStackSize;
+}
+
+#ifdef _WIN32
+unsigned long __stdcall StackThread::run(void* data)
+#else
+void* StackThread::run(void* data)
+#endif
+{
+	StackThread* thread = static_cast<StackThread*>(data);
+	currStackSize = thread->mStackSize;
+	thread->mFunc();
+	return 0;
+}
@@ -0,0 +1,70 @@
+//
+//  StackThread.h
+//  uscc
+//
+//  Declares the StackThread class, a thread with a stack of
+//  a requested size (which std::thread can't ask for).
+//
+//  Compiles and parallel body parses recurse once per level
+//  of nesting, so they run on threads like this.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+namespace uscc
+{
+namespace parse
+{
+
+class StackThread
+{
+public:
+	// Starts running func on a new thread with a stack of stackSize bytes
+	StackThread(std::function<void()> func, size_t stackSize);
+	// Joins the thread, if it hasn't been already
+	~StackThread();
+
+	StackThread(const StackThread&) = delete;
+	StackThread& operator=(const StackThread&) = delete;
+
+	// Waits for func to finish. If the thread couldn't be created,
+	// func runs on the calling thread instead.
+	void join();
+
+	// The stack size the calling thread was started with,
+	// or 0 if a StackThread didn't start it
+	static size_t currentStackSize() noexcept;
+private:
+#ifdef _WIN32
+	static unsigned long __stdcall run(void* data);
+#else
+	static void* run(void* data);
+#endif
+
+	std::function<void()> mFunc;
+	size_t mStackSize;
+	bool mStarted;
+	bool mJoined;
+#ifdef _WIN32
+	void* mHandle;
+#else
+	pthread_t mHandle;
+#endif
+};
+
+} // parse
+} // uscc
@@ -15,6 +15,8 @@
 
 #include "Symbols.h"
 #include "Emitter.h"
+#include "../opt/MemReport.h"
+#include <algorithm>
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wconversion"
@@ -30,10 +32,10 @@
 
 using namespace uscc::parse;
 
-llvm::Type* Identifier::llvmType(bool treatArrayAsPtr /* = true */) noexcept
+llvm::Type* Identifier::llvmType(llvm::LLVMContext& context,
+								 bool treatArrayAsPtr /* = true */) noexcept
 {
 	llvm::Type* type = nullptr;
-	llvm::LLVMContext& context = llvm::getGlobalContext();
 	switch (mType)
 	{
 		case Type::Char:
@@ -87,66 +89,126 @@ void Identifier::writeTo(CodeContext& ctx, llvm::Value* value) noexcept
     return ctx.mSSA.writeVariable(this, ctx.mBlock, value);
 }
 
-SymbolTable::SymbolTable() noexcept
+SymbolTable::SymbolTable(scan::NamePool& names) noexcept
+: mNames(names)
+, mOwnsScopes(true)
+, mFile(nullptr)
 {
     mCurrScope = nullptr;
     enterScope();               // enter global scope
-    Identifier* func = createIdentifier("@@function");
-    func->setType(Type::Function);
-    Identifier* var = createIdentifier("@@variable");
-    var->setType(Type::Int);
-    Identifier* printf = createIdentifier("printf");
-    printf->setType(Type::Function);
+    addBuiltins();
+}
+
+SymbolTable::SymbolTable(SymbolTable& file, ScopeTable* scope) noexcept
+: mCurrScope(scope)
+, mNames(file.mNames)
+, mOwnsScopes(false)
+, mFile(&file)
+, mDummyVariable(file.mDummyVariable)
+, mDummyFunction(file.mDummyFunction)
+{
+    // We're as deep as scope is, but only its own identifiers
+    // need binding here
+    for(ScopeTable* s = scope; s != nullptr; s = s->getParent())
+    {
+        mScopeStarts.push_back(0);
+    }
+    for(auto& val : scope->mSymbols)
+    {
+        bind(val.second);
+    }
 }
 
 SymbolTable::~SymbolTable() noexcept
 {
-    delete mCurrScope;    
+    if(mOwnsScopes)
+    {
+        delete mCurrScope;
+    }
+}
+
+// Deletes every scope and identifier, leaving just the
+// global scope with the builtins in it
+void SymbolTable::reset() noexcept
+{
+    while(mCurrScope->getParent())      // back out to the global scope
+    {
+        mCurrScope = mCurrScope->getParent();
+    }
+    delete mCurrScope;
+    mCurrScope = nullptr;
+    mBindings.clear();
+    mBound.clear();
+    mScopeStarts.clear();
+    enterScope();
+    addBuiltins();
+}
+
+// Adds @@variable, @@function and printf to the current scope
+void SymbolTable::addBuiltins() noexcept
+{
+    Identifier* func = createIdentifier(mNames.intern("@@function"));
+    func->setType(Type::Function);
+    func->mIsDummy = true;
+    mDummyFunction = func;
+    Identifier* var = createIdentifier(mNames.intern("@@variable"));
+    var->setType(Type::Int);
+    var->mIsDummy = true;
+    mDummyVariable = var;
+    Identifier* printf = createIdentifier(mNames.intern("printf"));
+    printf->setType(Type::Function);
 }
 
 // Returns true if this variable is already declared
 // in this scope (ignoring parent scopes).
 // Used to prevent redeclaration in the same scope,
 // which is disallowed.
-bool SymbolTable::isDeclaredInScope(const char* name) const noexcept
+bool SymbolTable::isDeclaredInScope(uint32_t nameId) const noexcept
 {
-    Identifier* object = mCurrScope->searchInScope(name);
+    // Anything bound at this depth is from this scope, since
+    // earlier scopes at the same depth were already exited
+    Identifier* object = findBinding(nameId);
     if(object == nullptr) return false;
-    else return true;
+    else return object->mScopeDepth == mScopeStarts.size();
 }
 
 // Creates the requested identifier, and returns a pointer
 // to it.
 // NOTE: If the identifier already exists, nothing will happen.
 // This means you should first check with isDeclaredInScope.
-Identifier* SymbolTable::createIdentifier(const char* name)
+Identifier* SymbolTable::createIdentifier(uint32_t nameId)
 {
-    Identifier* ident = new Identifier(name);
-    if(!isDeclaredInScope(name))
+    if(!isDeclaredInScope(nameId))
     {
+        Identifier* ident = new Identifier(mNames.getName(nameId), nameId);
+        uscc::opt::MemReport::count(uscc::opt::MemReport::Identifiers);
         mCurrScope->addIdentifier(ident);   // add to current scope table
+        bind(ident);
         return ident;
     }
 	else
     {
-        return getIdentifier(name);
+        return getIdentifier(nameId);
     }
 }
 
 // Returns a pointer to the identifier, if it's found
 // Otherwise returns nullptr
+Identifier* SymbolTable::getIdentifier(uint32_t nameId)
+{
+    return findBinding(nameId);
+}
+
+// Looks up an identifier by name, for the names the compiler
+// itself uses (like printf)
 Identifier* SymbolTable::getIdentifier(const char* name)
 {
-    
-    Identifier* result = mCurrScope->search(name);
-    if(result == nullptr)               // identifier not found
+    uint32_t nameId = mNames.find(name);
+    if(nameId == scan::NamePool::NoName)    // never seen, so can't be declared
     {
         return nullptr;
     }
-    else
-    {
-        return result;
-    }
+    return getIdentifier(nameId);
 }
 
 // Enters a new scope, and returns a pointer to this scope table
@@ -154,6 +216,7 @@ SymbolTable::ScopeTable* SymbolTable::enterScope()
 {
     ScopeTable* ptr = new ScopeTable(mCurrScope);   // param is parent
     mCurrScope = ptr;           // move current scope to the new table
+    mScopeStarts.push_back(mBound.size());
     
     return ptr;
 }
@@ -162,12 +225,68 @@ SymbolTable::ScopeTable* SymbolTable::enterScope()
 // the previous scope table.
 void SymbolTable::exitScope()
 {
+    // Unbind everything this scope declared, uncovering what it shadowed
+    size_t start = mScopeStarts.back();
+    mScopeStarts.pop_back();
+    while(mBound.size() > start)
+    {
+        Identifier* ident = mBound.back();
+        mBound.pop_back();
+        bindingSlot(ident->getNameId()) = ident->mShadowed;
+    }
+    
     mCurrScope = mCurrScope->getParent();   // move scope to parent
 }
 
+// Makes ident the innermost binding of its name
+void SymbolTable::bind(Identifier* ident)
+{
+    Identifier*& slot = bindingSlot(ident->getNameId());
+    ident->mShadowed = slot;
+    ident->mScopeDepth = static_cast<unsigned int>(mScopeStarts.size());
+    slot = ident;
+    mBound.push_back(ident);
+}
+
+// Returns the innermost binding of nameId, or nullptr if there isn't one
+Identifier* SymbolTable::findBinding(uint32_t nameId) const noexcept
+{
+    if(mFile)
+    {
+        auto it = mViewBindings.find(nameId);
+        if(it != mViewBindings.end() && it->second != nullptr)
+        {
+            return it->second;
+        }
+        return mFile->findBinding(nameId);      // not declared in our scopes
+    }
+    
+    if(nameId < mBindings.size())
+    {
+        return mBindings[nameId];
+    }
+    return nullptr;
+}
+
+// Returns the slot for the innermost binding of nameId
+Identifier*& SymbolTable::bindingSlot(uint32_t nameId)
+{
+    if(mFile)
+    {
+        return mViewBindings[nameId];
+    }
+    
+    if(nameId >= mBindings.size())
+    {
+        mBindings.resize(std::max(static_cast<size_t>(nameId) + 1, mNames.size()));
+    }
+    return mBindings[nameId];
+}
+
 SymbolTable::ScopeTable::ScopeTable(ScopeTable* parent) noexcept
 : mParent(parent)
 {
+    uscc::opt::MemReport::count(uscc::opt::MemReport::ScopeTables);
     mParent = parent;
     if(parent)
     {
@@ -190,59 +309,7 @@ SymbolTable::ScopeTable::~ScopeTable() noexcept
 // Adds the requested identifier to the table
 void SymbolTable::ScopeTable::addIdentifier(Identifier* ident)
 {
-    mSymbols[ident->getName()] = ident;
-}
-
-// Searches this scope for an identifier with
-// the requested name. Returns nullptr if not found.
-Identifier* SymbolTable::ScopeTable::searchInScope(const char* name) noexcept
-{
-    std::unordered_map<std::string, Identifier*>::const_iterator it = mSymbols.find (name);
-    if(it == mSymbols.end())    // identifier not found
-    {
-        return nullptr;
-    }
-    else
-    {
-        return it->second;              // return identifier for this name
-    }
-}
-
-// Searches this scope first, and if not found searches
-// through parent scopes. Returns nullptr if not found.
-Identifier* SymbolTable::ScopeTable::search(const char* name) noexcept
-{
-
-    Identifier* result;
-    Identifier* parent_result;
-    result = searchInScope(name);
-    ScopeTable* dummy_parent;
-    dummy_parent = mParent;         // currents scope's parent
-    
-    if(searchInScope(name) == nullptr)   // search parent scopes
-    {
-        while(true)
-        {
-            parent_result = dummy_parent->searchInScope(name);
-            if(parent_result != nullptr)        // found in parent scope
-            {
-                return parent_result;
-            }
-            else            // search other parent
-            {
-                if(dummy_parent->getParent() != nullptr)    // other parent exists
-                {
-                    dummy_parent = dummy_parent->getParent();
-                }
-                else break;
-            }
-        }
-    }
-    else            // found in currrent scope
-    {
-        return result;
-    }
-    return nullptr;             // not found
+    mSymbols[ident->getNameId()] = ident;
 }
 
 void SymbolTable::ScopeTable::emitIR(CodeContext& ctx)
@@ -262,7 +329,7 @@ void SymbolTable::ScopeTable::emitIR(CodeContext& ctx)
 		// in which case we don't allocate it
 		if (ident->isArray() && ident->getArrayCount() != -1)
 		{
-			llvm::Type* type = ident->llvmType(false);
+			llvm::Type* type = ident->llvmType(ctx.mGlobal, false);
 			// Note we pass in "nullptr" for the array size because that's
 			// handled by the type
 			decl = build.CreateAlloca(type, nullptr, name);
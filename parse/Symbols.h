@@ -5,6 +5,15 @@
 //  Defines the symbol and string tables used for
 //  semantic analysis.
 //
+//  Symbols are looked up by the ID of their name in the
+//  file's NamePool, rather than by the name itself.
+//
+//  Lookups don't search the scopes. The table keeps the
+//  innermost binding of every name, and each identifier
+//  points at the one it shadows, so a scope exit just puts
+//  back whatever its identifiers shadowed. The ScopeTable
+//  tree is still built, for the allocas emitted per function.
+//
 //---------------------------------------------------------
 //  Copyright (c) 2014, Sanjay Madhav
 //  All rights reserved.
@@ -18,13 +27,16 @@
 #include <memory>
 #include <unordered_map>
 #include <list>
+#include <vector>
 
 #include "Types.h"
+#include "../scan/NamePool.h"
 
 namespace llvm
 {
 	class Value;
 	class Type;
+	class LLVMContext;
 }
 
 namespace uscc
@@ -44,6 +56,11 @@ public:
 	{
 		return mName;
 	}
+	// ID of the name in the NamePool
+	uint32_t getNameId() const noexcept
+	{
+		return mNameId;
+	}
 	void setType(Type type) noexcept
 	{
 		mType = type;
@@ -75,19 +92,19 @@ public:
 		return mType == Type::Function;
 	}
 	
-	std::shared_ptr<ASTFunction> getFunction() const noexcept
+	ASTFunction* getFunction() const noexcept
 	{
 		return mFunctionNode;
 	}
 	
-	void setFunction(std::shared_ptr<ASTFunction> func) noexcept
+	void setFunction(ASTFunction* func) noexcept
 	{
 		mFunctionNode = func;
 	}
 	
 	bool isDummy() const noexcept
 	{
-		return mName == "@@variable" || mName == "@@function";
+		return mIsDummy;
 	}
 	
 	llvm::Value* getAddress() noexcept
@@ -100,7 +117,7 @@ public:
 		mAddress = value;
 	}
 	
-	llvm::Type* llvmType(bool treatArrayAsPtr = true) noexcept;
+	llvm::Type* llvmType(llvm::LLVMContext& context, bool treatArrayAsPtr = true) noexcept;
 	
 	llvm::Value* readFrom(CodeContext& ctx) noexcept;
 	
@@ -108,19 +125,31 @@ public:
 	
 private:
 	// Private constructor so only the symbol table can create
-	Identifier(const char* name)
+	Identifier(const std::string& name, uint32_t nameId)
 	: mName(name)
+	, mNameId(nameId)
 	, mFunctionNode(nullptr)
 	, mAddress(nullptr)
 	, mType(Type::Void)
 	, mArrayCount(-1)
+	, mIsDummy(false)
+	, mShadowed(nullptr)
+	, mScopeDepth(0)
 	{ }
 	
-	std::string mName;
-	std::shared_ptr<ASTFunction> mFunctionNode;
+	// Owned by the NamePool
+	const std::string& mName;
+	uint32_t mNameId;
+	ASTFunction* mFunctionNode;
 	llvm::Value* mAddress;
 	Type mType;
 	size_t mArrayCount;
+	// True for @@variable and @@function
+	bool mIsDummy;
+	// The binding of the same name this one hides, while it's in scope
+	Identifier* mShadowed;
+	// How many scopes deep it was declared (the global scope is 1)
+	unsigned int mScopeDepth;
 };
 
 // NOTE: I don't use shared_ptrs for the symbol table
@@ -131,25 +160,54 @@ class SymbolTable
 public:
 	class ScopeTable;
 	
-	SymbolTable() noexcept;
+	// Names are interned into names, which has to outlive the table
+	SymbolTable(scan::NamePool& names) noexcept;
+	// Makes a view of file's table that starts in scope. Scopes it
+	// enters are added under scope, but file still owns them all.
+	// (Used to parse a function body on a thread of its own.)
+	SymbolTable(SymbolTable& file, ScopeTable* scope) noexcept;
 	~SymbolTable() noexcept;
 	
+	// Deletes every scope and identifier, leaving just the
+	// global scope with the builtins in it
+	void reset() noexcept;
+	
 	// Returns true if this variable is already declared
 	// in this scope (ignoring parent scopes).
 	// Used to prevent redeclaration in the same scope,
 	// which is disallowed.
-	bool isDeclaredInScope(const char* name) const noexcept;
+	bool isDeclaredInScope(uint32_t nameId) const noexcept;
 	
 	// Creates the requested identifier, and returns a pointer
 	// to it.
 	// NOTE: If the identifier already exists, nothing will happen.
 	// This means you should first check with isDeclaredInScope.
-	Identifier* createIdentifier(const char* name);
+	Identifier* createIdentifier(uint32_t nameId);
 	
 	// Returns a pointer to the identifier, if it's found
 	// Otherwise returns nullptr
+	Identifier* getIdentifier(uint32_t nameId);
+	
+	// Looks up an identifier by name, for the names the compiler
+	// itself uses (like printf)
 	Identifier* getIdentifier(const char* name);
 	
+	// The placeholders used after a semantic error
+	Identifier* getDummyVariable() noexcept
+	{
+		return mDummyVariable;
+	}
+	Identifier* getDummyFunction() noexcept
+	{
+		return mDummyFunction;
+	}
+	
+	// Returns the name with the requested ID
+	const std::string& getName(uint32_t nameId) const noexcept
+	{
+		return mNames.getName(nameId);
+	}
+	
 	// Enters a new scope, and returns a pointer to this scope table
 	ScopeTable* enterScope();
 	
@@ -160,6 +218,7 @@ public:
 	// Symbol table for a specific scope
 	class ScopeTable
 	{
+		friend class SymbolTable;
 	public:
 		ScopeTable(ScopeTable* parent) noexcept;
 		~ScopeTable() noexcept;
@@ -167,14 +226,6 @@ public:
 		// Adds the requested identifier to the table
 		void addIdentifier(Identifier* ident);
 		
-		// Searches this scope for an identifier with
-		// the requested name. Returns nullptr if not found.
-		Identifier* searchInScope(const char* name) noexcept;
-		
-		// Searches this scope first, and if not found searches
-		// through parent scopes. Returns nullptr if not found.
-		Identifier* search(const char* name) noexcept;
-		
 		// Emits declarations for ALL non-function symbols
 		// in this scope. Used to front-load all stack-based variables
 		// to the start of the function
@@ -186,8 +237,9 @@ public:
 			return mParent;
 		}
 	private:
-		// Hash table contains all the identifiers in this scope
-		std::unordered_map<std::string, Identifier*> mSymbols;
+		// Hash table contains all the identifiers in this scope,
+		// keyed by the ID of their name
+		std::unordered_map<uint32_t, Identifier*> mSymbols;
 		
 		// List of the child tables
 		std::list<ScopeTable*> mChildren;
@@ -198,6 +250,40 @@ public:
 	
 	// Pointer to the current scope table
 	ScopeTable* mCurrScope;
+	
+private:
+	// Adds @@variable, @@function and printf to the current scope
+	void addBuiltins() noexcept;
+	
+	// Makes ident the innermost binding of its name
+	void bind(Identifier* ident);
+	
+	// Returns the innermost binding of nameId, or nullptr if there isn't one
+	Identifier* findBinding(uint32_t nameId) const noexcept;
+	
+	// Returns the slot for the innermost binding of nameId
+	Identifier*& bindingSlot(uint32_t nameId);
+	
+	scan::NamePool& mNames;
+	// False for a view of another table
+	bool mOwnsScopes;
+	// For a view, the table it's a view of
+	SymbolTable* mFile;
+	
+	// The innermost binding of each name, indexed by name ID
+	std::vector<Identifier*> mBindings;
+	// A view only binds the names declared in its own scopes,
+	// and finds everything else in mFile
+	std::unordered_map<uint32_t, Identifier*> mViewBindings;
+	
+	// Every identifier still in scope, in the order they were bound
+	std::vector<Identifier*> mBound;
+	// Where each scope we're in started in mBound
+	std::vector<size_t> mScopeStarts;
+	
+	// @@variable and @@function
+	Identifier* mDummyVariable;
+	Identifier* mDummyFunction;
 };
 	
 // Used to store/reference constant strings
@@ -0,0 +1,305 @@
+//
+//  FastScanner.cpp
+//  uscc
+//
+//  Implements scanChunk with a hand-written scanner.
+//
+//  It gives exactly the same tokens as the rules in usc.l,
+//  including their quirks: "-5" is a single Constant, a
+//  comment only counts as one if there's a newline after
+//  it, and a string or character constant that doesn't
+//  match is an Unknown token for just its opening quote.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#include "Scanner.h"
+#include "Keywords.h"
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace uscc::scan;
+
+namespace
+{
+
+inline bool isIdentStart(char c) noexcept
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+inline bool isIdentChar(char c) noexcept
+{
+	return isIdentStart(c) || (c >= '0' && c <= '9');
+}
+
+inline bool isDigit(char c) noexcept
+{
+	return c >= '0' && c <= '9';
+}
+
+// Returns the first character at or after p that isn't whitespace
+// or part of a comment (or end, if there isn't one)
+const char* skipBlanks(const char* p, const char* end) noexcept
+{
+	while (true)
+	{
+#ifdef __SSE2__
+		// Indentation is the most common whitespace, so check
+		// 16 characters at a time for spaces, tabs and newlines
+		const __m128i space = _mm_set1_epi8(' ');
+		const __m128i tab = _mm_set1_epi8('\t');
+		const __m128i newline = _mm_set1_epi8('\n');
+		while (end - p >= 16)
+		{
+			__m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+			__m128i blanks = _mm_or_si128(_mm_cmpeq_epi8(chars, space),
+										  _mm_or_si128(_mm_cmpeq_epi8(chars, tab),
+													   _mm_cmpeq_epi8(chars, newline)));
+			unsigned bits = static_cast<unsigned>(_mm_movemask_epi8(blanks));
+			if (bits != 0xFFFF)
+			{
+				p += __builtin_ctz(~bits);
+				break;
+			}
+			p += 16;
+		}
+#endif
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\n'))
+		{
+			p++;
+		}
+
+		if (end - p >= 2 && p[0] == '\r' && p[1] == '\n')
+		{
+			p += 2;
+		}
+		else if (end - p >= 2 && p[0] == '/' && p[1] == '/')
+		{
+			// Without a newline after it, it's just two Divs
+			const void* nl = memchr(p + 2, '\n', static_cast<size_t>(end - p - 2));
+			if (nl == nullptr)
+			{
+				return p;
+			}
+			p = static_cast<const char*>(nl) + 1;
+		}
+		else
+		{
+			return p;
+		}
+	}
+}
+
+// Returns the length of the string literal at p (which is a "),
+// or 0 if it isn't a valid one
+size_t matchString(const char* p, const char* end) noexcept
+{
+	const char* curr = p + 1;
+	while (curr < end)
+	{
+		if (*curr == '"')
+		{
+			return static_cast<size_t>(curr + 1 - p);
+		}
+		else if (*curr == '\\')
+		{
+			// \n and \t are the only escapes
+			if (end - curr < 2 || (curr[1] != 'n' && curr[1] != 't'))
+			{
+				return 0;
+			}
+			curr += 2;
+		}
+		else
+		{
+			curr++;
+		}
+	}
+	return 0;
+}
+
+// Returns the length of the character constant at p (which is a '),
+// or 0 if it isn't a valid one
+size_t matchChar(const char* p, const char* end) noexcept
+{
+	if (end - p >= 4 && p[1] == '\\' && (p[2] == 'n' || p[2] == 't') && p[3] == '\'')
+	{
+		return 4;
+	}
+	if (end - p >= 3 && p[1] != '\n' && p[2] == '\'')
+	{
+		return 3;
+	}
+	return 0;
+}
+
+} // anonymous
+
+// Adds the tokens in text to the end of tokens (not including
+// EndOfFile), and interns identifiers into names.
+void uscc::scan::scanChunk(llvm::StringRef text, uint32_t base, TokenBuffer& tokens,
+						   NamePool& names)
+{
+	const char* begin = text.data();
+	const char* end = begin + text.size();
+
+	tokens.reserveForText(text.size());
+
+	const char* p = skipBlanks(begin, end);
+	while (p < end)
+	{
+		uint32_t offset = base + static_cast<uint32_t>(p - begin);
+		Token::Tokens token = Token::Unknown;
+		size_t length = 1;
+		bool hasNext = end - p >= 2;
+		char next = hasNext ? p[1] : '\0';
+
+		switch (*p)
+		{
+			case '=':
+				if (next == '=')
+				{
+					token = Token::EqualTo;
+					length = 2;
+				}
+				else
+				{
+					token = Token::Assign;
+				}
+				break;
+			case '+':
+				if (next == '+')
+				{
+					token = Token::Inc;
+					length = 2;
+				}
+				else
+				{
+					token = Token::Plus;
+				}
+				break;
+			case '-':
+				if (next == '-')
+				{
+					token = Token::Dec;
+					length = 2;
+				}
+				else if (hasNext && isDigit(next))
+				{
+					// A leading 0 ends the number, so -0123 is -0 then 123
+					token = Token::Constant;
+					length = 2;
+					if (next != '0')
+					{
+						while (p + length < end && isDigit(p[length]))
+						{
+							length++;
+						}
+					}
+				}
+				else
+				{
+					token = Token::Minus;
+				}
+				break;
+			case '*': token = Token::Mult; break;
+			case '/': token = Token::Div; break;
+			case '%': token = Token::Mod; break;
+			case '[': token = Token::LBracket; break;
+			case ']': token = Token::RBracket; break;
+			case '!':
+				if (next == '=')
+				{
+					token = Token::NotEqual;
+					length = 2;
+				}
+				else
+				{
+					token = Token::Not;
+				}
+				break;
+			case '|':
+				if (next == '|')
+				{
+					token = Token::Or;
+					length = 2;
+				}
+				break;
+			case '&':
+				if (next == '&')
+				{
+					token = Token::And;
+					length = 2;
+				}
+				else
+				{
+					token = Token::Addr;
+				}
+				break;
+			case '<': token = Token::LessThan; break;
+			case '>': token = Token::GreaterThan; break;
+			case '(': token = Token::LParen; break;
+			case ')': token = Token::RParen; break;
+			case ';': token = Token::SemiColon; break;
+			case '{': token = Token::LBrace; break;
+			case '}': token = Token::RBrace; break;
+			case ',': token = Token::Comma; break;
+			case '0':
+				token = Token::Constant;
+				break;
+			case '1': case '2': case '3': case '4': case '5':
+			case '6': case '7': case '8': case '9':
+				token = Token::Constant;
+				while (p + length < end && isDigit(p[length]))
+				{
+					length++;
+				}
+				break;
+			case '\'':
+				if (size_t charLength = matchChar(p, end))
+				{
+					token = Token::Constant;
+					length = charLength;
+				}
+				break;
+			case '"':
+				if (size_t stringLength = matchString(p, end))
+				{
+					token = Token::String;
+					length = stringLength;
+				}
+				break;
+			default:
+				if (isIdentStart(*p))
+				{
+					while (p + length < end && isIdentChar(p[length]))
+					{
+						length++;
+					}
+					token = classifyWord(p, length);
+				}
+				break;
+		}
+
+		if (token == Token::Identifier)
+		{
+			tokens.add(token, offset, static_cast<uint32_t>(length),
+					   names.intern(llvm::StringRef(p, length)));
+		}
+		else
+		{
+			tokens.add(token, offset, static_cast<uint32_t>(length));
+		}
+
+		p = skipBlanks(p + length, end);
+	}
+}
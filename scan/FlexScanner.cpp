@@ -0,0 +1,78 @@
+//
+//  FlexScanner.cpp
+//  uscc
+//
+//  Implements scanChunk with the scanner flex generates
+//  from usc.l.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#include "Scanner.h"
+#include <FlexLexer.h>
+#include <istream>
+#include <streambuf>
+
+using namespace uscc::scan;
+
+namespace
+{
+
+// Minimal read-only streambuf over the text, so the scanner
+// reads straight out of it
+class ViewBuf : public std::streambuf
+{
+public:
+	ViewBuf(llvm::StringRef text)
+	{
+		char* begin = const_cast<char*>(text.data());
+		setg(begin, begin, begin + text.size());
+	}
+};
+
+} // anonymous
+
+// Adds the tokens in text to the end of tokens (not including
+// EndOfFile), and interns identifiers into names.
+void uscc::scan::scanChunk(llvm::StringRef text, uint32_t base, TokenBuffer& tokens,
+						   NamePool& names)
+{
+	ViewBuf buf(text);
+	std::istream stream(&buf);
+	yyFlexLexer lexer(&stream);
+
+	tokens.reserveForText(text.size());
+
+	uint32_t offset = base;
+	Token::Tokens token = static_cast<Token::Tokens>(lexer.yylex());
+	while (token != Token::EndOfFile)
+	{
+		uint32_t length = static_cast<uint32_t>(lexer.YYLeng());
+
+		// Only the offset is tracked, so whitespace and comments
+		// can just be skipped
+		switch (token)
+		{
+			case Token::Newline:
+			case Token::Comment:
+			case Token::Space:
+			case Token::Tab:
+				break;
+			case Token::Identifier:
+				tokens.add(token, offset, length,
+						   names.intern(text.substr(offset - base, length)));
+				break;
+			default:
+				tokens.add(token, offset, length);
+				break;
+		}
+
+		offset += length;
+		token = static_cast<Token::Tokens>(lexer.yylex());
+	}
+}
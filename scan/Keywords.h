@@ -0,0 +1,154 @@
+//
+//  Keywords.h
+//  uscc
+//
+//  Declares the table used to tell keywords apart from
+//  identifiers.
+//
+//  The table is a perfect hash built at compile time from
+//  the KEYWORD entries in Tokens.def, so classifying an
+//  identifier-shaped lexeme takes one probe: hash it, then
+//  compare against the only keyword it could be.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#pragma once
+
+#include "Tokens.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace uscc
+{
+namespace scan
+{
+
+struct Keyword
+{
+	const char* mText;
+	size_t mLength;
+	Token::Tokens mToken;
+};
+
+// Every keyword, followed by an empty entry that
+// the unused slots of the table point to
+constexpr Keyword keywordList[] =
+{
+	#define TOKEN(a,b,c)
+	#define KEYWORD(a,b,c) { b, c, Token::a },
+	#include "Tokens.def"
+	#undef TOKEN
+	{ "", 0, Token::Identifier }
+};
+
+constexpr size_t numKeywords = sizeof(keywordList) / sizeof(Keyword) - 1;
+
+// Must be a power of two
+constexpr size_t keywordTableSize = 16;
+
+// Only the first and last characters and the length are hashed, which
+// is enough to keep the current keywords apart. static_asserts below
+// catch a new keyword that collides.
+constexpr size_t keywordHash(const char* text, size_t length)
+{
+	return (static_cast<unsigned char>(text[0]) +
+			(static_cast<size_t>(static_cast<unsigned char>(text[length - 1])) << 3) +
+			length) & (keywordTableSize - 1);
+}
+
+// (These are all recursive, since they have to be C++11 constexpr functions)
+
+// Returns the index of the keyword in this slot of the table,
+// or numKeywords if there isn't one
+constexpr size_t keywordInSlot(size_t slot, size_t i = 0)
+{
+	return i == numKeywords ? numKeywords :
+		keywordHash(keywordList[i].mText, keywordList[i].mLength) == slot ? i :
+		keywordInSlot(slot, i + 1);
+}
+
+// Returns true if keyword i hashes to the same slot as any keyword after j
+constexpr bool keywordCollides(size_t i, size_t j)
+{
+	return j == numKeywords ? false :
+		keywordHash(keywordList[i].mText, keywordList[i].mLength) ==
+			keywordHash(keywordList[j].mText, keywordList[j].mLength) ||
+		keywordCollides(i, j + 1);
+}
+
+constexpr bool keywordHashIsPerfect(size_t i = 0)
+{
+	return i == numKeywords ? true :
+		!keywordCollides(i, i + 1) && keywordHashIsPerfect(i + 1);
+}
+
+constexpr size_t textLength(const char* text)
+{
+	return *text == '\0' ? 0 : 1 + textLength(text + 1);
+}
+
+constexpr bool keywordLengthsMatch(size_t i = 0)
+{
+	return i == numKeywords ? true :
+		textLength(keywordList[i].mText) == keywordList[i].mLength &&
+		keywordLengthsMatch(i + 1);
+}
+
+constexpr size_t minKeywordLength(size_t i = 0)
+{
+	return i == numKeywords ? SIZE_MAX :
+		keywordList[i].mLength < minKeywordLength(i + 1) ?
+			keywordList[i].mLength : minKeywordLength(i + 1);
+}
+
+constexpr size_t maxKeywordLength(size_t i = 0)
+{
+	return i == numKeywords ? 0 :
+		keywordList[i].mLength > maxKeywordLength(i + 1) ?
+			keywordList[i].mLength : maxKeywordLength(i + 1);
+}
+
+constexpr size_t minKeywordLen = minKeywordLength();
+constexpr size_t maxKeywordLen = maxKeywordLength();
+
+static_assert(numKeywords <= keywordTableSize, "Too many keywords for the keyword table");
+static_assert(keywordLengthsMatch(), "A keyword's length in Tokens.def is wrong");
+static_assert(keywordHashIsPerfect(),
+			  "Two keywords share a slot in the keyword table, so keywordHash needs changing");
+
+// Index in keywordList of the keyword in each slot
+static_assert(keywordTableSize == 16, "keywordTable has to list every slot");
+constexpr unsigned char keywordTable[keywordTableSize] =
+{
+	keywordInSlot(0), keywordInSlot(1), keywordInSlot(2), keywordInSlot(3),
+	keywordInSlot(4), keywordInSlot(5), keywordInSlot(6), keywordInSlot(7),
+	keywordInSlot(8), keywordInSlot(9), keywordInSlot(10), keywordInSlot(11),
+	keywordInSlot(12), keywordInSlot(13), keywordInSlot(14), keywordInSlot(15),
+};
+
+// Returns the keyword token for an identifier-shaped lexeme,
+// or Identifier if it isn't a keyword
+inline Token::Tokens classifyWord(const char* text, size_t length) noexcept
+{
+	if (length < minKeywordLen || length > maxKeywordLen)
+	{
+		return Token::Identifier;
+	}
+
+	const Keyword& keyword = keywordList[keywordTable[keywordHash(text, length)]];
+	if (keyword.mLength == length && memcmp(keyword.mText, text, length) == 0)
+	{
+		return keyword.mToken;
+	}
+	return Token::Identifier;
+}
+
+} // scan
+} // uscc
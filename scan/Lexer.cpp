@@ -0,0 +1,148 @@
+//
+//  Lexer.cpp
+//  uscc
+//
+//  Implements lexing a whole source file (in parallel,
+//  for large files).
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#include "Lexer.h"
+#include "Scanner.h"
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace uscc::scan;
+
+namespace
+{
+
+// Smallest chunk that's worth lexing on a thread of its own
+const size_t minChunkSize = 256 * 1024;
+
+// Returns true if a string literal was cut off at the end of this
+// chunk. Lexed on its own, the opening " of that string has no match,
+// so it comes out as an Unknown token.
+bool hasCutString(llvm::StringRef source, const TokenBuffer& tokens) noexcept
+{
+	for (size_t i = 0; i < tokens.size(); i++)
+	{
+		if (tokens.getKind(i) == Token::Unknown && source[tokens.getOffset(i)] == '"')
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+} // anonymous
+
+// Lexes text into tokens (replacing anything already in it).
+void uscc::scan::lexSource(llvm::StringRef text, TokenBuffer& tokens, NamePool& names,
+						   unsigned numThreads, const LexWorkerHook& workerHook)
+{
+	if (numThreads == 0)
+	{
+		numThreads = std::thread::hardware_concurrency();
+	}
+	size_t numChunks = std::min(static_cast<size_t>(numThreads), text.size() / minChunkSize);
+
+	// Each chunk after the first starts right after a newline
+	std::vector<size_t> starts;
+	starts.push_back(0);
+	for (size_t i = 1; i < numChunks; i++)
+	{
+		size_t newline = text.find('\n', i * text.size() / numChunks);
+		if (newline == llvm::StringRef::npos)
+		{
+			break;
+		}
+		if (newline + 1 > starts.back() && newline + 1 < text.size())
+		{
+			starts.push_back(newline + 1);
+		}
+	}
+	starts.push_back(text.size());
+	numChunks = starts.size() - 1;
+
+	tokens.clear();
+	if (numChunks <= 1)
+	{
+		scanChunk(text, 0, tokens, names);
+		tokens.add(Token::EndOfFile, static_cast<uint32_t>(text.size()), 0);
+		return;
+	}
+
+	// Each chunk interns into a pool of its own, so
+	// the threads don't have to share one
+	std::vector<TokenBuffer> chunks(numChunks);
+	std::vector<std::unique_ptr<NamePool>> chunkNames;
+	for (size_t i = 0; i < numChunks; i++)
+	{
+		chunkNames.emplace_back(new NamePool);
+	}
+	std::vector<std::thread> workers;
+	for (size_t i = 1; i < numChunks; i++)
+	{
+		workers.emplace_back([&text, &starts, &chunks, &chunkNames, &workerHook, i]()
+		{
+			std::function<void()> work = [&text, &starts, &chunks, &chunkNames, i]()
+			{
+				scanChunk(text.slice(starts[i], starts[i + 1]),
+						 static_cast<uint32_t>(starts[i]), chunks[i], *chunkNames[i]);
+			};
+			if (workerHook)
+			{
+				workerHook(work);
+			}
+			else
+			{
+				work();
+			}
+		});
+	}
+	// This thread takes the first chunk
+	scanChunk(text.slice(starts[0], starts[1]), 0, chunks[0], *chunkNames[0]);
+	for (auto& t : workers)
+	{
+		t.join();
+	}
+
+	size_t total = 1;
+	for (auto& chunk : chunks)
+	{
+		total += chunk.size();
+	}
+	tokens.reserve(total);
+
+	for (size_t i = 0; i < numChunks; i++)
+	{
+		// A string literal can have a newline in it. If one starts in
+		// this chunk and runs into the next, the chunks after this
+		// didn't start at a token, so the rest is lexed again in one go.
+		if (i + 1 < numChunks && hasCutString(text, chunks[i]))
+		{
+			scanChunk(text.substr(starts[i]), static_cast<uint32_t>(starts[i]), tokens, names);
+			break;
+		}
+
+		// Move this chunk's names into the file's pool. Going in
+		// chunk order hands out the same IDs as a single thread would.
+		std::vector<uint32_t> nameMap;
+		nameMap.reserve(chunkNames[i]->size());
+		for (uint32_t id = 0; id < chunkNames[i]->size(); id++)
+		{
+			nameMap.push_back(names.intern(chunkNames[i]->getName(id)));
+		}
+		tokens.append(chunks[i], nameMap);
+	}
+	tokens.add(Token::EndOfFile, static_cast<uint32_t>(text.size()), 0);
+}
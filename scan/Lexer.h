@@ -0,0 +1,56 @@
+//
+//  Lexer.h
+//  uscc
+//
+//  Declares the function that lexes a whole source file
+//  into a TokenBuffer.
+//
+//  USC tokens (other than string literals, which can have
+//  raw newlines in them) never span a newline. So a large
+//  file is split into chunks at line boundaries, and the
+//  chunks are lexed on separate threads.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#pragma once
+
+#include "TokenBuffer.h"
+#include "NamePool.h"
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wconversion"
+#include <llvm/ADT/StringRef.h>
+#pragma clang diagnostic pop
+
+#include <functional>
+
+namespace uscc
+{
+namespace scan
+{
+
+// Runs the work one of lexSource's threads has to do, on that thread
+// (so the caller can time it, for example)
+typedef std::function<void(const std::function<void()>& work)> LexWorkerHook;
+
+// Lexes text into tokens (replacing anything already in it).
+// Offsets in the buffer are relative to the start of text, and
+// the names of identifiers are interned into names.
+//
+// Up to numThreads threads are used, but only for files big enough
+// to be worth splitting. If numThreads is 0, up to one thread per
+// hardware thread is used. The tokens are the same either way.
+// If workerHook is set, each thread lexSource starts runs its chunk
+// through it (the calling thread's chunk doesn't go through it).
+void lexSource(llvm::StringRef text, TokenBuffer& tokens, NamePool& names,
+			   unsigned numThreads = 0,
+			   const LexWorkerHook& workerHook = LexWorkerHook());
+
+} // scan
+} // uscc
@@ -0,0 +1,45 @@
+//
+//  NamePool.cpp
+//  uscc
+//
+//  Implements the pool identifier names are interned into.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#include "NamePool.h"
+
+using namespace uscc::scan;
+
+const uint32_t NamePool::NoName;
+
+// Returns the ID for name, adding it to the pool if it's new.
+uint32_t NamePool::intern(llvm::StringRef name)
+{
+	auto iter = mIds.find(name);
+	if (iter != mIds.end())
+	{
+		return iter->second;
+	}
+
+	uint32_t id = static_cast<uint32_t>(mNames.size());
+	mNames.push_back(name.str());
+	mIds.emplace(llvm::StringRef(mNames.back()), id);
+	return id;
+}
+
+// Returns the ID for name, or NoName if it was never interned
+uint32_t NamePool::find(llvm::StringRef name) const noexcept
+{
+	auto iter = mIds.find(name);
+	if (iter != mIds.end())
+	{
+		return iter->second;
+	}
+	return NoName;
+}
@@ -0,0 +1,83 @@
+//
+//  NamePool.h
+//  uscc
+//
+//  Declares the pool identifier names are interned into.
+//
+//  The lexer interns the spelling of every identifier, and
+//  the parser and symbol tables work with the dense integer
+//  IDs it hands out. So resolving a symbol never has to
+//  build or hash a string.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wconversion"
+#include <llvm/ADT/Hashing.h>
+#include <llvm/ADT/StringRef.h>
+#pragma clang diagnostic pop
+
+namespace uscc
+{
+namespace scan
+{
+
+class NamePool
+{
+public:
+	// Returned by find for names that aren't in the pool
+	static const uint32_t NoName = UINT32_MAX;
+
+	NamePool() { }
+
+	NamePool(const NamePool&) = delete;
+	NamePool& operator=(const NamePool&) = delete;
+
+	// Returns the ID for name, adding it to the pool if it's new.
+	// IDs are handed out in order, starting at 0.
+	uint32_t intern(llvm::StringRef name);
+
+	// Returns the ID for name, or NoName if it was never interned
+	uint32_t find(llvm::StringRef name) const noexcept;
+
+	// The name stays valid for as long as the pool
+	const std::string& getName(uint32_t id) const noexcept
+	{
+		return mNames[id];
+	}
+
+	size_t size() const noexcept
+	{
+		return mNames.size();
+	}
+
+private:
+	struct Hash
+	{
+		size_t operator()(llvm::StringRef name) const noexcept
+		{
+			return llvm::hash_value(name);
+		}
+	};
+
+	// The keys are views into mNames
+	std::unordered_map<llvm::StringRef, uint32_t, Hash> mIds;
+	// A deque, so adding a name never moves the others
+	std::deque<std::string> mNames;
+};
+
+} // scan
+} // uscc
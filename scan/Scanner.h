@@ -0,0 +1,44 @@
+//
+//  Scanner.h
+//  uscc
+//
+//  Declares the scanner lexSource runs over each chunk of
+//  a source file.
+//
+//  There are two implementations, and the Makefile builds
+//  one of them (make SCANNER=flex or make SCANNER=fast):
+//  FlexScanner.cpp wraps the scanner flex generates from
+//  usc.l, and FastScanner.cpp is a hand-written scanner that
+//  gives exactly the same tokens, without needing flex.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#pragma once
+
+#include "TokenBuffer.h"
+#include "NamePool.h"
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wconversion"
+#include <llvm/ADT/StringRef.h>
+#pragma clang diagnostic pop
+
+namespace uscc
+{
+namespace scan
+{
+
+// Adds the tokens in text to the end of tokens (not including
+// EndOfFile), and interns identifiers into names.
+// base is the offset of text in the source file.
+// Whitespace and comments aren't added.
+void scanChunk(llvm::StringRef text, uint32_t base, TokenBuffer& tokens, NamePool& names);
+
+} // scan
+} // uscc
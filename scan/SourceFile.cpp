@@ -0,0 +1,193 @@
+//
+//  SourceFile.cpp
+//  uscc
+//
+//  Implements the class that holds the contents of a
+//  source file.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#include "SourceFile.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace uscc::scan;
+
+namespace
+{
+
+// Adds the offset after every newline in data to starts
+void findNewlines(const char* data, size_t size, std::vector<uint32_t>& starts)
+{
+	size_t i = 0;
+#ifdef __SSE2__
+	// Compare 16 bytes at a time, and only look at the
+	// individual bytes of blocks that have a newline
+	const __m128i newline = _mm_set1_epi8('\n');
+	for (; i + 16 <= size; i += 16)
+	{
+		__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+		unsigned int mask = static_cast<unsigned int>(
+			_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline)));
+		while (mask != 0)
+		{
+			unsigned int bit = static_cast<unsigned int>(__builtin_ctz(mask));
+			starts.push_back(static_cast<uint32_t>(i + bit + 1));
+			mask &= mask - 1;
+		}
+	}
+#endif
+	// Whatever's left (or everything, without SSE2) uses memchr,
+	// which is vectorized in most C libraries anyway
+	const char* curr = data + i;
+	const char* end = data + size;
+	while (curr < end)
+	{
+		const void* found = memchr(curr, '\n', static_cast<size_t>(end - curr));
+		if (found == nullptr)
+		{
+			break;
+		}
+		curr = static_cast<const char*>(found) + 1;
+		starts.push_back(static_cast<uint32_t>(curr - data));
+	}
+}
+
+} // anonymous
+
+SourceFile::SourceFile(const char* fileName)
+: mData("")
+, mSize(0)
+, mIsOpen(false)
+, mIsMapped(false)
+{
+#ifndef _WIN32
+	int fd = open(fileName, O_RDONLY);
+	if (fd == -1)
+	{
+		return;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+	{
+		void* addr = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ,
+						  MAP_PRIVATE, fd, 0);
+		if (addr != MAP_FAILED)
+		{
+			// The lexer reads the file front to back
+			madvise(addr, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+			mData = static_cast<const char*>(addr);
+			mSize = static_cast<size_t>(info.st_size);
+			mIsMapped = true;
+		}
+	}
+	close(fd);
+#endif
+
+	// Empty files (and anything that can't be mapped) are just read in
+	if (!mIsMapped)
+	{
+		std::ifstream file(fileName, std::ios::in | std::ios::binary);
+		if (!file.is_open())
+		{
+			return;
+		}
+		mBuffer.assign(std::istreambuf_iterator<char>(file),
+					   std::istreambuf_iterator<char>());
+		mData = mBuffer.c_str();
+		mSize = mBuffer.size();
+	}
+
+	mIsOpen = true;
+}
+
+SourceFile::~SourceFile()
+{
+#ifndef _WIN32
+	if (mIsMapped)
+	{
+		munmap(const_cast<char*>(mData), mSize);
+	}
+#endif
+}
+
+// Returns the requested line (starting at 1), without its newline.
+llvm::StringRef SourceFile::getLine(unsigned int lineNum) const noexcept
+{
+	const std::vector<uint32_t>& starts = getLineStarts();
+	if (lineNum == 0 || lineNum > starts.size())
+	{
+		return llvm::StringRef();
+	}
+
+	size_t begin = starts[lineNum - 1];
+	size_t end = mSize;
+	if (lineNum < starts.size())
+	{
+		// Leave off the newline
+		end = starts[lineNum] - 1;
+	}
+	return llvm::StringRef(mData + begin, end - begin);
+}
+
+// Returns the line (starting at 1) the byte at offset is on
+unsigned int SourceFile::getLineNumber(size_t offset) const noexcept
+{
+	const std::vector<uint32_t>& starts = getLineStarts();
+	// The first line that starts after offset is the one after ours
+	auto next = std::upper_bound(starts.begin(), starts.end(), offset);
+	return static_cast<unsigned int>(next - starts.begin());
+}
+
+// Returns the column (starting at 1) of the byte at offset.
+unsigned int SourceFile::getColNumber(size_t offset) const noexcept
+{
+	const std::vector<uint32_t>& starts = getLineStarts();
+	size_t lineStart = starts[getLineNumber(offset) - 1];
+	return static_cast<unsigned int>(offset - lineStart + 1);
+}
+
+// Number of lines in the file (a last line that's
+// empty isn't counted)
+size_t SourceFile::getNumLines() const noexcept
+{
+	const std::vector<uint32_t>& starts = getLineStarts();
+	size_t retVal = starts.size();
+	if (starts.back() == mSize)
+	{
+		retVal--;
+	}
+	return retVal;
+}
+
+// Offset of the first byte of each line, built on first use
+const std::vector<uint32_t>& SourceFile::getLineStarts() const noexcept
+{
+	// Diagnostics could be reported from more than one thread
+	std::call_once(mLineStartsFound, [this]()
+	{
+		mLineStarts.push_back(0);
+		findNewlines(mData, mSize, mLineStarts);
+	});
+	return mLineStarts;
+}
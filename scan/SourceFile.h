@@ -0,0 +1,95 @@
+//
+//  SourceFile.h
+//  uscc
+//
+//  Declares the class that holds the contents of a source
+//  file for the scanner and for diagnostics.
+//
+//  The file is mapped into memory once (where supported),
+//  and the lexer, token text and error source lines all
+//  work on views into that one copy.
+//
+//  Positions are just byte offsets until something needs a
+//  line and column. The first time one is asked for, the
+//  start of every line is found (with a vectorized newline
+//  scan), and lookups are binary searches after that.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wconversion"
+#include <llvm/ADT/StringRef.h>
+#pragma clang diagnostic pop
+
+namespace uscc
+{
+namespace scan
+{
+
+class SourceFile
+{
+public:
+	// Maps the file into memory.
+	// Check isOpen to see whether it could be read.
+	SourceFile(const char* fileName);
+	~SourceFile();
+
+	SourceFile(const SourceFile&) = delete;
+	SourceFile& operator=(const SourceFile&) = delete;
+
+	bool isOpen() const noexcept
+	{
+		return mIsOpen;
+	}
+
+	// The contents of the file
+	llvm::StringRef getText() const noexcept
+	{
+		return llvm::StringRef(mData, mSize);
+	}
+
+	// Returns the requested line (starting at 1), without its newline.
+	// Returns an empty view if the file doesn't have that many lines.
+	llvm::StringRef getLine(unsigned int lineNum) const noexcept;
+
+	// Returns the line (starting at 1) the byte at offset is on
+	unsigned int getLineNumber(size_t offset) const noexcept;
+
+	// Returns the column (starting at 1) of the byte at offset.
+	// Every byte is one column, even tabs.
+	unsigned int getColNumber(size_t offset) const noexcept;
+
+	// Number of lines in the file (a last line that's
+	// empty isn't counted)
+	size_t getNumLines() const noexcept;
+
+private:
+	// Offset of the first byte of each line, built on first use
+	const std::vector<uint32_t>& getLineStarts() const noexcept;
+
+	const char* mData;
+	size_t mSize;
+	// Used instead of a mapping if the file couldn't be mapped
+	std::string mBuffer;
+	bool mIsOpen;
+	bool mIsMapped;
+
+	mutable std::once_flag mLineStartsFound;
+	mutable std::vector<uint32_t> mLineStarts;
+};
+
+} // scan
+} // uscc
@@ -0,0 +1,62 @@
+//
+//  TokenBuffer.cpp
+//  uscc
+//
+//  Implements the buffer that holds every token of a
+//  source file.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#include "TokenBuffer.h"
+
+using namespace uscc::scan;
+
+// Removes every token and line
+void TokenBuffer::clear() noexcept
+{
+	mKinds.clear();
+	mOffsets.clear();
+	mLengths.clear();
+	mNameIds.clear();
+}
+
+// Reserves space for the requested number of tokens
+void TokenBuffer::reserve(size_t count)
+{
+	mKinds.reserve(count);
+	mOffsets.reserve(count);
+	mLengths.reserve(count);
+	mNameIds.reserve(count);
+}
+
+// Reserves space for the tokens that scanning textSize more
+// bytes is likely to add
+void TokenBuffer::reserveForText(size_t textSize)
+{
+	// A rough guess (a token every four bytes or so),
+	// so the buffer rarely has to grow
+	reserve(size() + textSize / 4 + 1);
+}
+
+// Adds every token in other to the end of the buffer.
+void TokenBuffer::append(const TokenBuffer& other, const std::vector<uint32_t>& nameMap)
+{
+	mKinds.insert(mKinds.end(), other.mKinds.begin(), other.mKinds.end());
+	mOffsets.insert(mOffsets.end(), other.mOffsets.begin(), other.mOffsets.end());
+	mLengths.insert(mLengths.end(), other.mLengths.begin(), other.mLengths.end());
+	for (size_t i = 0; i < other.size(); i++)
+	{
+		uint32_t nameId = 0;
+		if (other.getKind(i) == Token::Identifier)
+		{
+			nameId = nameMap[other.mNameIds[i]];
+		}
+		mNameIds.push_back(nameId);
+	}
+}
@@ -0,0 +1,98 @@
+//
+//  TokenBuffer.h
+//  uscc
+//
+//  Declares the buffer that holds every token of a source
+//  file, lexed up front.
+//
+//  Tokens are stored as a struct of arrays (kind, byte offset,
+//  length and, for identifiers, the name's ID in the
+//  NamePool), so the parser can walk them with cheap
+//  indexed peeks and look ahead as far as it needs.
+//  Whitespace and comments aren't stored, and neither are
+//  lines or columns: SourceFile works those out from the
+//  offset, only when a diagnostic needs them.
+//  The last token is always EndOfFile.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#pragma once
+
+#include "Tokens.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace uscc
+{
+namespace scan
+{
+
+class TokenBuffer
+{
+public:
+	// Removes every token and line
+	void clear() noexcept;
+
+	// Reserves space for the requested number of tokens
+	void reserve(size_t count);
+
+	// Reserves space for the tokens that scanning textSize more
+	// bytes is likely to add
+	void reserveForText(size_t textSize);
+
+	// Adds every token in other to the end of the buffer.
+	// The name IDs of its identifiers are mapped through nameMap.
+	void append(const TokenBuffer& other, const std::vector<uint32_t>& nameMap);
+
+	// Adds a token to the end of the buffer.
+	// nameId is only used for identifiers.
+	void add(Token::Tokens kind, uint32_t offset, uint32_t length, uint32_t nameId = 0)
+	{
+		mKinds.push_back(static_cast<uint8_t>(kind));
+		mOffsets.push_back(offset);
+		mLengths.push_back(length);
+		mNameIds.push_back(nameId);
+	}
+
+	size_t size() const noexcept
+	{
+		return mKinds.size();
+	}
+
+	Token::Tokens getKind(size_t index) const noexcept
+	{
+		return static_cast<Token::Tokens>(mKinds[index]);
+	}
+
+	uint32_t getOffset(size_t index) const noexcept
+	{
+		return mOffsets[index];
+	}
+
+	uint32_t getLength(size_t index) const noexcept
+	{
+		return mLengths[index];
+	}
+
+	// The ID of an identifier's name
+	uint32_t getNameId(size_t index) const noexcept
+	{
+		return mNameIds[index];
+	}
+
+private:
+	std::vector<uint8_t> mKinds;
+	std::vector<uint32_t> mOffsets;
+	std::vector<uint32_t> mLengths;
+	std::vector<uint32_t> mNameIds;
+};
+
+} // scan
+} // uscc
@@ -0,0 +1,369 @@
+#---------------------------------------------------------
+# Copyright (c) 2014, Sanjay Madhav
+# All rights reserved.
+#
+# This file is distributed under the BSD license.
+# See LICENSE.TXT for details.
+#---------------------------------------------------------
+import subprocess
+import os
+import sys
+import json
+import shutil
+import tempfile
+
+import unittest
+uscc = "../bin/uscc"
+lli = "../../bin/lli"
+clang = "../../bin/clang"
+
+__unittest = True
+
+class DriverTests(unittest.TestCase):
+
+	def setUp(self):
+		self.maxDiff = None
+		if not os.path.isfile(uscc):
+			raise Exception("Can't run without uscc")
+		if not os.path.isfile(lli):
+			raise Exception("lli not found at ../../bin/lli")
+
+	def checkRun(self, fileName):
+		# read in expected
+		expectFile = open("expected/" + fileName + ".output", "r")
+		expectedStr = expectFile.read()
+		expectFile.close()
+		try:
+			resultStr = subprocess.check_output([lli, fileName + ".bc"], stderr=subprocess.STDOUT)
+			self.assertMultiLineEqual(expectedStr, resultStr)
+		except subprocess.CalledProcessError as e:
+			self.fail("\n" + e.output)
+
+	def test_Driver_multiFile(self):
+		fileNames = ["emit02", "emit03", "emit04", "quicksort"]
+		for f in fileNames:
+			if os.path.isfile(f + ".bc"):
+				os.remove(f + ".bc")
+		try:
+			subprocess.check_call([uscc, "-j", "4"] + [f + ".usc" for f in fileNames],
+				stderr=subprocess.STDOUT)
+		except subprocess.CalledProcessError as e:
+			self.fail("\n" + e.output)
+		for f in fileNames:
+			self.checkRun(f)
+
+	def test_Driver_multiFileErrors(self):
+		# Errors should be reported in the order the files were given,
+		# regardless of which job finishes first
+		expectedStr = ""
+		for f in ["semant01e", "semant02e"]:
+			expectFile = open("expected/" + f + ".semant.err", "r")
+			expectedStr += expectFile.read()
+			expectFile.close()
+		try:
+			subprocess.check_output([uscc, "-a", "-j", "2", "semant01e.usc", "semant02e.usc"],
+				stderr=subprocess.STDOUT)
+			self.fail("Expected compilation to fail")
+		except subprocess.CalledProcessError as e:
+			outputStr = e.output
+			outputStr = outputStr.replace('\r\n','\n')
+			self.assertMultiLineEqual(expectedStr, outputStr)
+
+	def test_Driver_serve(self):
+		# Every job gets its own response, and the server outlives failed jobs
+		expectFile = open("expected/semant01e.semant.err", "r")
+		expectedErr = expectFile.read()
+		expectFile.close()
+		if os.path.isfile("emit02.bc"):
+			os.remove("emit02.bc")
+		jobs = "semant01e.usc\n\nemit02.usc\nquit\n"
+		proc = subprocess.Popen([uscc, "--serve"], stdin=subprocess.PIPE,
+			stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+		outputStr = proc.communicate(jobs)[0]
+		self.assertEqual(0, proc.returncode)
+		expectedStr = "@@output 0\n"
+		expectedStr += "@@errors " + str(len(expectedErr)) + "\n" + expectedErr
+		expectedStr += "@@status 1\n"
+		expectedStr += "@@output 0\n@@errors 0\n@@status 0\n"
+		self.assertMultiLineEqual(expectedStr, outputStr)
+		self.checkRun("emit02")
+
+	def test_Driver_timeReport(self):
+		try:
+			resultStr = subprocess.check_output([uscc, "-O", "-ftime-report",
+				"--report-format", "json", "quicksort.usc"], stderr=subprocess.STDOUT)
+		except subprocess.CalledProcessError as e:
+			self.fail("\n" + e.output)
+		report = json.loads(resultStr)
+		self.assertEqual("quicksort.usc", report["file"])
+		self.assertEqual(71, report["lines"])
+		self.assertGreater(report["tokens"], 0)
+		phases = [p["name"] for p in report["phases"]]
+		self.assertEqual(["Scanning", "Parsing and semantic analysis", "IR emission",
+			"Optimization", "Verification", "Bitcode writing"], phases)
+		passes = [p["name"] for p in report["passes"]]
+		self.assertEqual(["ConstantOps", "ConstantBranch", "DeadBlocks", "LICM"], passes)
+		functions = [f["name"] for f in report["functions"]]
+		self.assertIn("main", functions)
+		self.checkRun("quicksort")
+
+	def test_Driver_memReport(self):
+		try:
+			resultStr = subprocess.check_output([uscc, "-O", "--mem-report",
+				"--report-format", "json", "quicksort.usc"], stderr=subprocess.STDOUT)
+		except subprocess.CalledProcessError as e:
+			self.fail("\n" + e.output)
+		report = json.loads(resultStr)
+		phases = report["phases"]
+		self.assertEqual(["Parsing and semantic analysis", "IR emission",
+			"Optimization", "Bitcode writing"], [p["name"] for p in phases])
+		self.assertGreater(phases[0]["ast_nodes"], 0)
+		self.assertGreater(phases[0]["identifiers"], 0)
+		self.assertGreater(phases[0]["scope_tables"], 0)
+		self.assertEqual(0, phases[0]["llvm_instructions"])
+		self.assertGreater(phases[1]["ssa_submaps"], 0)
+		self.assertGreater(phases[1]["llvm_blocks"], 0)
+		self.assertGreater(phases[1]["llvm_instructions"], 0)
+
+	def test_Driver_generated(self):
+		# Programs generated for the benchmarks must compile cleanly
+		sys.path.append("../bench")
+		import genusc
+		outDir = tempfile.mkdtemp()
+		try:
+			fileName = os.path.join(outDir, "generated.usc")
+			source = open(fileName, "w")
+			source.write(genusc.generate(functions=5, statements=40, strings=5, seed=7))
+			source.close()
+			subprocess.check_output([uscc, "-O", fileName], stderr=subprocess.STDOUT)
+			self.assertTrue(os.path.isfile(os.path.join(outDir, "generated.bc")))
+		except subprocess.CalledProcessError as e:
+			self.fail("\n" + e.output)
+		finally:
+			shutil.rmtree(outDir)
+
+	def test_Driver_lexThreads(self):
+		# A large file lexed in parallel must give the same tokens as a
+		# single thread, even with string literals split across lines
+		sys.path.append("../bench")
+		import genusc
+		import re
+		outDir = tempfile.mkdtemp()
+		try:
+			text = genusc.generate(functions=400, statements=100, strings=4000, seed=3)
+			text = re.sub(r'(char s\d+\[\] = ")([^"]*)',
+				lambda m: m.group(1) + m.group(2).replace(" ", "\n"), text)
+			fileName = os.path.join(outDir, "large.usc")
+			source = open(fileName, "w")
+			source.write(text)
+			source.close()
+			results = []
+			for threads in ["1", "8"]:
+				proc = subprocess.Popen([uscc, "-a", "-ftime-report", "--report-format", "json",
+					"--lex-threads", threads, fileName], stdout=subprocess.PIPE,
+					stderr=subprocess.PIPE)
+				ast, report = proc.communicate()
+				self.assertEqual(0, proc.returncode, report)
+				report = json.loads(report)
+				results.append((ast, report["lines"], report["tokens"]))
+			self.assertEqual(text.count("\n"), results[0][1])
+			self.assertEqual(results[0], results[1])
+		finally:
+			shutil.rmtree(outDir)
+
+	def test_Driver_parseThreads(self):
+		# Bodies parsed in parallel must give the same AST and the
+		# same errors as a single thread, and a body can't call a
+		# function declared after it
+		sys.path.append("../bench")
+		import genusc
+		outDir = tempfile.mkdtemp()
+		try:
+			bad = ""
+			for i in range(100):
+				bad += "int g%d(int x)\n{\n\tprintf(\"g%d\\n\");\n" % (i, i)
+				bad += "\treturn g%d(x) + y%d;\n}\n" % ((i + 1) % 100, i)
+			sources = [("good.usc", genusc.generate(functions=200, statements=20, seed=5)),
+				("bad.usc", bad)]
+			for name, text in sources:
+				fileName = os.path.join(outDir, name)
+				source = open(fileName, "w")
+				source.write(text)
+				source.close()
+				results = []
+				for threads in ["1", "8"]:
+					proc = subprocess.Popen([uscc, "-a", "--parse-threads", threads, fileName],
+						stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+					ast, errors = proc.communicate()
+					results.append((proc.returncode, ast, errors))
+				self.assertEqual(results[0], results[1])
+			self.assertEqual(1, results[0][0])
+			self.assertIn("Use of undeclared identifier 'g1'", results[0][2])
+			self.assertIn("298 Error(s)", results[0][2])
+		finally:
+			shutil.rmtree(outDir)
+
+	def test_Driver_cache(self):
+		cacheDir = tempfile.mkdtemp()
+		try:
+			args = [uscc, "-O", "-p", "--cache-dir", cacheDir, "emit02.usc"]
+			firstStr = subprocess.check_output(args, stderr=subprocess.STDOUT)
+			entries = [f for f in os.listdir(cacheDir) if f.endswith(".bc")]
+			self.assertEqual(1, len(entries))
+			# A hit restores both the bitcode and the printed IR
+			os.remove("emit02.bc")
+			secondStr = subprocess.check_output(args, stderr=subprocess.STDOUT)
+			self.assertMultiLineEqual(firstStr, secondStr)
+			self.checkRun("emit02")
+			# Different flags are a different entry
+			subprocess.check_output([uscc, "--cache-dir", cacheDir, "emit02.usc"],
+				stderr=subprocess.STDOUT)
+			entries = [f for f in os.listdir(cacheDir) if f.endswith(".bc")]
+			self.assertEqual(2, len(entries))
+			self.checkRun("emit02")
+		except subprocess.CalledProcessError as e:
+			self.fail("\n" + e.output)
+		finally:
+			shutil.rmtree(cacheDir)
+
+	def test_Driver_incremental(self):
+		cacheDir = tempfile.mkdtemp()
+		srcDir = tempfile.mkdtemp()
+		try:
+			srcFile = open("quicksort.usc", "r")
+			source = srcFile.read()
+			srcFile.close()
+			fileName = os.path.join(srcDir, "quicksort.usc")
+			args = [uscc, "-O", "--cache-dir", cacheDir, "--incremental", fileName]
+			
+			srcFile = open(fileName, "w")
+			srcFile.write(source)
+			srcFile.close()
+			subprocess.check_output(args, stderr=subprocess.STDOUT)
+			entries = [f for f in os.listdir(cacheDir) if f.endswith(".fn.bc")]
+			self.assertEqual(3, len(entries))
+			
+			# Only main changes, so it's the only function compiled again
+			srcFile = open(fileName, "w")
+			srcFile.write(source.replace('printf("%s\\n"', 'printf("sorted: %s\\n"'))
+			srcFile.close()
+			subprocess.check_output(args, stderr=subprocess.STDOUT)
+			entries = [f for f in os.listdir(cacheDir) if f.endswith(".fn.bc")]
+			self.assertEqual(4, len(entries))
+			
+			resultStr = subprocess.check_output([lli, os.path.join(srcDir, "quicksort.bc")],
+				stderr=subprocess.STDOUT)
+			self.assertMultiLineEqual("sorted: abcdeeefghhijklmnoooopqrrsttuuvwxyz\n", resultStr)
+		except subprocess.CalledProcessError as e:
+			self.fail("\n" + e.output)
+		finally:
+			shutil.rmtree(cacheDir)
+			shutil.rmtree(srcDir)
+
+	def test_Driver_run(self):
+		for f in ["emit02", "quicksort"]:
+			if os.path.isfile(f + ".bc"):
+				os.remove(f + ".bc")
+			expectFile = open("expected/" + f + ".output", "r")
+			expectedStr = expectFile.read()
+			expectFile.close()
+			try:
+				resultStr = subprocess.check_output([uscc, "-O", "--run", f + ".usc"],
+					stderr=subprocess.STDOUT)
+				self.assertMultiLineEqual(expectedStr, resultStr)
+			except subprocess.CalledProcessError as e:
+				self.fail("\n" + e.output)
+			# Without -b, --run doesn't write bitcode
+			self.assertFalse(os.path.isfile(f + ".bc"))
+
+	def test_Driver_runAST(self):
+		# -a prints the AST, but doesn't stop --run from running the program
+		expectFile = open("expected/emit02.semant.ast", "r")
+		expectedStr = expectFile.read()
+		expectFile.close()
+		expectFile = open("expected/emit02.output", "r")
+		expectedStr += expectFile.read()
+		expectFile.close()
+		try:
+			resultStr = subprocess.check_output([uscc, "--run", "-a", "emit02.usc"],
+				stderr=subprocess.STDOUT)
+			self.assertMultiLineEqual(expectedStr, resultStr)
+		except subprocess.CalledProcessError as e:
+			self.fail("\n" + e.output)
+
+	def test_Driver_native(self):
+		if not os.path.isfile(clang):
+			self.skipTest("clang not found at ../../bin/clang")
+		outDir = tempfile.mkdtemp()
+		try:
+			expectFile = open("expected/quicksort.output", "r")
+			expectedStr = expectFile.read()
+			expectFile.close()
+			exeFile = os.path.join(outDir, "quicksort")
+			# Both assembly and object files should link into a working program
+			for flag, ext in [("-s", ".s"), ("-c", ".o")]:
+				outFile = os.path.join(outDir, "quicksort" + ext)
+				subprocess.check_output([uscc, "-O", flag, "-mcpu", "native", "-o", outFile,
+					"quicksort.usc"], stderr=subprocess.STDOUT)
+				subprocess.check_output([clang, outFile, "-o", exeFile],
+					stderr=subprocess.STDOUT)
+				resultStr = subprocess.check_output([exeFile], stderr=subprocess.STDOUT)
+				self.assertMultiLineEqual(expectedStr, resultStr)
+		except subprocess.CalledProcessError as e:
+			self.fail("\n" + e.output)
+		finally:
+			shutil.rmtree(outDir)
+
+	def test_Driver_batch(self):
+		outDir = tempfile.mkdtemp()
+		try:
+			manifestName = os.path.join(outDir, "manifest.txt")
+			manifest = open(manifestName, "w")
+			manifest.write("# comment\n")
+			manifest.write("emit02.usc " + os.path.join(outDir, "emit02.bc") + "\n")
+			manifest.write("semant01e.usc - -a\n")
+			manifest.write("\n")
+			manifest.write("quicksort.usc " + os.path.join(outDir, "quicksort.bc") + " -O\n")
+			manifest.write("missing.usc\n")
+			manifest.close()
+			proc = subprocess.Popen([uscc, "-j", "2", "--report-format", "json",
+				"--batch", manifestName], stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+			errStr = proc.communicate()[1]
+			# Failed jobs don't stop the rest of the batch
+			self.assertEqual(1, proc.returncode)
+			summary = json.loads(errStr[errStr.rindex("{\"manifest\""):])
+			self.assertEqual(4, summary["jobs"])
+			self.assertEqual(2, summary["succeeded"])
+			self.assertEqual([2, 3, 5, 6], [r["line"] for r in summary["results"]])
+			self.assertEqual([0, 1, 0, 1], [r["status"] for r in summary["results"]])
+			for f in ["emit02", "quicksort"]:
+				expectFile = open("expected/" + f + ".output", "r")
+				expectedStr = expectFile.read()
+				expectFile.close()
+				resultStr = subprocess.check_output([lli, os.path.join(outDir, f + ".bc")],
+					stderr=subprocess.STDOUT)
+				self.assertMultiLineEqual(expectedStr, resultStr)
+		except subprocess.CalledProcessError as e:
+			self.fail("\n" + e.output)
+		finally:
+			shutil.rmtree(outDir)
+
+	def test_Driver_batchReportFormat(self):
+		# An unknown report format fails the batch before any job runs
+		outDir = tempfile.mkdtemp()
+		try:
+			manifestName = os.path.join(outDir, "manifest.txt")
+			manifest = open(manifestName, "w")
+			manifest.write("emit02.usc " + os.path.join(outDir, "emit02.bc") + "\n")
+			manifest.close()
+			proc = subprocess.Popen([uscc, "--report-format", "xml", "--batch", manifestName],
+				stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+			errStr = proc.communicate()[1]
+			self.assertEqual(1, proc.returncode)
+			self.assertEqual("uscc: error: Unknown report format xml.\n", errStr)
+			self.assertFalse(os.path.isfile(os.path.join(outDir, "emit02.bc")))
+		finally:
+			shutil.rmtree(outDir)
+
+if __name__ == '__main__':
+	unittest.main(verbosity=2)
@@ -78,6 +78,19 @@ class EmitTests(unittest.TestCase):
 	def test_Emit_quicksort(self):
 		self.checkEmit("quicksort")
 		
+	def test_Opt_benchKernels(self):
+		# The runtime benchmark kernels must give the same result with -O
+		kernels = {"sort": "807124\n", "sieve": "1308400\n", "matmul": "-1198\n",
+			"strscan": "636461\n", "fib": "9227465\n"}
+		for kernel, expectedStr in kernels.items():
+			for flags in [[], ["-O"]]:
+				try:
+					resultStr = subprocess.check_output([uscc, "--run"] + flags +
+						["../bench/kernels/" + kernel + ".usc"], stderr=subprocess.STDOUT)
+					self.assertMultiLineEqual(expectedStr, resultStr)
+				except subprocess.CalledProcessError as e:
+					self.fail("\n" + e.output)
+		
 	def test_Emit_015(self):
 		self.checkEmit("test015")
 		
@@ -8,6 +8,8 @@
 import subprocess
 import os
 import sys
+import shutil
+import tempfile
 
 import unittest
 uscc = "../bin/uscc"
@@ -114,5 +116,30 @@ class ParseTests(unittest.TestCase):
 	def test_Err_parse06(self):
 		self.checkError("parse06e")
 
+	def test_Err_parse07(self):
+		self.checkError("parse07e")
+
+	def test_Err_flatChain(self):
+		# Every operator in a + chain is another level of the AST,
+		# so a long enough chain hits the nesting limit
+		outDir = tempfile.mkdtemp()
+		try:
+			for length, valid in [(100000, True), (200001, False)]:
+				fileName = os.path.join(outDir, "chain.usc")
+				source = open(fileName, "w")
+				source.write("int main()\n{\n\tint x = 1;\n\tx = " +
+					" + ".join(["x"] * length) + ";\n\treturn x;\n}\n")
+				source.close()
+				proc = subprocess.Popen([uscc, "-a", fileName], stdout=subprocess.PIPE,
+					stderr=subprocess.STDOUT)
+				outputStr = proc.communicate()[0]
+				if valid:
+					self.assertEqual(0, proc.returncode)
+				else:
+					self.assertEqual(1, proc.returncode)
+					self.assertIn("Nesting is too deep (the limit is 200000 levels)", outputStr)
+		finally:
+			shutil.rmtree(outDir)
+
 if __name__ == '__main__':
 	unittest.main(verbosity=2)
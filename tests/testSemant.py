@@ -69,6 +69,9 @@ class SemantTests(unittest.TestCase):
 	def test_Sem_semant02(self):
 		self.checkAST("semant02")
 		
+	def test_Sem_semant03(self):
+		self.checkAST("semant03")
+		
 	def test_Sem_emit01(self):
 		self.checkAST("emit01")
 		
@@ -141,6 +144,12 @@ class SemantTests(unittest.TestCase):
 	def test_SemErr_semant12e(self):
 		self.checkError("semant12e")
 		
+	def test_SemErr_semant13e(self):
+		self.checkError("semant13e")
+		
+	def test_SemErr_semant14e(self):
+		self.checkError("semant14e")
+		
 	def test_SemErr_002(self):
 		self.checkError("test002")
 		
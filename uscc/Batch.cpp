@@ -0,0 +1,209 @@
+//
+//  Batch.cpp
+//  uscc
+//
+//  Implements the batch mode used by uscc --batch.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#include "Batch.h"
+#include "Driver.h"
+#include "../opt/JSON.h"
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace uscc
+{
+namespace driver
+{
+
+namespace
+{
+
+// A single line of the manifest, and what happened when it ran
+struct BatchJob
+{
+	BatchJob()
+	: mLine(0)
+	, mExitCode(0)
+	, mSeconds(0.0)
+	{ }
+	
+	std::vector<std::string> mArgs;
+	// Line in the manifest (for messages)
+	int mLine;
+	std::string mInput;
+	std::string mOutput;
+	std::string mErrors;
+	int mExitCode;
+	double mSeconds;
+};
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+void printTable(const std::vector<BatchJob>& jobs, const std::string& manifestName,
+				size_t numFailed, double totalSeconds, std::ostream& output)
+{
+	const char* separator =
+		"===-------------------------------------------------------===\n";
+	output << separator;
+	output << "  Batch summary for " << manifestName << "\n";
+	output << separator;
+	output << "  Wall (s)  Status  Input\n";
+	
+	output << std::fixed << std::setprecision(4);
+	for (auto& job : jobs)
+	{
+		output << "  " << std::setw(8) << job.mSeconds << "  ";
+		output << (job.mExitCode == 0 ? "    ok" : "FAILED") << "  " << job.mInput << "\n";
+	}
+	
+	output << "  Total: " << jobs.size() << " jobs, " << jobs.size() - numFailed << " succeeded, "
+		<< numFailed << " failed in " << totalSeconds << "s";
+	if (totalSeconds > 0.0)
+	{
+		output << " (" << std::setprecision(1) << static_cast<double>(jobs.size()) / totalSeconds << " jobs/s)";
+	}
+	output << "\n";
+	output.unsetf(std::ios::floatfield);
+}
+
+void printJSON(const std::vector<BatchJob>& jobs, const std::string& manifestName,
+			   size_t numFailed, double totalSeconds, std::ostream& output)
+{
+	output << "{\"manifest\": ";
+	opt::writeJSONString(output, manifestName);
+	output << ", \"jobs\": " << jobs.size();
+	output << ", \"succeeded\": " << jobs.size() - numFailed;
+	output << ", \"failed\": " << numFailed;
+	output << ", \"wall_seconds\": " << totalSeconds;
+	output << ", \"results\": [";
+	for (size_t i = 0; i < jobs.size(); i++)
+	{
+		const BatchJob& job = jobs[i];
+		output << (i ? ", " : "") << "{\"line\": " << job.mLine << ", \"input\": ";
+		opt::writeJSONString(output, job.mInput);
+		output << ", \"status\": " << job.mExitCode;
+		output << ", \"wall_seconds\": " << job.mSeconds << "}";
+	}
+	output << "]}\n";
+}
+
+} // anonymous
+
+// Runs every job in the manifest (read from input) on up to numThreads
+// threads, then writes the output of each job to output, and the
+// diagnostics of each job followed by a summary to errStream.
+int runBatch(std::istream& input, const std::string& manifestName,
+			 unsigned numThreads, bool json, const ServerJob& job,
+			 std::ostream& output, std::ostream& errStream)
+{
+	std::vector<BatchJob> jobs;
+	std::string line;
+	int lineNum = 0;
+	while (std::getline(input, line))
+	{
+		lineNum++;
+		std::vector<std::string> args = splitJobLine(line);
+		if (args.empty() || args[0][0] == '#')
+		{
+			continue;
+		}
+		
+		BatchJob batchJob;
+		batchJob.mLine = lineNum;
+		batchJob.mInput = args[0];
+		if (args.size() < 2)
+		{
+			// Still counted, so it shows up in the summary
+			std::ostringstream err;
+			err << manifestName << ":" << lineNum << ": error: Expected an input and an output file." << std::endl;
+			batchJob.mErrors = err.str();
+			batchJob.mExitCode = 1;
+		}
+		else
+		{
+			// The job is the options, then -o output, then the input
+			batchJob.mArgs.assign(args.begin() + 2, args.end());
+			if (args[1] != "-")
+			{
+				batchJob.mArgs.push_back("-o");
+				batchJob.mArgs.push_back(args[1]);
+			}
+			batchJob.mArgs.push_back(args[0]);
+		}
+		jobs.push_back(batchJob);
+	}
+	
+	// Each job's output is written as soon as every job before it is
+	// done, so it comes out in manifest order without all of it being
+	// held until the end
+	std::mutex writeMutex;
+	std::vector<char> done(jobs.size(), false);
+	size_t nextToWrite = 0;
+	size_t numFailed = 0;
+	auto writeDone = [&](size_t i)
+	{
+		std::lock_guard<std::mutex> lock(writeMutex);
+		done[i] = true;
+		while (nextToWrite < jobs.size() && done[nextToWrite])
+		{
+			BatchJob& batchJob = jobs[nextToWrite];
+			output << batchJob.mOutput;
+			errStream << batchJob.mErrors;
+			output.flush();
+			std::string().swap(batchJob.mOutput);
+			std::string().swap(batchJob.mErrors);
+			if (batchJob.mExitCode != 0)
+			{
+				numFailed++;
+			}
+			nextToWrite++;
+		}
+	};
+	
+	auto batchStart = std::chrono::steady_clock::now();
+	runJobs(jobs.size(), numThreads, [&jobs, &job, &writeDone](size_t i)
+	{
+		BatchJob& batchJob = jobs[i];
+		if (!batchJob.mArgs.empty())
+		{
+			std::ostringstream jobOutput;
+			std::ostringstream jobErrors;
+			auto start = std::chrono::steady_clock::now();
+			batchJob.mExitCode = job(batchJob.mArgs, jobOutput, jobErrors);
+			batchJob.mSeconds = secondsSince(start);
+			batchJob.mOutput = jobOutput.str();
+			batchJob.mErrors = jobErrors.str();
+		}
+		writeDone(i);
+	});
+	double totalSeconds = secondsSince(batchStart);
+	
+	if (json)
+	{
+		printJSON(jobs, manifestName, numFailed, totalSeconds, errStream);
+	}
+	else
+	{
+		printTable(jobs, manifestName, numFailed, totalSeconds, errStream);
+	}
+	
+	return numFailed ? 1 : 0;
+}
+
+} // driver
+} // uscc
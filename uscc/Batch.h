@@ -0,0 +1,51 @@
+//
+//  Batch.h
+//  uscc
+//
+//  Declares the batch mode used by uscc --batch.
+//
+//  A batch manifest has one job per line, written as the
+//  input file, the output file and then any other options:
+//
+//     quicksort.usc quicksort.bc -O
+//     emit02.usc emit02.s -s -mcpu native
+//
+//  An output of "-" uses the default output name.
+//  Blank lines and lines starting with # are skipped.
+//  Arguments are split the same way as server jobs.
+//
+//  Every job runs in the same process, on a bounded pool of
+//  worker threads. A job that fails doesn't stop the batch.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#pragma once
+
+#include "Server.h"
+#include <string>
+#include <istream>
+#include <ostream>
+
+namespace uscc
+{
+namespace driver
+{
+
+// Runs every job in the manifest (read from input) on up to numThreads
+// threads, then writes the output of each job to output, and the
+// diagnostics of each job followed by a summary to errStream.
+// The summary is written as JSON if json is true.
+// manifestName is only used in messages.
+// Returns 0 if every job succeeded, and 1 otherwise.
+int runBatch(std::istream& input, const std::string& manifestName,
+			 unsigned numThreads, bool json, const ServerJob& job,
+			 std::ostream& output, std::ostream& errStream);
+
+} // driver
+} // uscc
@@ -0,0 +1,319 @@
+//
+//  Cache.cpp
+//  uscc
+//
+//  Implements the on-disk cache of compiled bitcode.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#include "Cache.h"
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wconversion"
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+#pragma clang diagnostic pop
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace llvm;
+
+namespace uscc
+{
+namespace driver
+{
+
+namespace
+{
+
+// Any change to the compiler that changes its output should bump this,
+// so stale entries are never used
+const char* cacheVersion = "uscc 0.5 cache 1";
+
+// A temporary file, or a .out without its .bc, this old was
+// left by a writer that died, and is removed by eviction
+const int64_t staleSeconds = 60 * 60;
+
+// Size of each cache directory, as of this process's last scan of it
+// plus whatever it has stored since (stores by other processes aren't
+// counted). The directory is only scanned once this is over the limit,
+// so a --batch run doesn't scan it after every job.
+std::mutex sizeMutex;
+std::unordered_map<std::string, uint64_t> estimatedSizes;
+
+// Reads the whole file into data. Returns false if it can't be read.
+bool readFile(const std::string& path, std::string& data)
+{
+	auto buffer = MemoryBuffer::getFile(path);
+	if (!buffer)
+	{
+		return false;
+	}
+	data = (*buffer)->getBuffer().str();
+	return true;
+}
+
+} // anonymous
+
+BitcodeCache::BitcodeCache(const std::string& dir, uint64_t maxBytes)
+: mDir(dir)
+, mMaxBytes(maxBytes)
+{
+	sys::fs::create_directories(mDir);
+}
+
+// Computes the key for compiling the given source file with the given flags.
+bool BitcodeCache::computeKey(const std::string& fileName, const std::string& flags,
+							  std::string& key) const
+{
+	auto buffer = MemoryBuffer::getFile(fileName);
+	if (!buffer)
+	{
+		return false;
+	}
+
+	key = computeKey((*buffer)->getBuffer(), flags);
+	return true;
+}
+
+// Computes the key for compiling the given source text with the given flags
+std::string BitcodeCache::computeKey(StringRef source, const std::string& flags) const
+{
+	// Each part is terminated with a NUL, so different
+	// splits of the same bytes can't collide
+	MD5 hash;
+	hash.update(StringRef(cacheVersion, strlen(cacheVersion) + 1));
+	hash.update(StringRef(flags.c_str(), flags.size() + 1));
+	hash.update(source);
+
+	MD5::MD5Result result;
+	hash.final(result);
+	SmallString<32> str;
+	MD5::stringifyResult(result, str);
+	return str.str();
+}
+
+// Looks up an entry. On a hit, the bitcode is copied to bcFile, the text
+// the compile printed is stored in output, and true is returned.
+bool BitcodeCache::lookup(const std::string& key, const std::string& bcFile,
+						  std::string& output) const
+{
+	std::string entry = mDir + "/" + key;
+
+	// Another process may evict the entry at any point, so
+	// anything we can't read is just a miss
+	std::string bitcode;
+	if (!readFile(entry + ".bc", bitcode) || !readFile(entry + ".out", output))
+	{
+		return false;
+	}
+
+	std::string err;
+	raw_fd_ostream file(bcFile.c_str(), err, sys::fs::F_None);
+	if (!err.empty())
+	{
+		return false;
+	}
+	file << bitcode;
+
+	// Mark the entry as recently used, for eviction
+	int fd;
+	if (!sys::fs::openFileForWrite(entry + ".bc", fd, sys::fs::F_Append))
+	{
+		raw_fd_ostream touched(fd, true);
+		sys::fs::setLastModificationAndAccessTime(fd, sys::TimeValue::now());
+	}
+
+	return true;
+}
+
+// Adds the bitcode in bcFile (and the text the compile printed)
+// as the entry for key, then evicts old entries if needed.
+void BitcodeCache::store(const std::string& key, const std::string& bcFile,
+						 const std::string& output) const
+{
+	std::string bitcode;
+	if (!readFile(bcFile, bitcode))
+	{
+		return;
+	}
+
+	// The .out is written first, since lookup treats
+	// the entry as present once the .bc exists
+	std::string entry = mDir + "/" + key;
+	if (writeEntryFile(entry + ".out", output) &&
+		writeEntryFile(entry + ".bc", bitcode))
+	{
+		added(output.size() + bitcode.size());
+	}
+}
+
+// Records that bytes were added to the directory, and evicts
+// old entries if that may have put the cache over its size limit
+void BitcodeCache::added(uint64_t bytes) const
+{
+	// Held while scanning too, so parallel jobs don't all scan at once
+	std::lock_guard<std::mutex> lock(sizeMutex);
+	auto iter = estimatedSizes.find(mDir);
+	if (iter != estimatedSizes.end())
+	{
+		iter->second += bytes;
+		if (iter->second <= mMaxBytes)
+		{
+			return;
+		}
+	}
+
+	// The first store to a directory scans it, to find out its size
+	estimatedSizes[mDir] = evict();
+}
+
+// Atomically writes data to the entry file with the requested path
+bool BitcodeCache::writeEntryFile(const std::string& path, const std::string& data) const
+{
+	int fd;
+	SmallString<128> tempPath;
+	if (sys::fs::createUniqueFile(mDir + "/tmp-%%%%%%%%", fd, tempPath))
+	{
+		return false;
+	}
+
+	{
+		raw_fd_ostream file(fd, true);
+		file << data;
+		file.close();
+		if (file.has_error())
+		{
+			file.clear_error();
+			sys::fs::remove(tempPath.str());
+			return false;
+		}
+	}
+
+	// Rename is atomic, so concurrent readers see either
+	// the old entry, or the complete new one
+	if (sys::fs::rename(tempPath.str(), path))
+	{
+		sys::fs::remove(tempPath.str());
+		return false;
+	}
+	return true;
+}
+
+// Removes the least recently used entries until the cache is
+// under its size limit. Returns the size of what's left.
+uint64_t BitcodeCache::evict() const
+{
+	struct Entry
+	{
+		std::string mKey;
+		sys::fs::file_status mStatus;
+		uint64_t mSize;
+	};
+
+	sys::TimeValue staleTime = sys::TimeValue::now();
+	staleTime -= sys::TimeValue(staleSeconds);
+
+	std::vector<Entry> entries;
+	std::vector<Entry> outputs;
+	std::unordered_set<std::string> keys;
+	uint64_t totalSize = 0;
+	std::error_code ec;
+	for (sys::fs::directory_iterator iter(mDir, ec), end; iter != end && !ec;
+		 iter.increment(ec))
+	{
+		Entry entry;
+		if (iter->status(entry.mStatus))
+		{
+			continue;
+		}
+		entry.mSize = entry.mStatus.getSize();
+
+		// Entries are tracked by their .bc, which holds the recently
+		// used time, and a whole-file entry's .out is counted with it
+		StringRef path = iter->path();
+		StringRef fileName = sys::path::filename(path);
+		if (fileName.startswith("tmp-"))
+		{
+			if (entry.mStatus.getLastModificationTime() < staleTime)
+			{
+				sys::fs::remove(path);
+				continue;
+			}
+		}
+		else if (sys::path::extension(path) == ".bc")
+		{
+			entry.mKey = sys::path::stem(path).str();
+			keys.insert(entry.mKey);
+			entries.push_back(entry);
+		}
+		else if (sys::path::extension(path) == ".out")
+		{
+			// Counted once we know whether its .bc is there
+			entry.mKey = sys::path::stem(path).str();
+			outputs.push_back(entry);
+			continue;
+		}
+		totalSize += entry.mSize;
+	}
+
+	// A .out is written before its .bc, so a recent one
+	// without a .bc may just not have its .bc yet
+	for (auto& output : outputs)
+	{
+		if (keys.count(output.mKey) == 0 &&
+			output.mStatus.getLastModificationTime() < staleTime)
+		{
+			sys::fs::remove(mDir + "/" + output.mKey + ".out");
+		}
+		else
+		{
+			totalSize += output.mSize;
+		}
+	}
+
+	if (totalSize <= mMaxBytes)
+	{
+		return totalSize;
+	}
+
+	std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b)
+	{
+		return a.mStatus.getLastModificationTime() < b.mStatus.getLastModificationTime();
+	});
+
+	for (auto& entry : entries)
+	{
+		if (totalSize <= mMaxBytes)
+		{
+			break;
+		}
+
+		// If another process already removed it, that's fine
+		std::string base = mDir + "/" + entry.mKey;
+		uint64_t outSize = 0;
+		sys::fs::file_size(base + ".out", outSize);
+		sys::fs::remove(base + ".bc");
+		sys::fs::remove(base + ".out");
+		totalSize -= std::min(totalSize, entry.mSize + outSize);
+	}
+	return totalSize;
+}
+
+} // driver
+} // uscc
@@ -0,0 +1,79 @@
+//
+//  Cache.h
+//  uscc
+//
+//  Declares the on-disk cache of compiled bitcode (--cache-dir).
+//
+//  Entries are keyed by a hash of the compiler version, the
+//  flags that affect the output and the bytes of the source,
+//  so an unchanged file compiled with the same flags skips
+//  every compilation step.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wconversion"
+#include <llvm/ADT/StringRef.h>
+#pragma clang diagnostic pop
+
+namespace uscc
+{
+namespace driver
+{
+
+// Several uscc processes can safely share one cache directory.
+// Entries are written to a unique temporary file and renamed into
+// place, so readers only ever see complete entries.
+class BitcodeCache
+{
+public:
+	BitcodeCache(const std::string& dir, uint64_t maxBytes);
+
+	// Computes the key for compiling the given source file with the given
+	// flags. Returns false if the source file can't be read.
+	bool computeKey(const std::string& fileName, const std::string& flags,
+					std::string& key) const;
+
+	// Computes the key for compiling the given source text with the given flags
+	std::string computeKey(llvm::StringRef source, const std::string& flags) const;
+
+	// Looks up an entry. On a hit, the bitcode is copied to bcFile, the text
+	// the compile printed is stored in output, and true is returned.
+	bool lookup(const std::string& key, const std::string& bcFile,
+				std::string& output) const;
+
+	// Adds the bitcode in bcFile (and the text the compile printed)
+	// as the entry for key, then evicts old entries if needed.
+	void store(const std::string& key, const std::string& bcFile,
+			   const std::string& output) const;
+
+	// Records that bytes were added to the directory (by store, or by
+	// the function cache), and evicts old entries if that may have
+	// put the cache over its size limit
+	void added(uint64_t bytes) const;
+
+private:
+	// Atomically writes data to the entry file with the requested path
+	bool writeEntryFile(const std::string& path, const std::string& data) const;
+
+	// Removes the least recently used entries until the cache is
+	// under its size limit. Returns the size of what's left.
+	uint64_t evict() const;
+
+	std::string mDir;
+	uint64_t mMaxBytes;
+};
+
+} // driver
+} // uscc
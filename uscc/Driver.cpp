@@ -0,0 +1,461 @@
+//
+//  Driver.cpp
+//  uscc
+//
+//  Implements the helpers the uscc driver uses to compile
+//  one or more input files.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#include "Driver.h"
+#include "Cache.h"
+#include "../parse/Parse.h"
+#include "../parse/ParseExcept.h"
+#include "../parse/Emitter.h"
+#include "../parse/Session.h"
+#include "../parse/FunctionCache.h"
+#include "../parse/StackThread.h"
+#include "../opt/TimeReport.h"
+#include "../opt/MemReport.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace uscc
+{
+namespace driver
+{
+
+// Replaces the extension of the input file name with the requested one
+std::string replaceExtension(const std::string& fileName, const char* ext)
+{
+	std::string retVal = fileName;
+	size_t extLoc = retVal.find_last_of(".");
+	if (extLoc != std::string::npos)
+	{
+		// Strip the last extension
+		retVal = retVal.substr(0, extLoc);
+	}
+	retVal += ext;
+	return retVal;
+}
+
+namespace
+{
+
+// The parser and the AST walks recurse once per level of nesting, so
+// a program nested Parser::MaxNestingDepth deep needs a much bigger
+// stack than threads get by default (parsing alone takes about 64MB)
+const size_t compileStackSize = 512 * 1024 * 1024;
+
+// Runs func on a thread with a compileStackSize stack, and waits for it.
+// The threads runJobs starts already have one, so func runs right there.
+// If a thread can't be created, func runs on the calling thread
+// instead (where only programs nested far less deeply fit on the stack).
+void runWithCompileStack(const std::function<void()>& func)
+{
+	if (parse::StackThread::currentStackSize() >= compileStackSize)
+	{
+		func();
+		return;
+	}
+	
+	parse::StackThread thread(func, compileStackSize);
+	thread.join();
+}
+
+// Returns true if -s or -c was specified
+bool writesNative(const CompileOptions& options)
+{
+	return options.mAssembly || options.mObject;
+}
+
+// Returns the name of the bitcode file to write for this input.
+// If output file not specified (or it's used for the -s/-c output),
+// default is input file with the extension replaced with .bc
+std::string bitcodeFileName(const std::string& fileName, const CompileOptions& options)
+{
+	if (options.mOutputFile.empty() || writesNative(options))
+	{
+		return replaceExtension(fileName, ".bc");
+	}
+	return options.mOutputFile;
+}
+
+// Returns the name of the assembly/object file to write for this input.
+// Defaults to the input file with the extension replaced with .s or .o
+std::string nativeFileName(const std::string& fileName, const CompileOptions& options)
+{
+	if (options.mOutputFile.empty())
+	{
+		return replaceExtension(fileName, options.mAssembly ? ".s" : ".o");
+	}
+	return options.mOutputFile;
+}
+
+// Does the actual work for compileFile.
+// If onSource is set, it's called with the source text that was
+// compiled, once the file has parsed without errors.
+int runCompile(const std::string& fileName, const CompileOptions& options,
+			   std::ostream& output, std::ostream& errStream,
+			   opt::TimeReport* timeReport, opt::MemReport* memReport,
+			   const std::function<void(llvm::StringRef)>& onSource = nullptr) noexcept
+{
+	std::ostream* astStream = nullptr;
+	if (options.mPrintAST)
+	{
+		astStream = &output;
+	}
+
+	try
+	{
+		// Everything LLVM allocates for this file is freed along
+		// with the session, once we return
+		parse::Session session;
+		parse::Parser parser(fileName.c_str(), &errStream, astStream, timeReport,
+							 options.mLexThreads, options.mParseThreads);
+		if (memReport)
+		{
+			memReport->addPhase("Parsing and semantic analysis", nullptr);
+		}
+
+		if (!parser.IsValid())
+		{
+			errStream << parser.GetNumErrors() << " Error(s)" << std::endl;
+			return 1;
+		}
+		if (onSource)
+		{
+			onSource(parser.GetSourceText());
+		}
+
+		// If we set -a, we don't continue to later steps
+		if (options.mPrintAST && !options.mForceBitcode && !options.mPrintIR &&
+			!writesNative(options) && !options.mRun)
+		{
+			return 0;
+		}
+
+		// Unchanged functions can be reused from the function cache
+		std::unique_ptr<parse::FunctionCache> funcCache;
+		if (options.mIncremental)
+		{
+			funcCache.reset(new parse::FunctionCache(options.mCacheDir,
+													  options.mOptimize));
+		}
+		
+		// Now emit LLVM bitcode
+		std::unique_ptr<parse::Emitter> emit;
+		{
+			opt::PhaseTimer timer(timeReport, "IR emission");
+			emit.reset(new parse::Emitter(parser, session, funcCache.get()));
+		}
+		if (memReport)
+		{
+			memReport->addPhase("IR emission", session.getModule());
+		}
+
+		// Check if we should run optimization passes
+		if (options.mOptimize)
+		{
+			opt::PhaseTimer timer(timeReport, "Optimization");
+			emit->optimize(timeReport);
+		}
+		if (memReport && options.mOptimize)
+		{
+			memReport->addPhase("Optimization", session.getModule());
+		}
+		
+		if (funcCache)
+		{
+			std::string err;
+			bool linked;
+			{
+				opt::PhaseTimer timer(timeReport, "Function cache linking");
+				linked = emit->linkCached(err);
+			}
+			if (!linked)
+			{
+				errStream << "uscc: error: Unable to link cached functions: " << err << std::endl;
+				return 1;
+			}
+		}
+
+		// Print the human readable bitcode
+		if (options.mPrintIR)
+		{
+			opt::PhaseTimer timer(timeReport, "IR printing");
+			emit->print(output);
+		}
+
+		// Before we write anything, verify the IR doesn't have major errors
+		bool valid;
+		{
+			opt::PhaseTimer timer(timeReport, "Verification");
+			valid = emit->verify();
+		}
+		if (!valid)
+		{
+			errStream << std::endl;
+			errStream << "uscc: error: Emitted bad IR. Compilation halted." << std::endl;
+			return 1;
+		}
+
+		// Only IR that verified is cached, and it's stored before
+		// code generation gets a chance to change the module
+		if (funcCache)
+		{
+			opt::PhaseTimer timer(timeReport, "Function cache storing");
+			BitcodeCache cache(options.mCacheDir, options.mCacheMaxBytes);
+			cache.added(emit->storeCached());
+		}
+
+		// Write the assembly or object file
+		if (writesNative(options))
+		{
+			std::string nativeFile = nativeFileName(fileName, options);
+			std::string err;
+			bool written;
+			{
+				opt::PhaseTimer timer(timeReport, "Code generation");
+				written = emit->writeNative(nativeFile.c_str(), options.mAssembly,
+											options.mArch, options.mCPU, err);
+			}
+			if (!written)
+			{
+				errStream << "uscc: error: Unable to write " << nativeFile << ": " << err << std::endl;
+				return 1;
+			}
+			if (memReport)
+			{
+				memReport->addPhase("Code generation", session.getModule());
+			}
+		}
+
+		// Write the bitcode file
+		// (With --run, -s or -c, only if it was asked for with -b)
+		if ((!options.mRun && !writesNative(options)) || options.mForceBitcode)
+		{
+			std::string bcFile = bitcodeFileName(fileName, options);
+
+			{
+				opt::PhaseTimer timer(timeReport, "Bitcode writing");
+				emit->writeBitcode(bcFile.c_str());
+			}
+			if (memReport)
+			{
+				memReport->addPhase("Bitcode writing", session.getModule());
+			}
+		}
+
+		if (options.mRun)
+		{
+			std::vector<std::string> args;
+			args.push_back(fileName);
+			args.insert(args.end(), options.mRunArgs.begin(), options.mRunArgs.end());
+
+			// Anything we printed should come out before the program's output
+			output.flush();
+
+			int exitCode = 0;
+			std::string err;
+			bool ran;
+			{
+				opt::PhaseTimer timer(timeReport, "Execution");
+				ran = emit->run(args, exitCode, err);
+			}
+			if (!ran)
+			{
+				errStream << "uscc: error: Unable to run " << fileName << ": " << err << std::endl;
+				return 1;
+			}
+			return exitCode;
+		}
+	}
+	catch (parse::FileNotFound& fe)
+	{
+		errStream << "uscc: error: Input file " << fileName << " not found." << std::endl;
+		return 1;
+	}
+	catch (parse::ParseExcept& e)
+	{
+		errStream << "uscc: error: Critical error. Compilation halted." << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+
+// Compiles through the bitcode cache: on a hit, the bitcode and
+// printed output are taken from the cache instead of compiling
+int compileCached(const std::string& fileName, const CompileOptions& options,
+				  std::ostream& output, std::ostream& errStream) noexcept
+{
+	BitcodeCache cache(options.mCacheDir, options.mCacheMaxBytes);
+	std::string bcFile = bitcodeFileName(fileName, options);
+	
+	// Only flags that change the bitcode or the printed output
+	// are part of the key
+	std::ostringstream flags;
+	flags << "a=" << options.mPrintAST << " b=" << options.mForceBitcode
+		<< " p=" << options.mPrintIR << " O=" << options.mOptimize;
+	
+	std::string key;
+	std::string cachedOutput;
+	bool haveKey = cache.computeKey(fileName, flags.str(), key);
+	if (haveKey && cache.lookup(key, bcFile, cachedOutput))
+	{
+		output << cachedOutput;
+		return 0;
+	}
+	
+	// The file may have changed since the key was computed, so the
+	// entry is stored under the key of the text that was compiled
+	std::string compiledKey;
+	std::ostringstream compileOutput;
+	int retVal = runCompile(fileName, options, compileOutput, errStream,
+							nullptr, nullptr,
+							[&cache, &flags, &compiledKey](llvm::StringRef source)
+	{
+		compiledKey = cache.computeKey(source, flags.str());
+	});
+	output << compileOutput.str();
+	
+	// Errors aren't cached, so the output only needs to be
+	// captured for a compile that might be stored
+	if (!compiledKey.empty() && retVal == 0)
+	{
+		cache.store(compiledKey, bcFile, compileOutput.str());
+	}
+	return retVal;
+}
+
+// Does the work for compileFile, on the current thread
+int compileWithReports(const std::string& fileName, const CompileOptions& options,
+					   std::ostream& output, std::ostream& errStream) noexcept
+{
+	if (!options.mTimeReport && !options.mMemReport)
+	{
+		// With just -a there's no bitcode, so nothing worth caching,
+		// and --run has to actually compile the program.
+		// Only bitcode is cached, so -s and -c always compile.
+		bool writesBitcode = !options.mPrintAST || options.mForceBitcode ||
+			options.mPrintIR;
+		writesBitcode = writesBitcode && !options.mRun && !writesNative(options);
+		if (!options.mCacheDir.empty() && writesBitcode)
+		{
+			return compileCached(fileName, options, output, errStream);
+		}
+		
+		return runCompile(fileName, options, output, errStream, nullptr, nullptr);
+	}
+
+	// Reports cover whichever phases ran, even if the compile failed
+	opt::TimeReport timeReport(fileName);
+	opt::MemReport memReport(fileName);
+	if (options.mMemReport)
+	{
+		memReport.activate();
+	}
+
+	int retVal = runCompile(fileName, options, output, errStream,
+							options.mTimeReport ? &timeReport : nullptr,
+							options.mMemReport ? &memReport : nullptr);
+
+	if (options.mTimeReport)
+	{
+		if (options.mReportJSON)
+		{
+			timeReport.printJSON(errStream);
+		}
+		else
+		{
+			timeReport.printTable(errStream);
+		}
+	}
+
+	if (options.mMemReport)
+	{
+		if (options.mReportJSON)
+		{
+			memReport.printJSON(errStream);
+		}
+		else
+		{
+			memReport.printTable(errStream);
+		}
+	}
+	return retVal;
+}
+
+} // anonymous
+
+// Compiles a single input file.
+// Any AST or IR output requested by the options is written to output,
+// and all diagnostics (and reports) are written to errStream.
+// Returns the exit code for this file (0 on success).
+int compileFile(const std::string& fileName, const CompileOptions& options,
+				std::ostream& output, std::ostream& errStream) noexcept
+{
+	int retVal = 1;
+	runWithCompileStack([&]()
+	{
+		retVal = compileWithReports(fileName, options, output, errStream);
+	});
+	return retVal;
+}
+
+// Runs job(0) ... job(count - 1) on a pool of up to numThreads threads.
+// Returns once every job has finished.
+// If numThreads is 0, one thread per hardware thread is used.
+void runJobs(size_t count, unsigned numThreads,
+			 const std::function<void(size_t)>& job)
+{
+	if (numThreads == 0)
+	{
+		// hardware_concurrency is 0 if it can't tell
+		numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	if (numThreads > count)
+	{
+		numThreads = static_cast<unsigned>(count);
+	}
+
+	// Each worker grabs the next job that hasn't been started yet.
+	// Workers have a stack big enough to compile on, so compileFile
+	// doesn't need to start a thread of its own for each job
+	// (which is also why a single worker gets a thread).
+	std::atomic<size_t> nextJob(0);
+	std::vector<std::unique_ptr<parse::StackThread>> workers;
+	for (unsigned i = 0; i < numThreads; i++)
+	{
+		workers.emplace_back(new parse::StackThread([&nextJob, count, &job]()
+		{
+			size_t curr = nextJob++;
+			while (curr < count)
+			{
+				job(curr);
+				curr = nextJob++;
+			}
+		}, compileStackSize));
+	}
+
+	for (auto& t : workers)
+	{
+		t->join();
+	}
+}
+
+} // driver
+} // uscc
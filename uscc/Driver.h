@@ -0,0 +1,112 @@
+//
+//  Driver.h
+//  uscc
+//
+//  Declares the helpers the uscc driver uses to compile
+//  one or more input files.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <ostream>
+#include <functional>
+#include <vector>
+
+namespace uscc
+{
+namespace driver
+{
+
+// The command-line settings that affect how a single file is compiled
+struct CompileOptions
+{
+	CompileOptions()
+	: mPrintAST(false)
+	, mForceBitcode(false)
+	, mPrintIR(false)
+	, mOptimize(false)
+	, mAssembly(false)
+	, mObject(false)
+	, mTimeReport(false)
+	, mMemReport(false)
+	, mReportJSON(false)
+	, mIncremental(false)
+	, mRun(false)
+	, mLexThreads(0)
+	, mParseThreads(0)
+	, mCacheMaxBytes(0)
+	{ }
+
+	// -a
+	bool mPrintAST;
+	// -b
+	bool mForceBitcode;
+	// -p
+	bool mPrintIR;
+	// -O
+	bool mOptimize;
+	// -s
+	bool mAssembly;
+	// -c
+	bool mObject;
+	// -ftime-report
+	bool mTimeReport;
+	// --mem-report
+	bool mMemReport;
+	// --report-format json (otherwise reports are printed as a table)
+	bool mReportJSON;
+	// --incremental (reuse unchanged functions from the cache directory)
+	bool mIncremental;
+	// --run (JIT and run the program instead of writing bitcode)
+	bool mRun;
+	// --args (passed to the program after the input file name)
+	std::vector<std::string> mRunArgs;
+	// --lex-threads (0 for one per hardware thread)
+	unsigned mLexThreads;
+	// --parse-threads (0 for one per hardware thread)
+	unsigned mParseThreads;
+
+	// -o (empty if the output name should be derived from the input)
+	std::string mOutputFile;
+	// -march (empty for the host)
+	std::string mArch;
+	// -mcpu (empty for a generic CPU, or "native" for the host CPU)
+	std::string mCPU;
+	
+	// --cache-dir (empty if the cache is disabled)
+	std::string mCacheDir;
+	// --cache-size
+	uint64_t mCacheMaxBytes;
+};
+
+// Replaces the extension of the input file name with the requested one
+std::string replaceExtension(const std::string& fileName, const char* ext);
+
+// Compiles a single input file.
+// Any AST or IR output requested by the options is written to output,
+// and all diagnostics (and reports) are written to errStream.
+// Returns the exit code for this file (0 on success).
+// With --run, the exit code of the program is returned instead.
+//
+// This function does not touch any process-wide state, so it is safe
+// to call it concurrently for different files.
+int compileFile(const std::string& fileName, const CompileOptions& options,
+				std::ostream& output, std::ostream& errStream) noexcept;
+
+// Runs job(0) ... job(count - 1) on a pool of up to numThreads threads.
+// Returns once every job has finished.
+// If numThreads is 0, one thread per hardware thread is used.
+void runJobs(size_t count, unsigned numThreads,
+			 const std::function<void(size_t)>& job);
+
+} // driver
+} // uscc
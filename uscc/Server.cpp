@@ -0,0 +1,259 @@
+//
+//  Server.cpp
+//  uscc
+//
+//  Implements the compile server used by uscc --serve.
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#include "Server.h"
+#include <sstream>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <csignal>
+#endif
+
+namespace uscc
+{
+namespace driver
+{
+
+// Splits a job line into its arguments
+std::vector<std::string> splitJobLine(const std::string& line)
+{
+	std::vector<std::string> args;
+	std::string curr;
+	bool inArg = false;
+	bool inQuotes = false;
+
+	for (char c : line)
+	{
+		if (c == '"')
+		{
+			inQuotes = !inQuotes;
+			inArg = true;
+		}
+		else if (!inQuotes && (c == ' ' || c == '\t' || c == '\r'))
+		{
+			if (inArg)
+			{
+				args.push_back(curr);
+				curr.clear();
+				inArg = false;
+			}
+		}
+		else
+		{
+			curr += c;
+			inArg = true;
+		}
+	}
+
+	if (inArg)
+	{
+		args.push_back(curr);
+	}
+
+	return args;
+}
+
+// Reads jobs from input and writes the responses to output,
+// until either "quit" is read or input runs out
+void serveStream(std::istream& input, std::ostream& output, const ServerJob& job)
+{
+	std::string line;
+	while (std::getline(input, line))
+	{
+		std::vector<std::string> args = splitJobLine(line);
+		if (args.empty())
+		{
+			continue;
+		}
+
+		if (args.size() == 1 && args[0] == "quit")
+		{
+			break;
+		}
+
+		std::ostringstream jobOutput;
+		std::ostringstream jobErrors;
+		int status = job(args, jobOutput, jobErrors);
+
+		std::string outStr = jobOutput.str();
+		std::string errStr = jobErrors.str();
+		output << "@@output " << outStr.size() << "\n" << outStr;
+		output << "@@errors " << errStr.size() << "\n" << errStr;
+		output << "@@status " << status << "\n";
+		output.flush();
+	}
+}
+
+#ifndef _WIN32
+namespace
+{
+
+// Minimal streambuf over a connected socket, so a connection
+// can be served with the same code as stdin/stdout
+class SocketBuf : public std::streambuf
+{
+public:
+	SocketBuf(int fd)
+	: mFd(fd)
+	{
+		setg(mInBuf, mInBuf, mInBuf);
+		setp(mOutBuf, mOutBuf + sizeof(mOutBuf));
+	}
+
+	~SocketBuf()
+	{
+		sync();
+		close(mFd);
+	}
+
+protected:
+	virtual int_type underflow() override
+	{
+		ssize_t count;
+		do
+		{
+			count = read(mFd, mInBuf, sizeof(mInBuf));
+		}
+		while (count < 0 && errno == EINTR);
+
+		if (count <= 0)
+		{
+			return traits_type::eof();
+		}
+
+		setg(mInBuf, mInBuf, mInBuf + count);
+		return traits_type::to_int_type(*gptr());
+	}
+
+	virtual int_type overflow(int_type c) override
+	{
+		if (sync() != 0)
+		{
+			return traits_type::eof();
+		}
+
+		if (!traits_type::eq_int_type(c, traits_type::eof()))
+		{
+			*pptr() = traits_type::to_char_type(c);
+			pbump(1);
+		}
+		return traits_type::not_eof(c);
+	}
+
+	virtual int sync() override
+	{
+		const char* data = pbase();
+		while (data < pptr())
+		{
+			ssize_t count = write(mFd, data, static_cast<size_t>(pptr() - data));
+			if (count < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				return -1;
+			}
+			data += count;
+		}
+		setp(mOutBuf, mOutBuf + sizeof(mOutBuf));
+		return 0;
+	}
+
+private:
+	int mFd;
+	char mInBuf[4096];
+	char mOutBuf[4096];
+};
+
+} // anonymous
+#endif
+
+// Listens on a Unix domain socket at the requested path.
+// Each connection is served on its own thread with serveStream.
+// Only returns if the socket couldn't be set up (returning 1).
+int serveSocket(const std::string& path, const ServerJob& job,
+				std::ostream& errStream)
+{
+#ifdef _WIN32
+	errStream << "uscc: error: --socket is not supported on this platform." << std::endl;
+	return 1;
+#else
+	sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(addr.sun_path))
+	{
+		errStream << "uscc: error: Socket path " << path << " is too long." << std::endl;
+		return 1;
+	}
+	strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+	int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listenFd < 0)
+	{
+		errStream << "uscc: error: Unable to create socket: " << strerror(errno) << std::endl;
+		return 1;
+	}
+
+	// Remove a stale socket left behind by a previous server
+	unlink(path.c_str());
+	if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+		listen(listenFd, SOMAXCONN) != 0)
+	{
+		errStream << "uscc: error: Unable to listen on " << path << ": "
+			<< strerror(errno) << std::endl;
+		close(listenFd);
+		return 1;
+	}
+
+	// A client that disconnects mid-response shouldn't take the server down
+	signal(SIGPIPE, SIG_IGN);
+
+	while (true)
+	{
+		int clientFd = accept(listenFd, nullptr, nullptr);
+		if (clientFd < 0)
+		{
+			if (errno == EINTR || errno == ECONNABORTED)
+			{
+				continue;
+			}
+			errStream << "uscc: error: Unable to accept connection: "
+				<< strerror(errno) << std::endl;
+			close(listenFd);
+			unlink(path.c_str());
+			return 1;
+		}
+
+		// Jobs don't share any state, so connections can be served concurrently.
+		// The thread is detached, so it gets its own copy of job
+		std::thread([clientFd, job]()
+		{
+			SocketBuf buf(clientFd);
+			std::istream input(&buf);
+			std::ostream output(&buf);
+			serveStream(input, output, job);
+		}).detach();
+	}
+#endif
+}
+
+} // driver
+} // uscc
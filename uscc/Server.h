@@ -0,0 +1,67 @@
+//
+//  Server.h
+//  uscc
+//
+//  Declares the compile server used by uscc --serve.
+//
+//  The server reads one job per line. A job is a list of
+//  arguments, exactly as they would be passed to uscc on
+//  the command line (without the program name), such as:
+//
+//     -O -o out.bc quicksort.usc
+//
+//  Arguments are separated by whitespace, and may be wrapped
+//  in double quotes if they contain whitespace.
+//  The line "quit" ends the session (for a socket, just that
+//  connection; the listener keeps running).
+//
+//  For every job, the server responds with:
+//
+//     @@output <n>
+//     <n bytes of output (AST/IR)>
+//     @@errors <n>
+//     <n bytes of diagnostics>
+//     @@status <exit code>
+//
+//---------------------------------------------------------
+//  Copyright (c) 2014, Sanjay Madhav
+//  All rights reserved.
+//
+//  This file is distributed under the BSD license.
+//  See LICENSE.TXT for details.
+//---------------------------------------------------------
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <istream>
+#include <ostream>
+#include <functional>
+
+namespace uscc
+{
+namespace driver
+{
+
+// Runs a single job.
+// Output is written to output, diagnostics to errStream.
+// Returns the exit code for the job.
+typedef std::function<int(const std::vector<std::string>& args,
+						  std::ostream& output, std::ostream& errStream)> ServerJob;
+
+// Splits a job line into its arguments
+std::vector<std::string> splitJobLine(const std::string& line);
+
+// Reads jobs from input and writes the responses to output,
+// until either "quit" is read or input runs out
+void serveStream(std::istream& input, std::ostream& output, const ServerJob& job);
+
+// Listens on a Unix domain socket at the requested path.
+// Each connection is served on its own thread with serveStream.
+// Only returns if the socket couldn't be set up (returning 1).
+int serveSocket(const std::string& path, const ServerJob& job,
+				std::ostream& errStream);
+
+} // driver
+} // uscc
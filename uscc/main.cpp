@@ -14,10 +14,14 @@
 //  See LICENSE.TXT for details.
 //---------------------------------------------------------
 
-#include "../parse/Parse.h"
-#include "../parse/ParseExcept.h"
-#include "../parse/Emitter.h"
+#include "Driver.h"
+#include "Server.h"
+#include "Batch.h"
+#include "../opt/Passes.h"
+#include <fstream>
 #include <iostream>
+#include <sstream>
+#include <vector>
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wcast-qual"
 #pragma clang diagnostic push
@@ -29,12 +33,27 @@
 
 using namespace uscc;
 
-int main(int argc, const char * argv[])
+namespace
+{
+
+// Output captured from a single file when compiling several at once
+struct JobResult
+{
+	JobResult()
+	: mExitCode(0)
+	{ }
+	
+	std::string mOutput;
+	std::string mErrors;
+	int mExitCode;
+};
+
+// Adds every option uscc understands to the parser
+void addOptions(ez::ezOptionParser& opt)
 {
-	ez::ezOptionParser opt;
 	opt.doublespace = 1;
 	opt.overview = "University Simple C Compiler v0.5";
-	opt.syntax = "uscc [OPTIONS] <input>";
+	opt.syntax = "uscc [OPTIONS] <input> [<input> ...]";
 	
 	opt.add("", false, 0, 0,
 			"Display this message.",
@@ -55,156 +74,337 @@ int main(int argc, const char * argv[])
 	opt.add("", false, 0, 0,
 			"Enable optimization passes.",
 			"-O");
-	// Note: ASM generation disabled
-	/*opt.add("", false, 0, 0,
-			"Generate an x86 assembly file from the LLVM IR generated by uscc."
-			" No optimization is performed."
+	opt.add("", false, 0, 0,
+			"Generate an assembly file for the host from the LLVM IR generated by uscc,"
+			" instead of a bitcode file (unless -b is also specified). Optimization is only"
+			" performed if -O is specified."
 			"\n\nThis is provided for convenience in case LLVM developer tools (specifically llc)"
 			" are not installed. GCC or clang can turn this assembly file into an executable.",
-			"-s", "--assembly");*/
+			"-s", "--assembly");
+	opt.add("", false, 0, 0,
+			"Generate an object file for the host instead of a bitcode file (unless -b is also"
+			" specified). GCC or clang can link it into an executable.",
+			"-c", "--object");
+	opt.add("", false, 1, 0,
+			"With -s or -c, the architecture to generate code for, such as x86 or x86-64."
+			" Defaults to the host architecture.",
+			"-march");
 	opt.add("", false, 1, 0,
-			"Specify output file. This is ignored if -b and -s are specified simultaneously.",
+			"With -s or -c, the CPU to tune for and whose instructions can be used. \"native\""
+			" selects the host CPU. Defaults to a generic CPU for the architecture.",
+			"-mcpu");
+	opt.add("", false, 1, 0,
+			"Specify output file. With -s or -c, this names the assembly or object file, and"
+			" a bitcode file requested with -b gets the default name."
+			" Cannot be used with multiple input files.",
 			"-o", "--output");
+	opt.add("0", false, 1, 0,
+			"Number of input files to compile in parallel. Each input file is written to its own"
+			" output file. Defaults to the number of hardware threads.",
+			"-j", "--jobs");
+	opt.add("0", false, 1, 0,
+			"Maximum number of threads used to lex a large input file. Files are split at line"
+			" boundaries, and each chunk is lexed on its own thread. Defaults to the number of"
+			" hardware threads. Use 1 to always lex on a single thread.",
+			"--lex-threads");
+	opt.add("0", false, 1, 0,
+			"Maximum number of threads used to parse the function bodies of an input file with"
+			" many functions. Signatures are parsed first, then each body is parsed on its own"
+			" thread. Defaults to the number of hardware threads. Use 1 to always parse on a"
+			" single thread.",
+			"--parse-threads");
+	opt.add("", false, 0, 0,
+			"Report the wall and CPU time spent in each compilation phase, each optimization pass"
+			" and each function to stderr.",
+			"-ftime-report");
+	opt.add("", false, 0, 0,
+			"Report the live heap, peak RSS and the number of AST nodes, identifiers, scopes,"
+			" SSA maps and LLVM blocks/instructions after each compilation phase to stderr.",
+			"--mem-report");
+	opt.add("table", false, 1, 0,
+			"Format for reports requested with -ftime-report or --mem-report. Either \"table\" (the default)"
+			" or \"json\".",
+			"--report-format");
+	opt.add("", false, 1, 0,
+			"Cache compiled bitcode in this directory. An input compiled again with the same"
+			" source and flags is copied from the cache instead of being recompiled. The"
+			" directory can be shared by several uscc processes. Not used with -ftime-report"
+			" or --mem-report.",
+			"--cache-dir");
+	opt.add("256", false, 1, 0,
+			"Maximum size of the --cache-dir directory in megabytes. The least recently"
+			" used entries are removed once it grows past this. Defaults to 256.",
+			"--cache-size");
+	opt.add("", false, 0, 0,
+			"With --cache-dir, also cache the IR of each function. When a file changes, only the"
+			" functions that changed (or whose callees' signatures changed) are emitted and"
+			" optimized again, and the rest are linked in from the cache.",
+			"--incremental");
+	opt.add("", false, 0, 0,
+			"Compile the input and run its main function in-process with the JIT, instead of"
+			" writing a bitcode file (unless -b is also specified). uscc exits with the"
+			" program's exit code. Requires a single input file.",
+			"--run");
+	opt.add("", false, -1, ',',
+			"With --run, comma-separated arguments to pass to the program.",
+			"--args");
+	opt.add("", false, 0, 0,
+			"Run as a compile server. Each line read from stdin is a job, written as the"
+			" options and input files for a regular uscc invocation. The output, diagnostics"
+			" and exit code of each job are written to stdout. The line \"quit\" stops the server"
+			" (with --socket, it only closes that connection).",
+			"--serve");
+	opt.add("", false, 1, 0,
+			"With --serve, listen for jobs on the Unix domain socket at this path instead of stdin."
+			" Each connection is served concurrently, and the server runs until it's killed.",
+			"--socket");
+	opt.add("", false, 1, 0,
+			"Compile every job listed in this manifest file in one process. Each line is an input"
+			" file, an output file (or - for the default name) and any other options for that job."
+			" Up to -j jobs run at once. A job that fails doesn't stop the others, and a summary with"
+			" the time each job took is written to stderr (as JSON with --report-format json).",
+			"--batch");
+}
+
+// Compiles the input files specified by the already parsed options.
+// Returns the exit code.
+int compile(ez::ezOptionParser& opt, std::ostream& output, std::ostream& errStream)
+{
+	if (opt.lastArgs.size() < 1)
+	{
+		errStream << "uscc: error: No input file specified." << std::endl;
+		return 1;
+	}
+	if (opt.lastArgs.size() > 1 && opt.isSet("-o"))
+	{
+		errStream << "uscc: error: Cannot specify -o when compiling multiple input files." << std::endl;
+		return 1;
+	}
+	if (opt.lastArgs.size() > 1 && opt.isSet("--run"))
+	{
+		errStream << "uscc: error: Cannot specify --run when compiling multiple input files." << std::endl;
+		return 1;
+	}
+	if (opt.isSet("-s") && opt.isSet("-c"))
+	{
+		errStream << "uscc: error: Cannot specify both -s and -c." << std::endl;
+		return 1;
+	}
 	
-	opt.parse(argc, argv);
-	if (opt.isSet("-h"))
+	driver::CompileOptions options;
+	options.mPrintAST = opt.isSet("-a") != 0;
+	options.mForceBitcode = opt.isSet("-b") != 0;
+	options.mPrintIR = opt.isSet("-p") != 0;
+	options.mOptimize = opt.isSet("-O") != 0;
+	options.mAssembly = opt.isSet("-s") != 0;
+	options.mObject = opt.isSet("-c") != 0;
+	if (opt.isSet("-march"))
 	{
-		std::string usage;
-		opt.getUsage(usage);
-		std::cout << usage;
-		return 0;
+		opt.get("-march")->getString(options.mArch);
+	}
+	if (opt.isSet("-mcpu"))
+	{
+		opt.get("-mcpu")->getString(options.mCPU);
+	}
+	options.mTimeReport = opt.isSet("-ftime-report") != 0;
+	options.mMemReport = opt.isSet("--mem-report") != 0;
+	options.mRun = opt.isSet("--run") != 0;
+	if (opt.isSet("--args"))
+	{
+		opt.get("--args")->getStrings(options.mRunArgs);
 	}
 	
-	if (opt.lastArgs.size() < 1)
+	std::string reportFormat;
+	opt.get("--report-format")->getString(reportFormat);
+	if (reportFormat == "json")
 	{
-		std::cerr << "uscc: error: No input file specified." << std::endl;
+		options.mReportJSON = true;
+	}
+	else if (reportFormat != "table")
+	{
+		errStream << "uscc: error: Unknown report format " << reportFormat << "." << std::endl;
 		return 1;
 	}
-	if (opt.lastArgs.size() > 1)
+	if (opt.isSet("-o"))
+	{
+		opt.get("-o")->getString(options.mOutputFile);
+	}
+	
+	int lexThreads = 0;
+	opt.get("--lex-threads")->getInt(lexThreads);
+	if (lexThreads < 0)
 	{
-		std::cerr << "uscc: error: Only a single input file is supported." << std::endl;
+		errStream << "uscc: error: Invalid number of lex threads." << std::endl;
 		return 1;
 	}
+	options.mLexThreads = static_cast<unsigned>(lexThreads);
 	
-	const char* fileName = opt.lastArgs[0]->c_str();
-	std::ostream* astStream = nullptr;
-	if (opt.isSet("-a"))
+	int parseThreads = 0;
+	opt.get("--parse-threads")->getInt(parseThreads);
+	if (parseThreads < 0)
 	{
-		astStream = &std::cout;
+		errStream << "uscc: error: Invalid number of parse threads." << std::endl;
+		return 1;
 	}
+	options.mParseThreads = static_cast<unsigned>(parseThreads);
 	
-	try
+	if (opt.isSet("--cache-dir"))
 	{
-		parse::Parser parser(fileName, &std::cerr, astStream);
+		opt.get("--cache-dir")->getString(options.mCacheDir);
 		
-		if (!parser.IsValid())
+		int cacheSize = 0;
+		opt.get("--cache-size")->getInt(cacheSize);
+		if (cacheSize <= 0)
 		{
-			std::cerr << parser.GetNumErrors() << " Error(s)" << std::endl;
+			errStream << "uscc: error: Invalid cache size." << std::endl;
 			return 1;
 		}
-		
-		// If we set -a, we don't continue to later steps
-		if (opt.isSet("-a") &&
-			!opt.isSet("-b") && !opt.isSet("-s") && !opt.isSet("-p"))
-		{
-			return 0;
-		}
-		
-		// Now emit LLVM bitcode
-		parse::Emitter emit(parser);
-		
-		// Check if we should run optimization passes
-		if (opt.isSet("-O"))
+		options.mCacheMaxBytes = static_cast<uint64_t>(cacheSize) * 1024 * 1024;
+		options.mIncremental = opt.isSet("--incremental") != 0;
+	}
+	else if (opt.isSet("--incremental"))
+	{
+		errStream << "uscc: error: --incremental requires --cache-dir." << std::endl;
+		return 1;
+	}
+	
+	std::vector<std::string> fileNames;
+	for (auto arg : opt.lastArgs)
+	{
+		fileNames.push_back(*arg);
+	}
+	
+	// A single file can write straight to the output streams
+	if (fileNames.size() == 1)
+	{
+		return driver::compileFile(fileNames[0], options, output, errStream);
+	}
+	
+	int numJobs = 0;
+	opt.get("-j")->getInt(numJobs);
+	if (numJobs < 0)
+	{
+		errStream << "uscc: error: Invalid number of jobs." << std::endl;
+		return 1;
+	}
+	
+	// Each file gets its own Parser/Emitter, and buffers its output so
+	// we can write it out in the order the files were specified
+	std::vector<JobResult> results(fileNames.size());
+	driver::runJobs(fileNames.size(), static_cast<unsigned>(numJobs),
+					[&fileNames, &options, &results](size_t i)
+	{
+		std::ostringstream jobOutput;
+		std::ostringstream jobErrors;
+		results[i].mExitCode = driver::compileFile(fileNames[i], options,
+												   jobOutput, jobErrors);
+		results[i].mOutput = jobOutput.str();
+		results[i].mErrors = jobErrors.str();
+	});
+	
+	int retVal = 0;
+	for (auto& result : results)
+	{
+		output << result.mOutput;
+		errStream << result.mErrors;
+		if (result.mExitCode != 0)
 		{
-			emit.optimize();
+			retVal = 1;
 		}
+	}
+	
+	return retVal;
+}
+
+// Runs a single job sent to the compile server, or listed in a batch manifest
+int serverJob(const std::vector<std::string>& args,
+			  std::ostream& output, std::ostream& errStream)
+{
+	std::vector<const char*> argv;
+	argv.push_back("uscc");
+	for (auto& arg : args)
+	{
+		argv.push_back(arg.c_str());
+	}
+	
+	ez::ezOptionParser opt;
+	addOptions(opt);
+	opt.parse(static_cast<int>(argv.size()), argv.data());
+	// A program run by the server would write straight to our stdout
+	if (opt.isSet("-h") || opt.isSet("--serve") || opt.isSet("--socket") ||
+		opt.isSet("--run") || opt.isSet("--batch"))
+	{
+		errStream << "uscc: error: Option not supported by the compile server or in a batch." << std::endl;
+		return 1;
+	}
+	
+	return compile(opt, output, errStream);
+}
+
+} // anonymous
+
+int main(int argc, const char * argv[])
+{
+	ez::ezOptionParser opt;
+	addOptions(opt);
+	
+	opt.parse(argc, argv);
+	if (opt.isSet("-h"))
+	{
+		std::string usage;
+		opt.getUsage(usage);
+		std::cout << usage;
+		return 0;
+	}
+	
+	if (opt.isSet("--serve"))
+	{
+		// Pay for the pass registry once, rather than per job
+		uscc::opt::initializeOptPasses();
 		
-		bool shouldEmitBC = true;
-		if (opt.isSet("-s") && !opt.isSet("-b"))
+		if (opt.isSet("--socket"))
 		{
-			shouldEmitBC = false;
+			std::string socketPath;
+			opt.get("--socket")->getString(socketPath);
+			return driver::serveSocket(socketPath, serverJob, std::cerr);
 		}
 		
-		// Print the human readable bitcode to stdout
-		if (opt.isSet("-p"))
+		driver::serveStream(std::cin, std::cout, serverJob);
+		return 0;
+	}
+	
+	if (opt.isSet("--batch"))
+	{
+		std::string manifestName;
+		opt.get("--batch")->getString(manifestName);
+		std::ifstream manifest(manifestName);
+		if (!manifest)
 		{
-			emit.print();
+			std::cerr << "uscc: error: Batch manifest " << manifestName << " not found." << std::endl;
+			return 1;
 		}
 		
-		// Before we write anything, verify the IR doesn't have major errors
-		if (!emit.verify())
+		int numJobs = 0;
+		opt.get("-j")->getInt(numJobs);
+		if (numJobs < 0)
 		{
-			std::cerr << std::endl;
-			std::cerr << "uscc: error: Emitted bad IR. Compilation halted." << std::endl;
+			std::cerr << "uscc: error: Invalid number of jobs." << std::endl;
 			return 1;
 		}
 		
-		// Write the bitcode file
-		if (shouldEmitBC)
+		std::string reportFormat;
+		opt.get("--report-format")->getString(reportFormat);
+		if (reportFormat != "json" && reportFormat != "table")
 		{
-			std::string bcFile;
-			// If output file not specified, default is
-			// input file with the extension replaced with .bc
-			if (!opt.isSet("-o") || opt.isSet("-s"))
-			{
-				bcFile = fileName;
-				size_t extLoc = bcFile.find_last_of(".");
-				if (extLoc != std::string::npos)
-				{
-					// Strip the last extension
-					bcFile = bcFile.substr(0, extLoc);
-				}
-				bcFile += ".bc";
-			}
-			else
-			{
-				ez::OptionGroup* params = opt.get("-o");
-				params->getString(bcFile);
-			}
-			
-			emit.writeBitcode(bcFile.c_str());
+			std::cerr << "uscc: error: Unknown report format " << reportFormat << "." << std::endl;
+			return 1;
 		}
 		
-		// Functionality removed because it doesn't work with LLVM 3.5.0
-		// Write the assembly file
-		/*if (opt.isSet("-s"))
-		{
-			std::string asmFile;
-			// If output file not specified, default is
-			// input file with the extension replaced with .bc
-			if (!opt.isSet("-o") || opt.isSet("-b"))
-			{
-				asmFile = fileName;
-				size_t extLoc = asmFile.find_last_of(".");
-				if (extLoc != std::string::npos)
-				{
-					// Strip the last extension
-					asmFile = asmFile.substr(0, extLoc);
-				}
-				asmFile += ".s";
-			}
-			else
-			{
-				ez::OptionGroup* params = opt.get("-o");
-				params->getString(asmFile);
-			}
-			
-			if (!emit.writeAsm(asmFile.c_str()))
-			{
-				std::cerr << "uscc: error: Unable to emit assembly. Compilation halted." << std::endl;
-			}
-		}*/
-	}
-	catch (parse::FileNotFound& fe)
-	{
-		std::cerr << "uscc: error: Input file " << fileName << " not found." << std::endl;
-	}
-	catch (parse::ParseExcept& e)
-	{
-		std::cerr << "uscc: error: Critical error. Compilation halted." << std::endl;
-		return 1;
+		// Like the server, every job shares one pass registry
+		uscc::opt::initializeOptPasses();
+		return driver::runBatch(manifest, manifestName, static_cast<unsigned>(numJobs),
+								reportFormat == "json", serverJob, std::cout, std::cerr);
 	}
 	
-	return 0;
+	return compile(opt, std::cout, std::cerr);
 }
-